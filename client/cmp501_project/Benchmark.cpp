@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "Benchmark.h"
+#include "Global.h"
+#include "History.h"
+#include "Ball.h"
+#include "Predictor.h"
+
+// History kept the way Paddle and Ball did before History: shift out the oldest entry and sort on every add.
+// Kept here as the benchmark baseline
+class VectorHistory
+{
+public:
+	VectorHistory(int maxMessages)
+		: maxMessages(maxMessages)
+	{
+	}
+
+	void Add(const Message& msg)
+	{
+		int numMessages = messages.size();
+		if (numMessages == maxMessages)
+		{
+			std::move(messages.begin() + 1, messages.end(), messages.begin());
+			messages[numMessages - 1] = msg;
+		}
+		else
+		{
+			messages.push_back(msg);
+		}
+
+		std::sort(messages.begin(), messages.end(), compareByTimestamp);
+	}
+
+	const Message& Newest(int i = 0) const { return messages[messages.size() - 1 - i]; }
+	int Size() const { return messages.size(); }
+
+private:
+	std::vector<Message> messages;
+	int maxMessages;
+};
+
+// The adds a frame makes to the histories of one paddle and the ball: a received message for each,
+// two predictions for each and two ball positions. One message in eight arrives late, out of order
+template <typename H>
+static double RunHistoryFrames(std::vector<H>& histories, int frameCount, float& checksum)
+{
+	Message msg;
+	msg.ball = true;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		double time = frame / 60.0;
+		msg.x = static_cast<float>(frame % WINDOW_WIDTH);
+		msg.y = static_cast<float>(frame % WINDOW_HEIGHT);
+
+		for (int h = 0; h < 5; h++)
+		{
+			int adds = (h == 0 || h == 2) ? 1 : 2; // paddle and ball messages are added once a frame
+			for (int i = 0; i < adds; i++)
+			{
+				msg.timestamp = (frame % 8 == 7 && i == 0) ? time - 0.05 : time + i * 0.001;
+				histories[h].Add(msg);
+			}
+
+			if (histories[h].Size() >= 2)
+			{
+				checksum += histories[h].Newest().y - histories[h].Newest(1).y;
+			}
+		}
+	}
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / frameCount;
+}
+
+template <int Depth>
+static void RunHistoryBenchmarkAtDepth(int frameCount)
+{
+	float checksum = 0.0f;
+
+	std::vector<VectorHistory> vectors(5, VectorHistory(Depth));
+	double vectorNs = RunHistoryFrames(vectors, frameCount, checksum);
+
+	std::vector<History<Message, Depth>> rings(5);
+	double ringNs = RunHistoryFrames(rings, frameCount, checksum);
+
+	std::cout << "\tDepth " << Depth << ": " << vectorNs << " ns per frame with std::vector and std::sort, "
+		<< ringNs << " ns per frame with History (checksum " << checksum << ")" << std::endl;
+}
+
+// Add frameCount frames of messages, predictions and positions to the five prediction histories, as the client does,
+// and report the cost per frame of the old sorted std::vector histories against History at several depths
+void RunHistoryBenchmark(int frameCount)
+{
+	std::cout << "History benchmark: " << frameCount << " frames, 8 adds per frame across 5 histories" << std::endl;
+	RunHistoryBenchmarkAtDepth<PREDICTION_HISTORY_SIZE>(frameCount);
+	RunHistoryBenchmarkAtDepth<8>(frameCount);
+	RunHistoryBenchmarkAtDepth<32>(frameCount);
+}
+
+static volatile float benchSink; // keeps timed results from being optimized away
+
+const double BENCH_SEND_INTERVAL = 1.0 / 60.0; // seconds between snapshots from the server
+const double BENCH_FRAME_INTERVAL = 1.0 / 144.0; // seconds between client frames
+const double BENCH_LATENCY = 0.05; // one way latency in seconds
+const double BENCH_JITTER = 0.02; // extra latency of up to this many seconds on each snapshot
+
+// Fold a position moving freely along a line back into [0, size], as if it bounced off both ends
+static double Bounce(double position, double size)
+{
+	double folded = std::fmod(std::fabs(position), 2.0 * size);
+	return folded > size ? 2.0 * size - folded : folded;
+}
+
+// Feed sampleCount snapshots of an opponent paddle and of the ball, received with latency and jitter, to a predictor
+// every client frame, and return the nanoseconds per prediction. error is set to the mean distance between the
+// prediction and where the entity really was one average latency ago, which is what the prediction is aiming for
+static double RunPredictorSamples(const Predictor& predictor, const std::vector<Message>& received,
+	const std::vector<Vec2>& truth, double& error)
+{
+	PredictionHistory history;
+	std::size_t next = 0;
+	int predictions = 0;
+	double totalError = 0.0;
+	double end = received.back().timestamp;
+
+	for (double time = received.front().timestamp; time < end; time += BENCH_FRAME_INTERVAL)
+	{
+		while (next < received.size() && received[next].timestamp <= time)
+		{
+			history.Add(received[next]);
+			next++;
+		}
+
+		Vec2 predicted;
+		if (!predictor.Predict(history, time, predicted))
+		{
+			continue;
+		}
+
+		// Truth is sampled every millisecond
+		int target = static_cast<int>((time - BENCH_LATENCY - BENCH_JITTER / 2.0) * 1000.0);
+		if (target < 0 || target >= static_cast<int>(truth.size()))
+		{
+			continue;
+		}
+
+		double dx = predicted.x - truth[target].x;
+		double dy = predicted.y - truth[target].y;
+		totalError += std::sqrt(dx * dx + dy * dy);
+		predictions++;
+	}
+
+	error = predictions > 0 ? totalError / predictions : 0.0;
+
+	// Time the same number of predictions from the full history separately, so the cost is not lost among the clock reads
+	float checksum = 0.0f;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < predictions; i++)
+	{
+		Vec2 predicted;
+		predictor.Predict(history, end + i * BENCH_FRAME_INTERVAL, predicted);
+		checksum += predicted.y;
+	}
+	std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+	benchSink = checksum;
+	return predictions > 0 ? std::chrono::duration<double, std::nano>(stop - start).count() / predictions : 0.0;
+}
+
+static void RunPredictorsOn(const char* entity, const std::vector<Message>& received, const std::vector<Vec2>& truth)
+{
+	const PredictorType types[] = { PredictorType::Linear, PredictorType::ConstantAcceleration, PredictorType::AlphaBeta, PredictorType::Kalman };
+	const int depths[] = { 2, 4, 8, 16 };
+
+	std::cout << "\t" << entity << ":" << std::endl;
+	for (PredictorType type : types)
+	{
+		for (int depth : depths)
+		{
+			std::unique_ptr<Predictor> predictor = CreatePredictor(type, depth);
+			double error = 0.0;
+			double ns = RunPredictorSamples(*predictor, received, truth, error);
+			std::cout << "\t\t" << PredictorName(type) << " depth " << depth << ": " << ns << " ns per prediction, "
+				<< error << " pixels mean error" << std::endl;
+		}
+	}
+}
+
+// Compare the cost per prediction and the prediction error of every predictor at several depths, on an opponent
+// paddle that changes direction at random and on a ball bouncing around the field, both sent at 60 snapshots
+// per second with 50 ms of latency and up to 20 ms of jitter and predicted at 144 frames per second
+void RunPredictorBenchmark(int sampleCount)
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<double> jitter(0.0, BENCH_JITTER);
+	std::uniform_real_distribution<double> holdTime(0.2, 0.8);
+	std::uniform_int_distribution<int> direction(-1, 1);
+
+	// True positions every millisecond
+	int milliseconds = static_cast<int>(sampleCount * BENCH_SEND_INTERVAL * 1000.0) + 1;
+	std::vector<Vec2> paddleTruth(milliseconds);
+	std::vector<Vec2> ballTruth(milliseconds);
+	float paddleY = (WINDOW_HEIGHT - PADDLE_HEIGHT) / 2.0f;
+	float paddleSpeed = 0.0f;
+	double nextTurn = 0.0;
+	for (int ms = 0; ms < milliseconds; ms++)
+	{
+		if (ms / 1000.0 >= nextTurn)
+		{
+			paddleSpeed = PADDLE_SPEED * direction(random);
+			nextTurn += holdTime(random);
+		}
+
+		paddleY = std::min(std::max(paddleY + paddleSpeed, 0.0f), static_cast<float>(WINDOW_HEIGHT - PADDLE_HEIGHT));
+		paddleTruth[ms] = Vec2(WINDOW_WIDTH - 50.0f, paddleY);
+		ballTruth[ms] = Vec2(
+			static_cast<float>(Bounce(WINDOW_WIDTH / 2.0 + BALL_SPEED * ms, WINDOW_WIDTH - BALL_WIDTH)),
+			static_cast<float>(Bounce(WINDOW_HEIGHT / 2.0 + 0.7 * BALL_SPEED * ms, WINDOW_HEIGHT - BALL_HEIGHT))
+		);
+	}
+
+	// Snapshots as the client receives them: quantized like the protocol, and timestamped to the millisecond on arrival
+	std::vector<Message> paddleReceived(sampleCount);
+	std::vector<Message> ballReceived(sampleCount);
+	for (int i = 0; i < sampleCount; i++)
+	{
+		int sent = static_cast<int>(i * BENCH_SEND_INTERVAL * 1000.0);
+		double arrival = std::floor((i * BENCH_SEND_INTERVAL + BENCH_LATENCY + jitter(random)) * 1000.0) / 1000.0;
+
+		paddleReceived[i].timestamp = arrival;
+		paddleReceived[i].x = paddleTruth[sent].x;
+		paddleReceived[i].y = std::round(paddleTruth[sent].y * 16.0f) / 16.0f;
+
+		ballReceived[i].timestamp = arrival;
+		ballReceived[i].x = std::round(ballTruth[sent].x * 16.0f) / 16.0f;
+		ballReceived[i].y = std::round(ballTruth[sent].y * 16.0f) / 16.0f;
+	}
+
+	// Messages are handed over in arrival order
+	std::stable_sort(paddleReceived.begin(), paddleReceived.end(), compareByTimestamp);
+	std::stable_sort(ballReceived.begin(), ballReceived.end(), compareByTimestamp);
+
+	std::cout << "Predictor benchmark: " << sampleCount << " snapshots at 60 per second, " << BENCH_LATENCY * 1000.0
+		<< " ms latency with up to " << BENCH_JITTER * 1000.0 << " ms jitter, predicted at 144 frames per second" << std::endl;
+	RunPredictorsOn("Opponent paddle", paddleReceived, paddleTruth);
+	RunPredictorsOn("Ball", ballReceived, ballTruth);
+}
\ No newline at end of file
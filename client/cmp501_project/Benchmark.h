@@ -0,0 +1,4 @@
+#pragma once
+
+void RunHistoryBenchmark(int frameCount);
+void RunPredictorBenchmark(int sampleCount);
\ No newline at end of file
@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cmath>
+#include "ClockSync.h"
+
+bool ClockSync::ShouldSend(double now) const
+{
+	return !requestSent || now - lastRequestTime >= (Synchronized() ? CLOCK_SYNC_INTERVAL : CLOCK_SYNC_FAST_INTERVAL);
+}
+
+void ClockSync::WriteRequest(sf::Packet& packet, uint64_t sessionId, double now)
+{
+	WriteClockRequest(packet, sessionId, static_cast<uint32_t>(static_cast<uint64_t>(now)));
+	lastRequestTime = now;
+	requestSent = true;
+}
+
+void ClockSync::AddResponse(const ClockExchange& exchange, double now)
+{
+	// Only the low 32 bits of the request time come back, so count back from now to find it
+	double sent = now - static_cast<uint32_t>(static_cast<uint32_t>(static_cast<uint64_t>(now)) - exchange.clientSendTime);
+	double received = static_cast<double>(exchange.serverReceiveTime);
+	double replied = static_cast<double>(exchange.serverSendTime);
+
+	// A response to a request from long ago says nothing useful about the clock now
+	if (now - sent > CLOCK_SYNC_INTERVAL)
+	{
+		return;
+	}
+
+	Sample sample;
+	sample.timestamp = now;
+	sample.roundTrip = std::max((now - sent) - (replied - received), 0.0);
+	sample.offset = ((received - sent) + (replied - now)) / 2.0;
+	samples.Add(sample);
+
+	Estimate();
+}
+
+// Fit the offset to the samples, weighting each by how close its round trip is to the shortest. A sample held up
+// by d milliseconds more than the shortest may be off by up to d / 2, so it counts for 1 / (1 + d)^2 as much
+void ClockSync::Estimate()
+{
+	int count = samples.Size();
+	double shortest = samples[0].roundTrip;
+	for (int i = 1; i < count; i++)
+	{
+		shortest = std::min(shortest, samples[i].roundTrip);
+	}
+
+	referenceTime = samples.Newest().timestamp;
+	roundTrip = shortest;
+
+	double totalWeight = 0.0;
+	double meanTime = 0.0;
+	double meanOffset = 0.0;
+	for (int i = 0; i < count; i++)
+	{
+		double delay = 1.0 + samples[i].roundTrip - shortest;
+		double weight = 1.0 / (delay * delay);
+		totalWeight += weight;
+		meanTime += weight * (samples[i].timestamp - referenceTime);
+		meanOffset += weight * samples[i].offset;
+	}
+	meanTime /= totalWeight;
+	meanOffset /= totalWeight;
+
+	// Too short a span of samples to tell drift from noise, so just average them
+	drift = 0.0;
+	offset = meanOffset;
+	if (referenceTime - samples[0].timestamp < CLOCK_DRIFT_MIN_SPAN)
+	{
+		return;
+	}
+
+	double sumTT = 0.0;
+	double sumTO = 0.0;
+	for (int i = 0; i < count; i++)
+	{
+		double delay = 1.0 + samples[i].roundTrip - shortest;
+		double weight = 1.0 / (delay * delay);
+		double t = samples[i].timestamp - referenceTime - meanTime;
+		sumTT += weight * t * t;
+		sumTO += weight * t * (samples[i].offset - meanOffset);
+	}
+
+	if (sumTT > 0.0)
+	{
+		drift = std::min(std::max(sumTO / sumTT, -CLOCK_MAX_DRIFT), CLOCK_MAX_DRIFT);
+		offset = meanOffset - drift * meanTime;
+	}
+}
+
+double ClockSync::ToServerTime(double localTime) const
+{
+	return localTime + offset + drift * (localTime - referenceTime);
+}
+
+double ClockSync::ToLocalTime(double serverTime) const
+{
+	return (serverTime - offset + drift * referenceTime) / (1.0 + drift);
+}
+
+double ClockSync::UnwrapServerTime(uint16_t serverTime, double now) const
+{
+	int64_t expected = static_cast<int64_t>(std::llround(ToServerTime(now)));
+	return static_cast<double>(expected + static_cast<int16_t>(serverTime - static_cast<uint16_t>(expected)));
+}
+
+void ClockSync::Clear()
+{
+	samples.Clear();
+	lastRequestTime = 0.0;
+	requestSent = false;
+	referenceTime = 0.0;
+	offset = 0.0;
+	drift = 0.0;
+	roundTrip = 0.0;
+}
\ No newline at end of file
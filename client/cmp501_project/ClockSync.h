@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include "History.h"
+#include "Protocol.h"
+
+const int CLOCK_SAMPLE_COUNT = 16; // newest clock exchanges kept to estimate offset and drift from
+const int CLOCK_SYNC_MIN_SAMPLES = 4; // exchanges before the clock counts as synchronized
+const double CLOCK_SYNC_FAST_INTERVAL = 250.0; // milliseconds between requests until synchronized
+const double CLOCK_SYNC_INTERVAL = 2000.0; // milliseconds between requests once synchronized
+const double CLOCK_DRIFT_MIN_SPAN = 10000.0; // milliseconds of samples needed before drift is estimated
+const double CLOCK_MAX_DRIFT = 0.001; // largest drift believed, 1000 parts per million
+
+// Estimates the server clock from NTP style exchanges with the server
+// Each exchange gives the offset of the server clock from this client's and a round trip time, and the
+// offset is only as good as half of that round trip. So the offset is taken from the exchanges with the
+// shortest round trips, which were least held up on the way, and a line is fitted through them over time
+// to follow the drift between the two clocks. A request every couple of seconds is enough to keep it up
+class ClockSync
+{
+public:
+	// True when a request is due at now (milliseconds of this client's clock)
+	bool ShouldSend(double now) const;
+	void WriteRequest(sf::Packet& packet, uint64_t sessionId, double now);
+	void AddResponse(const ClockExchange& exchange, double now);
+
+	bool Synchronized() const { return samples.Size() >= CLOCK_SYNC_MIN_SAMPLES; }
+
+	// Convert between this client's clock and the server's, both in milliseconds
+	double ToServerTime(double localTime) const;
+	double ToLocalTime(double serverTime) const;
+
+	// Full server time of a time sent as its low 16 bits, taken as the one nearest the server time at now
+	double UnwrapServerTime(uint16_t serverTime, double now) const;
+
+	double Offset() const { return offset; } // server time less client time at referenceTime
+	double Drift() const { return drift; } // milliseconds the offset changes by per millisecond
+	double RoundTripTime() const { return roundTrip; } // shortest round trip kept
+
+	void Clear();
+
+private:
+	struct Sample
+	{
+		double timestamp = 0.0; // client time the response arrived
+		double offset = 0.0;
+		double roundTrip = 0.0;
+	};
+
+	void Estimate();
+
+	History<Sample, CLOCK_SAMPLE_COUNT> samples;
+	double lastRequestTime = 0.0;
+	bool requestSent = false;
+	double referenceTime = 0.0;
+	double offset = 0.0;
+	double drift = 0.0;
+	double roundTrip = 0.0;
+};
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <limits>
+#include "Collision.h"
+
+// Times the moving box starts and stops overlapping the obstacle along one axis, as fractions of the move
+template <typename T>
+static bool SweepAxis(T position, T size, T move, T obstacle, T obstacleSize, T& entry, T& exit)
+{
+	if (move > T(0))
+	{
+		entry = (obstacle - (position + size)) / move;
+		exit = (obstacle + obstacleSize - position) / move;
+	}
+	else if (move < T(0))
+	{
+		entry = (obstacle + obstacleSize - position) / move;
+		exit = (obstacle - (position + size)) / move;
+	}
+	else
+	{
+		// Still along this axis, so it overlaps for the whole move or not at all
+		if (position + size <= obstacle || position >= obstacle + obstacleSize)
+		{
+			return false;
+		}
+
+		entry = std::numeric_limits<T>::lowest();
+		exit = std::numeric_limits<T>::max();
+	}
+
+	return true;
+}
+
+template <typename T>
+bool SweepBox(const Vector2<T>& position, const Vector2<T>& size, const Vector2<T>& move, const Vector2<T>& obstacle,
+	const Vector2<T>& obstacleSize, BasicSweepHit<T>& hit)
+{
+	// Already overlapping, as when a paddle moves onto the ball: a hit straight away, on the side the box is least far
+	// into, so it is pushed out the shortest way. Ties go to the left and right sides, the faces of a paddle
+	T intoLeft = position.x + size.x - obstacle.x;
+	T intoRight = obstacle.x + obstacleSize.x - position.x;
+	T intoTop = position.y + size.y - obstacle.y;
+	T intoBottom = obstacle.y + obstacleSize.y - position.y;
+	if (intoLeft > T(0) && intoRight > T(0) && intoTop > T(0) && intoBottom > T(0))
+	{
+		T depthX = std::min(intoLeft, intoRight);
+		T depthY = std::min(intoTop, intoBottom);
+		hit.time = T(0);
+		if (depthX <= depthY)
+		{
+			hit.normal = Vector2<T>(intoLeft <= intoRight ? T(-1) : T(1), T(0));
+		}
+		else
+		{
+			hit.normal = Vector2<T>(T(0), intoTop <= intoBottom ? T(-1) : T(1));
+		}
+
+		return true;
+	}
+
+	T entryX, exitX, entryY, exitY;
+	if (!SweepAxis(position.x, size.x, move.x, obstacle.x, obstacleSize.x, entryX, exitX)
+		|| !SweepAxis(position.y, size.y, move.y, obstacle.y, obstacleSize.y, entryY, exitY))
+	{
+		return false;
+	}
+
+	// The boxes touch once they overlap on both axes
+	T entry = std::max(entryX, entryY);
+	T exit = std::min(exitX, exitY);
+	if (entry >= exit || entry < T(0) || entry > T(1))
+	{
+		return false;
+	}
+
+	hit.time = entry;
+	if (entryX > entryY)
+	{
+		hit.normal = Vector2<T>(move.x > T(0) ? T(-1) : T(1), T(0));
+	}
+	else
+	{
+		hit.normal = Vector2<T>(T(0), move.y > T(0) ? T(-1) : T(1));
+	}
+
+	return true;
+}
+
+// Fraction of move it takes to go from position to plane, or more than 1 if it is not reached. A position already
+// past the plane reaches it straight away
+template <typename T>
+static T TimeToPlane(T position, T move, T plane)
+{
+	if ((move < T(0) && position <= plane) || (move > T(0) && position >= plane))
+	{
+		return T(0);
+	}
+
+	return move != T(0) ? (plane - position) / move : T(2);
+}
+
+// Bounce the ball back off the face of a paddle, using the thirds of the paddle for its new vertical speed
+template <typename T>
+static void BounceOffPaddle(const Vector2<T>& position, Vector2<T>& velocity, const Vector2<T>& paddle)
+{
+	velocity.x = -velocity.x;
+
+	T ballBottom = position.y + T(BALL_HEIGHT);
+	T paddleBottom = paddle.y + T(PADDLE_HEIGHT);
+	T paddleRangeUpper = paddleBottom - (T(2 * PADDLE_HEIGHT) / T(3));
+	T paddleRangeMiddle = paddleBottom - (T(PADDLE_HEIGHT) / T(3));
+
+	if ((ballBottom > paddle.y)
+		&& (ballBottom < paddleRangeUpper))
+	{
+		velocity.y = -T(0.75f * BALL_SPEED);
+	}
+	else if ((ballBottom > paddleRangeUpper)
+		&& (ballBottom < paddleRangeMiddle))
+	{
+		// Middle third keeps the vertical speed
+	}
+	else
+	{
+		velocity.y = T(0.75f * BALL_SPEED);
+	}
+}
+
+template <typename T>
+BallMove MoveBall(Vector2<T>& position, Vector2<T>& velocity, T dt, const Vector2<T>& paddleOne, const Vector2<T>& paddleTwo)
+{
+	enum class Contact { None, Wall, PaddleOne, PaddleTwo, Left, Right };
+
+	const Vector2<T> ballSize{ T(BALL_WIDTH), T(BALL_HEIGHT) };
+	const Vector2<T> paddleSize{ T(PADDLE_WIDTH), T(PADDLE_HEIGHT) };
+	const T bottomWall(WINDOW_HEIGHT - BALL_HEIGHT);
+	const T rightEdge(WINDOW_WIDTH - BALL_WIDTH);
+
+	BallMove result;
+	T remaining = dt;
+
+	while (remaining > T(0) && result.bounces < MAX_BALL_BOUNCES)
+	{
+		Vector2<T> move(velocity.x * remaining, velocity.y * remaining);
+		Contact contact = Contact::None;
+		T time(1);
+		BasicSweepHit<T> paddleHit;
+
+		// The wall and edge ahead of the ball
+		T wallTime = velocity.y < T(0) ? TimeToPlane(position.y, move.y, T(0))
+			: (velocity.y > T(0) ? TimeToPlane(position.y, move.y, bottomWall) : T(2));
+		if (wallTime <= time)
+		{
+			contact = Contact::Wall;
+			time = wallTime;
+		}
+
+		T edgeTime = velocity.x < T(0) ? TimeToPlane(position.x, move.x, T(0))
+			: (velocity.x > T(0) ? TimeToPlane(position.x, move.x, rightEdge) : T(2));
+		if (edgeTime <= time)
+		{
+			contact = velocity.x < T(0) ? Contact::Left : Contact::Right;
+			time = edgeTime;
+		}
+
+		// Paddles are checked last so that they win ties, as the ball touching a paddle at the edge is still returned
+		BasicSweepHit<T> hit;
+		if (SweepBox(position, ballSize, move, paddleOne, paddleSize, hit) && hit.time <= time)
+		{
+			contact = Contact::PaddleOne;
+			time = hit.time;
+			paddleHit = hit;
+		}
+		if (SweepBox(position, ballSize, move, paddleTwo, paddleSize, hit) && hit.time <= time)
+		{
+			contact = Contact::PaddleTwo;
+			time = hit.time;
+			paddleHit = hit;
+		}
+
+		position.x += move.x * time;
+		position.y += move.y * time;
+		remaining -= remaining * time;
+
+		if (contact == Contact::None)
+		{
+			break;
+		}
+
+		result.bounces++;
+
+		if (contact == Contact::Wall)
+		{
+			position.y = velocity.y < T(0) ? T(0) : bottomWall;
+			velocity.y = -velocity.y;
+		}
+		else if (contact == Contact::Left || contact == Contact::Right)
+		{
+			position.x = contact == Contact::Left ? T(0) : rightEdge;
+			result.goal = contact == Contact::Left ? BallEdge::Left : BallEdge::Right;
+			result.remaining = static_cast<float>(remaining);
+			break;
+		}
+		else
+		{
+			const Vector2<T>& paddle = contact == Contact::PaddleOne ? paddleOne : paddleTwo;
+			result.paddle = contact == Contact::PaddleOne ? 1 : 2;
+
+			// Snap to the face touched, so rounding cannot leave the ball inside the paddle, and push a ball the paddle
+			// moved onto out the same way. A ball already heading away from that face, as when the paddle caught it from
+			// behind, keeps going rather than being turned back into the paddle
+			if (paddleHit.normal.x != T(0))
+			{
+				position.x = paddleHit.normal.x < T(0) ? paddle.x - T(BALL_WIDTH) : paddle.x + T(PADDLE_WIDTH);
+				if (velocity.x * paddleHit.normal.x < T(0))
+				{
+					BounceOffPaddle(position, velocity, paddle);
+				}
+			}
+			else
+			{
+				position.y = paddleHit.normal.y < T(0) ? paddle.y - T(BALL_HEIGHT) : paddle.y + T(PADDLE_HEIGHT);
+				if (velocity.y * paddleHit.normal.y < T(0))
+				{
+					velocity.y = -velocity.y;
+				}
+			}
+		}
+	}
+
+	return result;
+}
+
+// The number types the game is played with
+template bool SweepBox<float>(const Vec2&, const Vec2&, const Vec2&, const Vec2&, const Vec2&, SweepHit&);
+template bool SweepBox<Fixed>(const FixedVec2&, const FixedVec2&, const FixedVec2&, const FixedVec2&, const FixedVec2&, BasicSweepHit<Fixed>&);
+template BallMove MoveBall<float>(Vec2&, Vec2&, float, const Vec2&, const Vec2&);
+template BallMove MoveBall<Fixed>(FixedVec2&, FixedVec2&, Fixed, const FixedVec2&, const FixedVec2&);
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "ExtraBalls.h"
+
+void ExtraBalls::Add(const BallsMessage& message)
+{
+	Tick& slot = ticks[message.tick % EXTRA_BALL_TICKS];
+	if (!slot.valid || slot.tick != message.tick)
+	{
+		if (slot.valid && SequenceGreaterThan(slot.tick, message.tick))
+		{
+			return; // older than everything kept
+		}
+
+		// Start from the newest tick before this one, for any balls whose message does not arrive
+		uint16_t previousTick = 0;
+		const std::vector<BallState>* previous = Find(static_cast<uint16_t>(message.tick - 1), previousTick);
+		if (previous != NULL && previous->size() == message.total)
+		{
+			slot.balls = *previous;
+		}
+		else
+		{
+			slot.balls.assign(message.total, BallState{ Vec2(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f), Vec2(0.0f, 0.0f) });
+		}
+
+		slot.valid = true;
+		slot.tick = message.tick;
+	}
+
+	if (slot.balls.size() != message.total)
+	{
+		return;
+	}
+
+	for (int i = 0; i < message.count; i++)
+	{
+		BallState& ball = slot.balls[message.first + i];
+		ball.position = Vec2(message.x[i], message.y[i]);
+		ball.velocity = Vec2(message.velocityX[i], message.velocityY[i]);
+	}
+}
+
+const std::vector<BallState>* ExtraBalls::Find(uint16_t tick, uint16_t& foundTick) const
+{
+	const Tick* found = NULL;
+	for (const Tick& slot : ticks)
+	{
+		if (!slot.valid || SequenceGreaterThan(slot.tick, tick)
+			|| static_cast<uint16_t>(tick - slot.tick) >= EXTRA_BALL_TICKS)
+		{
+			continue;
+		}
+
+		if (found == NULL || SequenceGreaterThan(slot.tick, found->tick))
+		{
+			found = &slot;
+		}
+	}
+
+	if (found == NULL)
+	{
+		return NULL;
+	}
+
+	foundTick = found->tick;
+	return &found->balls;
+}
+
+void ExtraBalls::Clear()
+{
+	for (Tick& slot : ticks)
+	{
+		slot.valid = false;
+		slot.balls.clear();
+	}
+}
\ No newline at end of file
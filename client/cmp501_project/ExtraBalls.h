@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Protocol.h"
+#include "Trajectory.h"
+
+const int EXTRA_BALL_TICKS = 16; // ticks of extra balls kept, enough to cover the playout delay
+
+// The extra balls of a multi-ball match, kept for the last few ticks so that they are drawn at the same tick as the
+// rest of the world from the playout buffer. A tick whose balls came in several messages is filled in as they arrive,
+// starting from the tick before, so a lost message leaves its balls a tick behind rather than missing
+class ExtraBalls
+{
+public:
+	void Add(const BallsMessage& message);
+
+	// The balls of the newest tick at or before tick, or NULL if there are none. foundTick is set to that tick
+	const std::vector<BallState>* Find(uint16_t tick, uint16_t& foundTick) const;
+
+	void Clear();
+
+private:
+	struct Tick
+	{
+		bool valid = false;
+		uint16_t tick = 0;
+		std::vector<BallState> balls;
+	};
+
+	Tick ticks[EXTRA_BALL_TICKS];
+};
\ No newline at end of file
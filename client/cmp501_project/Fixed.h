@@ -0,0 +1,117 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include "Vec2.h"
+
+/* Fixed-point number with 16 fractional bits, for the lockstep simulation
+*
+*	Shared by the server and the client (keep the copies in both projects identical). Every operation
+*	is integer arithmetic, so the same inputs give the same bits on every compiler and CPU, which floats
+*	do not promise once fused multiply-adds, x87 precision or reordering by the optimizer come in. Covers
+*	-32768 to 32767 in steps of 1/65536. Products are truncated towards zero and quotients saturate
+*/
+class Fixed
+{
+public:
+	static const int FRACTION_BITS = 16;
+	static const int32_t ONE = 1 << FRACTION_BITS;
+
+	constexpr Fixed()
+		: raw(0)
+	{}
+
+	constexpr explicit Fixed(int value)
+		: raw(value * ONE)
+	{}
+
+	// Exact for constants that are binary fractions, like 0.5 and 0.75, and otherwise rounded to the nearest step.
+	// Only meant for constants: a float computed at run time is what the lockstep simulation avoids
+	explicit Fixed(float value)
+		: raw(static_cast<int32_t>(std::lround(static_cast<double>(value) * ONE)))
+	{}
+
+	static constexpr Fixed FromRaw(int32_t raw)
+	{
+		Fixed result;
+		result.raw = raw;
+		return result;
+	}
+
+	// numerator / denominator rounded to the nearest step, for constants that are not binary fractions
+	static constexpr Fixed FromRatio(int numerator, int denominator)
+	{
+		int64_t scaled = static_cast<int64_t>(numerator) * ONE * 2;
+		int64_t rounded = (scaled + (scaled >= 0 ? denominator : -denominator)) / (2 * static_cast<int64_t>(denominator));
+		return FromRaw(static_cast<int32_t>(rounded));
+	}
+
+	constexpr int32_t Raw() const { return raw; }
+
+	explicit operator float() const
+	{
+		return raw / static_cast<float>(ONE);
+	}
+
+	Fixed operator-() const { return FromRaw(-raw); }
+	Fixed operator+(Fixed rhs) const { return FromRaw(raw + rhs.raw); }
+	Fixed operator-(Fixed rhs) const { return FromRaw(raw - rhs.raw); }
+
+	Fixed operator*(Fixed rhs) const
+	{
+		return FromRaw(static_cast<int32_t>(static_cast<int64_t>(raw) * rhs.raw / ONE));
+	}
+
+	Fixed operator/(Fixed rhs) const
+	{
+		if (rhs.raw == 0)
+		{
+			return FromRaw(raw >= 0 ? INT32_MAX : INT32_MIN);
+		}
+
+		int64_t quotient = static_cast<int64_t>(raw) * ONE / rhs.raw;
+		if (quotient > INT32_MAX)
+		{
+			return FromRaw(INT32_MAX);
+		}
+		else if (quotient < INT32_MIN)
+		{
+			return FromRaw(INT32_MIN);
+		}
+
+		return FromRaw(static_cast<int32_t>(quotient));
+	}
+
+	Fixed& operator+=(Fixed rhs) { raw += rhs.raw; return *this; }
+	Fixed& operator-=(Fixed rhs) { raw -= rhs.raw; return *this; }
+	Fixed& operator*=(Fixed rhs) { return *this = *this * rhs; }
+
+	bool operator==(Fixed rhs) const { return raw == rhs.raw; }
+	bool operator!=(Fixed rhs) const { return raw != rhs.raw; }
+	bool operator<(Fixed rhs) const { return raw < rhs.raw; }
+	bool operator<=(Fixed rhs) const { return raw <= rhs.raw; }
+	bool operator>(Fixed rhs) const { return raw > rhs.raw; }
+	bool operator>=(Fixed rhs) const { return raw >= rhs.raw; }
+
+private:
+	int32_t raw;
+};
+
+typedef Vector2<Fixed> FixedVec2;
+
+inline Vec2 ToVec2(const FixedVec2& v)
+{
+	return Vec2(static_cast<float>(v.x), static_cast<float>(v.y));
+}
+
+namespace std
+{
+	template <>
+	class numeric_limits<Fixed>
+	{
+	public:
+		static const bool is_specialized = true;
+		static Fixed lowest() { return Fixed::FromRaw(INT32_MIN); }
+		static Fixed max() { return Fixed::FromRaw(INT32_MAX); }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include <algorithm>
+#include "FrameView.h"
+
+bool ViewFrame(const PlayoutBuffer& buffer, double now, int opponent, float opponentX, const Vec2& localPaddle,
+	const Predictor& predictor, const PredictionHistory& opponentMessages, FrameView& view)
+{
+	if (!buffer.Sample(now, view.sample))
+	{
+		return false;
+	}
+
+	const WorldSnapshot& from = *view.sample.from;
+	view.opponentY = (opponent == 1) ? from.paddleOneY : from.paddleTwoY;
+
+	Vec2 predicted;
+	if (view.sample.to != NULL)
+	{
+		float toY = (opponent == 1) ? (*view.sample.to).paddleOneY : (*view.sample.to).paddleTwoY;
+		view.opponentY += (toY - view.opponentY) * view.sample.fraction;
+	}
+	else if (predictor.Predict(opponentMessages, view.sample.time / 1000.0, predicted))
+	{
+		// The next snapshot is late, so predict the paddle from its history up to the extrapolation cap
+		view.opponentY = std::min(std::max(predicted.y, 0.0f), static_cast<float>(WINDOW_HEIGHT - PADDLE_HEIGHT));
+	}
+
+	// The trajectory goes through every bounce the server makes, so the ball needs no correcting, and crossing from
+	// one snapshot to the next does not move it
+	Vec2 opponentPaddle(opponentX, view.opponentY);
+	view.ball = ProjectBall(BallState{ Vec2(from.ballX, from.ballY), Vec2(from.ballVelocityX, from.ballVelocityY) },
+		view.sample.elapsed, (opponent == 1) ? opponentPaddle : localPaddle, (opponent == 1) ? localPaddle : opponentPaddle);
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+#include "PlayoutBuffer.h"
+#include "Predictor.h"
+#include "Trajectory.h"
+
+// What one frame draws of the world the server sent
+struct FrameView
+{
+	PlayoutSample sample; // the snapshots either side of the render time
+	float opponentY = 0.0f; // top of the opponent's paddle
+	BallState ball; // the ball projected from the drawn snapshot to the render time
+};
+
+// Work out a frame at now milliseconds: sample the playout buffer, interpolate the opponent's paddle (number opponent,
+// at opponentX) between the snapshots either side of the render time or predict it from opponentMessages past the
+// newest, and project the ball to the render time against this client's paddle (top left corner localPaddle) and the
+// opponent's as drawn. Returns false if the buffer is empty. The client's frame and the trace bench both draw with this,
+// so the bench scores exactly what the client shows
+bool ViewFrame(const PlayoutBuffer& buffer, double now, int opponent, float opponentX, const Vec2& localPaddle,
+	const Predictor& predictor, const PredictionHistory& opponentMessages, FrameView& view);
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+// Fixed-capacity history of timestamped entries (anything with a timestamp member), kept in timestamp order
+// Entries live in a ring inside the object, so adding one never allocates. An entry is inserted by moving it
+// back past any newer entries, which costs nothing when entries arrive in order, and the oldest entry is
+// dropped to make room once the history is full. A late entry older than every one kept is dropped instead
+template <typename T, int Capacity>
+class History
+{
+public:
+	void Add(const T& entry)
+	{
+		if (count == Capacity && entry.timestamp < (*this)[0].timestamp)
+		{
+			return;
+		}
+
+		if (count == Capacity)
+		{
+			start = (start + 1) % Capacity;
+			count--;
+		}
+
+		int i = count;
+		while (i > 0 && entry.timestamp < (*this)[i - 1].timestamp)
+		{
+			At(i) = At(i - 1);
+			i--;
+		}
+
+		At(i) = entry;
+		count++;
+	}
+
+	// Entry i in timestamp order, from 0 for the oldest to Size() - 1 for the newest
+	const T& operator[](int i) const { return entries[(start + i) % Capacity]; }
+
+	// Entry i counting back from the newest, so Newest(1) is the one before the newest
+	const T& Newest(int i = 0) const { return (*this)[count - 1 - i]; }
+
+	int Size() const { return count; }
+	bool Empty() const { return count == 0; }
+	static constexpr int MaxSize() { return Capacity; }
+
+	void Clear()
+	{
+		start = 0;
+		count = 0;
+	}
+
+private:
+	T& At(int i) { return entries[(start + i) % Capacity]; }
+
+	T entries[Capacity];
+	int start = 0; // slot of the oldest entry
+	int count = 0;
+};
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "LockstepReplay.h"
+#include "Logger.h"
+
+bool LockstepReplay::Read(sf::Packet& packet)
+{
+	if (packet.getDataSize() == 0)
+	{
+		return false;
+	}
+
+	uint8_t type = static_cast<const uint8_t*>(packet.getData())[0] & 0x0F;
+	if (type == static_cast<uint8_t>(MessageType::LockstepState))
+	{
+		LockstepState received;
+		uint16_t receivedTime = 0;
+		uint16_t receivedAck = 0;
+		if (!ReadLockstepState(packet, received, receivedTime, receivedAck))
+		{
+			return false;
+		}
+
+		// A state behind the simulation here is out of date
+		if (started && SequenceGreaterThan(static_cast<uint16_t>(state.tick), static_cast<uint16_t>(received.tick)))
+		{
+			return true;
+		}
+
+		if (started && static_cast<uint16_t>(state.tick) == static_cast<uint16_t>(received.tick)
+			&& LockstepChecksum(state) != LockstepChecksum(received))
+		{
+			LOG_WARNING(LogCategory::Snapshot) << "Lockstep state differs from the server's at tick " << received.tick << ", taking the server's";
+		}
+
+		state = received;
+		started = true;
+		stateReceived = true;
+		time = receivedTime;
+		inputAck = receivedAck;
+		return true;
+	}
+
+	if (type != static_cast<uint8_t>(MessageType::LockstepInputs) || !ReadLockstepInputs(packet, message))
+	{
+		return false;
+	}
+
+	for (int i = 0; i < message.count; i++)
+	{
+		uint16_t tick = static_cast<uint16_t>(message.tick - (message.count - 1 - i));
+		Tick& slot = ticks[tick % LOCKSTEP_HISTORY_SIZE];
+		if (!slot.valid || slot.tick != tick)
+		{
+			slot = Tick();
+			slot.valid = true;
+			slot.tick = tick;
+		}
+
+		slot.paddleOne = message.paddleOne[i];
+		slot.paddleTwo = message.paddleTwo[i];
+	}
+
+	Tick& newest = ticks[message.tick % LOCKSTEP_HISTORY_SIZE];
+	if (message.count > 0)
+	{
+		newest.newest = true;
+		newest.time = message.time;
+		newest.inputAck = message.inputAck;
+		newest.checksum = message.checksum;
+	}
+
+	return true;
+}
+
+bool LockstepReplay::Next(WorldSnapshot& snapshot)
+{
+	if (!started)
+	{
+		return false;
+	}
+
+	if (!stateReceived)
+	{
+		uint16_t nextTick = static_cast<uint16_t>(state.tick + 1);
+		const Tick& slot = ticks[nextTick % LOCKSTEP_HISTORY_SIZE];
+		if (!slot.valid || slot.tick != nextTick)
+		{
+			return false;
+		}
+
+		StepLockstep(state, slot.paddleOne, slot.paddleTwo);
+
+		if (slot.newest)
+		{
+			if (LockstepChecksum(state) != slot.checksum)
+			{
+				LOG_WARNING(LogCategory::Snapshot) << "Lockstep simulation out of step with the server at tick " << nextTick
+					<< ", waiting for its next full state";
+				started = false;
+				return false;
+			}
+
+			time = slot.time;
+			inputAck = slot.inputAck;
+		}
+		else
+		{
+			time = static_cast<uint16_t>(time + static_cast<int>(INPUT_DT));
+		}
+	}
+
+	stateReceived = false;
+	snapshot = LockstepSnapshot(state);
+	snapshot.tick = static_cast<uint16_t>(state.tick);
+	snapshot.time = time;
+	snapshot.inputAck = inputAck;
+	return true;
+}
+
+void LockstepReplay::Clear()
+{
+	for (Tick& slot : ticks)
+	{
+		slot = Tick();
+	}
+
+	started = false;
+	stateReceived = false;
+}
\ No newline at end of file
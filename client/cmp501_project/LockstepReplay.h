@@ -0,0 +1,43 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include "Lockstep.h"
+#include "Protocol.h"
+
+// The client's side of a lockstep match. The inputs the server relays are kept by tick and the match is simulated
+// from them, tick by tick as they arrive, each tick becoming a snapshot for the playout buffer like one received
+// from a snapshot server. The state is replaced by any full state from the server at or past its own tick, and
+// if a checksum shows it has gone out of step it waits for the next full state
+class LockstepReplay
+{
+public:
+	// Read a lockstep state or lockstep inputs message. Returns false if the packet is neither, or cannot be read
+	bool Read(sf::Packet& packet);
+
+	// Take the next tick: a full state just received, or the next tick simulated if its inputs have arrived.
+	// The snapshot carries the server time and input acknowledgement of the newest message that reached its tick
+	bool Next(WorldSnapshot& snapshot);
+
+	void Clear();
+
+private:
+	struct Tick
+	{
+		bool valid = false;
+		uint16_t tick = 0;
+		PaddleInput paddleOne = PaddleInput::None;
+		PaddleInput paddleTwo = PaddleInput::None;
+		bool newest = false; // the newest tick of a message, so the fields below are known
+		uint16_t time = 0;
+		uint16_t inputAck = 0;
+		uint16_t checksum = 0;
+	};
+
+	Tick ticks[LOCKSTEP_HISTORY_SIZE];
+	LockstepInputsMessage message;
+	LockstepState state;
+	bool started = false; // a full state has been received and the simulation has not gone out of step since
+	bool stateReceived = false; // state was just replaced by a full state, which Next has not handed out yet
+	uint16_t time = 0;
+	uint16_t inputAck = 0;
+};
\ No newline at end of file
@@ -0,0 +1,341 @@
+#include <charconv>
+#include <stdio.h>
+#include <string.h>
+#include "Logger.h"
+
+Logger& Logger::Instance()
+{
+	static Logger logger;
+	return logger;
+}
+
+Logger::Logger()
+	: startTime(Clock::now()),
+	entries(new Entry[LOG_RING_SIZE])
+{
+	for (int i = 0; i < LOG_RING_SIZE; i++)
+	{
+		entries[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+Logger::~Logger()
+{
+	Stop();
+}
+
+// Start the background thread that writes buffered lines to stdout
+void Logger::Start()
+{
+	if (running.exchange(true))
+	{
+		return;
+	}
+
+	thread = std::thread(&Logger::Run, this);
+}
+
+// Write out everything still buffered and stop the background thread
+void Logger::Stop()
+{
+	if (!running.exchange(false))
+	{
+		return;
+	}
+
+	thread.join();
+}
+
+uint64_t Logger::Now() const
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime).count();
+}
+
+// Returns false if a line of this level and category should not be formatted at all
+// Counts the line against the rate limit of its category
+bool Logger::ShouldLog(LogLevel level, LogCategory category)
+{
+	if (level < minLevel.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	if (level >= LogLevel::Warning)
+	{
+		return true;
+	}
+
+	// A race between two threads starting a new window can let a few extra lines through, which is harmless
+	CategoryLimit& limit = limits[static_cast<int>(category)];
+	uint32_t window = static_cast<uint32_t>(Now() / 1000000000);
+	if (limit.window.load(std::memory_order_relaxed) != window)
+	{
+		limit.window.store(window, std::memory_order_relaxed);
+		limit.count.store(0, std::memory_order_relaxed);
+	}
+
+	if (limit.count.fetch_add(1, std::memory_order_relaxed) >= static_cast<uint32_t>(rateLimit.load(std::memory_order_relaxed)))
+	{
+		rateLimited.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	return true;
+}
+
+// Copy a formatted line into the ring buffer, or drop it if the ring is full. Never waits
+void Logger::Write(LogLevel level, LogCategory category, uint64_t time, const char* text, std::size_t length)
+{
+	// Claim the next free slot. A slot is free once its sequence has caught up with the write position
+	uint64_t position = head.load(std::memory_order_relaxed);
+	Entry* entry = NULL;
+	while (true)
+	{
+		entry = &entries[position & (LOG_RING_SIZE - 1)];
+		uint64_t sequence = entry->sequence.load(std::memory_order_acquire);
+		int64_t difference = static_cast<int64_t>(sequence - position);
+		if (difference == 0)
+		{
+			if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			// The flush thread has not caught up with this slot yet
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+		{
+			position = head.load(std::memory_order_relaxed);
+		}
+	}
+
+	entry->time = time;
+	entry->level = level;
+	entry->category = category;
+	entry->length = static_cast<uint16_t>(length);
+	memcpy(entry->text, text, length);
+
+	// Publish the line to the flush thread
+	entry->sequence.store(position + 1, std::memory_order_release);
+	written.fetch_add(1, std::memory_order_relaxed);
+}
+
+Logger::Stats Logger::GetStats() const
+{
+	Stats stats;
+	stats.written = written.load(std::memory_order_relaxed);
+	stats.dropped = dropped.load(std::memory_order_relaxed);
+	stats.rateLimited = rateLimited.load(std::memory_order_relaxed);
+	return stats;
+}
+
+bool Logger::ParseLevel(const std::string& name, LogLevel& level)
+{
+	if (name == "debug")
+	{
+		level = LogLevel::Debug;
+	}
+	else if (name == "info")
+	{
+		level = LogLevel::Info;
+	}
+	else if (name == "warning")
+	{
+		level = LogLevel::Warning;
+	}
+	else if (name == "error")
+	{
+		level = LogLevel::Error;
+	}
+	else if (name == "off")
+	{
+		level = LogLevel::Off;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+void Logger::Run()
+{
+	std::string output;
+	output.reserve(LOG_RING_SIZE * (LOG_MESSAGE_SIZE + 32));
+
+	while (running.load(std::memory_order_acquire))
+	{
+		if (Drain(output) == 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(LOG_FLUSH_INTERVAL_MILLISECONDS));
+		}
+	}
+
+	// Write out whatever was logged before stopping
+	Drain(output);
+	lastReportTime = 0;
+	ReportDrops(output);
+}
+
+// Write every published line to stdout in one go, returning how many were written
+int Logger::Drain(std::string& output)
+{
+	output.clear();
+
+	int count = 0;
+	char prefix[48];
+	while (true)
+	{
+		Entry& entry = entries[tail & (LOG_RING_SIZE - 1)];
+		if (entry.sequence.load(std::memory_order_acquire) != tail + 1)
+		{
+			break;
+		}
+
+		int prefixLength = snprintf(prefix, sizeof(prefix), "%.3f\t| %s", entry.time / 1000000000.0,
+			entry.level == LogLevel::Error ? "error: " : (entry.level == LogLevel::Warning ? "warning: " : ""));
+		output.append(prefix, prefixLength);
+		output.append(entry.text, entry.length);
+		output.push_back('\n');
+
+		// Hand the slot back to the logging threads for the next time round the ring
+		entry.sequence.store(tail + LOG_RING_SIZE, std::memory_order_release);
+		tail++;
+		count++;
+	}
+
+	ReportDrops(output);
+
+	if (!output.empty())
+	{
+		fwrite(output.data(), 1, output.size(), stdout);
+		fflush(stdout);
+	}
+
+	return count;
+}
+
+// Add a line saying how many lines were lost since the last report, at most once a second
+void Logger::ReportDrops(std::string& output)
+{
+	uint64_t now = Now();
+	if (lastReportTime != 0 && now - lastReportTime < 1000000000)
+	{
+		return;
+	}
+
+	uint64_t totalDropped = dropped.load(std::memory_order_relaxed);
+	uint64_t totalRateLimited = rateLimited.load(std::memory_order_relaxed);
+	if (totalDropped == reportedDropped && totalRateLimited == reportedRateLimited)
+	{
+		return;
+	}
+
+	char line[128];
+	int length = snprintf(line, sizeof(line), "%.3f\t| warning: %llu log lines dropped with the buffer full, %llu rate limited\n",
+		now / 1000000000.0,
+		static_cast<unsigned long long>(totalDropped - reportedDropped),
+		static_cast<unsigned long long>(totalRateLimited - reportedRateLimited));
+	output.append(line, length);
+
+	reportedDropped = totalDropped;
+	reportedRateLimited = totalRateLimited;
+	lastReportTime = now;
+}
+
+LogLine::LogLine(LogLevel level, LogCategory category)
+	: level(level),
+	category(category),
+	time(Logger::Instance().Now())
+{
+}
+
+LogLine::~LogLine()
+{
+	Logger::Instance().Write(level, category, time, text, length);
+}
+
+void LogLine::Append(const char* source, std::size_t count)
+{
+	std::size_t space = LOG_MESSAGE_SIZE - length;
+	if (count > space)
+	{
+		count = space;
+	}
+
+	memcpy(text + length, source, count);
+	length += count;
+}
+
+LogLine& LogLine::operator<<(const char* source)
+{
+	Append(source, strlen(source));
+	return *this;
+}
+
+LogLine& LogLine::operator<<(const std::string& source)
+{
+	Append(source.data(), source.size());
+	return *this;
+}
+
+LogLine& LogLine::operator<<(char c)
+{
+	Append(&c, 1);
+	return *this;
+}
+
+LogLine& LogLine::operator<<(bool value)
+{
+	return *this << (value ? "1" : "0");
+}
+
+LogLine& LogLine::operator<<(int value)
+{
+	return *this << static_cast<long long>(value);
+}
+
+LogLine& LogLine::operator<<(unsigned int value)
+{
+	return *this << static_cast<unsigned long long>(value);
+}
+
+LogLine& LogLine::operator<<(long value)
+{
+	return *this << static_cast<long long>(value);
+}
+
+LogLine& LogLine::operator<<(unsigned long value)
+{
+	return *this << static_cast<unsigned long long>(value);
+}
+
+LogLine& LogLine::operator<<(long long value)
+{
+	char digits[24];
+	std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+	Append(digits, result.ptr - digits);
+	return *this;
+}
+
+LogLine& LogLine::operator<<(unsigned long long value)
+{
+	char digits[24];
+	std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+	Append(digits, result.ptr - digits);
+	return *this;
+}
+
+// Same format as std::ostream's default for floating point
+LogLine& LogLine::operator<<(double value)
+{
+	char digits[32];
+	int count = snprintf(digits, sizeof(digits), "%g", value);
+	Append(digits, count > 0 ? count : 0);
+	return *this;
+}
\ No newline at end of file
@@ -1,9 +1,10 @@
 #include <algorithm> 
 #include "Global.h"
 #include "Paddle.h"
+#include "Protocol.h"
 
 Paddle::Paddle(Vec2 position, Vec2 velocity)
-	: position(position), velocity(velocity)
+	: position(position), velocity(velocity), predictor(CreatePredictor(PredictorType::Linear, DEFAULT_PREDICTION_DEPTH))
 {	
 	rect.x = static_cast<int>(position.x);
 	rect.y = static_cast<int>(position.y);
@@ -32,104 +33,41 @@ void Paddle::Update(float dt)
 	}
 }
 
-void Paddle::Draw(SDL_Renderer* renderer)
-{
-	rect.y = static_cast<int>(position.y);
-
-	SDL_RenderFillRect(renderer, &rect);	
-}
-
-void Paddle::ShowPlayerIndicator(SDL_Renderer* renderer)
+// Set velocity from an input command and move for dt milliseconds
+void Paddle::Move(PaddleInput input, float dt)
 {
-	playerIndicator.y = static_cast<int>(position.y + PADDLE_HEIGHT / 2 - 25);
-
-	SDL_RenderFillRect(renderer, &playerIndicator);
-}
-
-void Paddle::AddMessage(const Message& msg)
-{	
-	int numMessages = paddleMessages.size();
-	if (numMessages == maxMessages)
+	if (input == PaddleInput::Up)
 	{
-		std::move(paddleMessages.begin() + 1, paddleMessages.end(), paddleMessages.begin());
-		paddleMessages[numMessages - 1] = msg;
+		velocity.y = -PADDLE_SPEED;
 	}
-	else
+	else if (input == PaddleInput::Down)
 	{
-		paddleMessages.push_back(msg);
-	}
-
-	// sort messages in increasing order of timestamp
-	std::sort(paddleMessages.begin(), paddleMessages.end(), compareByTimestamp);
-}
-
-void Paddle::AddPrediction(const Message& prediction)
-{
-	int numPredictions = paddlePredictions.size();
-	if (numPredictions == maxMessages)
-	{
-		std::move(paddlePredictions.begin() + 1, paddlePredictions.end(), paddlePredictions.begin());
-		paddlePredictions[numPredictions - 1] = prediction;
+		velocity.y = PADDLE_SPEED;
 	}
 	else
 	{
-		paddlePredictions.push_back(prediction);
+		velocity.y = 0.0f;
 	}
 
-	// sort messages in increasing order of timestamp
-	std::sort(paddlePredictions.begin(), paddlePredictions.end(), compareByTimestamp);
+	Update(dt);
 }
 
-Message Paddle::RunPrediction(double gameTime, bool fromPredictions) {
-	
-	//float predictedY = (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f);
-	float predictedY = position.y;
-	float speedY, displacementY;
-	Message prediction;
-	prediction.timestamp = gameTime;
-	prediction.y = predictedY;
-	prediction.x = 0;
-	prediction.ball = false;
-	prediction.port = 0;
+// Choose how this paddle is predicted, and from how many samples
+void Paddle::SetPredictor(PredictorType type, int depth)
+{
+	predictor = CreatePredictor(type, depth);
+}
 
-	int size = paddleMessages.size();
-	if (size < 2)
-	{		
-		return prediction;
-	}
-	
-	const Message& msg0 = paddleMessages[size - 1];
-	const Message& msg1 = paddleMessages[size - 2];
-	
-	if (fromPredictions)
-	{
-		size = paddlePredictions.size();
-		if (size < 2)
-		{
-			return prediction;
-		}
-		
-		const Message& msg0 = paddlePredictions[size - 1];
-		const Message& msg1 = paddlePredictions[size - 2];
-	}
+void Paddle::Draw(SDL_Renderer* renderer)
+{
+	rect.y = static_cast<int>(position.y);
 
-	/* Linear model */
-	speedY = (msg0.y - msg1.y) / (msg0.timestamp - msg1.timestamp);
-	displacementY = speedY * (gameTime - msg0.timestamp);	
-	predictedY = msg0.y + displacementY;
+	SDL_RenderFillRect(renderer, &rect);	
+}
 
-	if (predictedY < 0)
-	{
-		// Restrict to top of the screen
-		predictedY = 0;
-	}
-	else if (predictedY > (WINDOW_HEIGHT - PADDLE_HEIGHT))
-	{
-		// Restrict to bottom of the screen
-		predictedY = WINDOW_HEIGHT - PADDLE_HEIGHT;
-	}
+void Paddle::ShowPlayerIndicator(SDL_Renderer* renderer)
+{
+	playerIndicator.y = static_cast<int>(position.y + PADDLE_HEIGHT / 2 - 25);
 
-	prediction.y = predictedY;
-	
-	return prediction;
+	SDL_RenderFillRect(renderer, &playerIndicator);
 }
\ No newline at end of file
@@ -1,8 +1,13 @@
 #pragma once
 #include <SDL.h>
-#include <vector>
+#include <cstdint>
+#include <memory>
 #include "Global.h"
 #include "Vec2.h"
+#include "History.h"
+#include "Predictor.h"
+
+enum class PaddleInput : uint8_t;
 
 class Paddle
 {
@@ -10,17 +15,15 @@ public:
 	Paddle(Vec2 position, Vec2 velocity);
 
 	void Update(float dt);
+	void Move(PaddleInput input, float dt);
 	void Draw(SDL_Renderer* renderer);
 	void ShowPlayerIndicator(SDL_Renderer* renderer);
-	void AddMessage(const Message& msg);
-	void AddPrediction(const Message& prediction);
-	Message RunPrediction(double gameTime, bool fromPredictions);
+	void SetPredictor(PredictorType type, int depth);
 
 	Vec2 position;
 	Vec2 velocity;
 	SDL_Rect rect{};
 	SDL_Rect playerIndicator{};
-	std::vector<Message> paddleMessages;
-	std::vector<Message> paddlePredictions;
-	int maxMessages = 2;
+	PredictionHistory paddleMessages;
+	std::unique_ptr<Predictor> predictor;
 };
\ No newline at end of file
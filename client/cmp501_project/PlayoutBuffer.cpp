@@ -0,0 +1,233 @@
+#include <algorithm>
+#include "PlayoutBuffer.h"
+
+PlayoutBuffer::PlayoutBuffer(float maxExtrapolation)
+	: maxExtrapolation(maxExtrapolation)
+{
+}
+
+// Ticks only carry 16 bits on the wire, so they are unwrapped to the tick nearest the newest one
+int64_t PlayoutBuffer::Unwrap(uint32_t tick) const
+{
+	if (entries.Empty())
+	{
+		return static_cast<uint16_t>(tick);
+	}
+
+	return newestTick + static_cast<int16_t>(static_cast<uint16_t>(tick) - static_cast<uint16_t>(newestTick));
+}
+
+bool PlayoutBuffer::Add(const WorldSnapshot& snapshot, double arrival)
+{
+	Entry entry;
+	entry.timestamp = static_cast<double>(Unwrap(snapshot.tick));
+	entry.arrival = arrival;
+	entry.snapshot = snapshot;
+	return AddEntry(entry);
+}
+
+bool PlayoutBuffer::Add(const WorldSnapshot& snapshot, double arrival, double sent)
+{
+	Entry entry;
+	entry.timestamp = static_cast<double>(Unwrap(snapshot.tick));
+	entry.arrival = arrival;
+	entry.sent = sent;
+	entry.sentKnown = true;
+	entry.snapshot = snapshot;
+	return AddEntry(entry);
+}
+
+bool PlayoutBuffer::AddEntry(const Entry& entry)
+{
+	if (!entries.Empty())
+	{
+		if (entries.Size() == entries.MaxSize() && entry.timestamp < entries[0].timestamp)
+		{
+			return false;
+		}
+
+		for (int i = 0; i < entries.Size(); i++)
+		{
+			if (entries[i].timestamp == entry.timestamp)
+			{
+				return false;
+			}
+		}
+	}
+
+	entries.Add(entry);
+	newestTick = static_cast<int64_t>(entries.Newest().timestamp);
+	Measure();
+
+	return true;
+}
+
+// Fit the tick interval to the send times, or the arrival times until every snapshot kept has a send time, then find
+// how late each snapshot was against the earliest any of them could have arrived, and move the delay towards what
+// covers that lateness. Send times are free of the network's jitter, so they give the interval and timeline exactly
+void PlayoutBuffer::Measure()
+{
+	int count = entries.Size();
+	if (count < 2)
+	{
+		return;
+	}
+
+	sendTimes = true;
+	for (int i = 0; i < count; i++)
+	{
+		sendTimes = sendTimes && entries[i].sentKnown;
+	}
+
+	double meanTick = 0.0;
+	double meanTime = 0.0;
+	for (int i = 0; i < count; i++)
+	{
+		meanTick += entries[i].timestamp;
+		meanTime += sendTimes ? entries[i].sent : entries[i].arrival;
+	}
+	meanTick /= count;
+	meanTime /= count;
+
+	double sumTT = 0.0;
+	double sumTA = 0.0;
+	for (int i = 0; i < count; i++)
+	{
+		double t = entries[i].timestamp - meanTick;
+		sumTT += t * t;
+		sumTA += t * ((sendTimes ? entries[i].sent : entries[i].arrival) - meanTime);
+	}
+
+	// A couple of snapshots bunched together by jitter can give a nonsense slope, so keep the last good one
+	if (sumTT > 0.0 && sumTA > 0.0)
+	{
+		tickInterval = static_cast<float>(std::min(sumTA / sumTT, 1000.0));
+	}
+
+	if (tickInterval <= 0.0f)
+	{
+		return;
+	}
+
+	double lateness = 0.0;
+	if (sendTimes)
+	{
+		transit = entries.Newest().arrival - entries.Newest().sent;
+		for (int i = 0; i < count; i++)
+		{
+			transit = std::min(transit, entries[i].arrival - entries[i].sent);
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			lateness += entries[i].arrival - entries[i].sent - transit;
+		}
+	}
+	else
+	{
+		newestArrivalBase = entries.Newest().arrival;
+		for (int i = 0; i < count; i++)
+		{
+			newestArrivalBase = std::min(newestArrivalBase, entries[i].arrival + (newestTick - entries[i].timestamp) * tickInterval);
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			lateness += entries[i].arrival + (newestTick - entries[i].timestamp) * tickInterval - newestArrivalBase;
+		}
+	}
+	jitter = static_cast<float>(lateness / count);
+
+	// The server sends a client fewer snapshots than it ticks when the link is congested, so they may be several ticks apart
+	snapshotInterval = static_cast<float>((entries.Newest().timestamp - entries[0].timestamp) / (count - 1) * tickInterval);
+
+	// One snapshot interval so the snapshot after the render time is due, and the rest for it arriving late
+	float target = std::min(snapshotInterval + JITTER_DELAY_MULTIPLE * jitter, MAX_INTERPOLATION_DELAY);
+	delay = (delay == 0.0f) ? target : delay + (target - delay) * DELAY_ADAPT_RATE;
+}
+
+// When a buffered snapshot would have arrived without jitter, in the same milliseconds as the arrival times
+double PlayoutBuffer::PlayoutTime(const Entry& entry) const
+{
+	if (sendTimes)
+	{
+		return entry.sent + transit;
+	}
+
+	return newestArrivalBase + (entry.timestamp - newestTick) * tickInterval;
+}
+
+bool PlayoutBuffer::Sample(double now, PlayoutSample& sample) const
+{
+	sample = PlayoutSample();
+	if (entries.Empty())
+	{
+		return false;
+	}
+
+	// Nothing to measure the timing by yet, so draw the newest snapshot as it is
+	if (entries.Size() < 2 || tickInterval <= 0.0f)
+	{
+		sample.from = &entries.Newest().snapshot;
+		sample.time = entries.Newest().arrival;
+		return true;
+	}
+
+	double renderTime = now - delay;
+	int newest = entries.Size() - 1;
+	int from = newest;
+	while (from >= 0 && PlayoutTime(entries[from]) > renderTime)
+	{
+		from--;
+	}
+
+	if (from < 0)
+	{
+		// Render time is before every snapshot kept, so hold the oldest
+		sample.from = &entries[0].snapshot;
+		sample.time = PlayoutTime(entries[0]);
+		return true;
+	}
+
+	double fromTime = PlayoutTime(entries[from]);
+	sample.from = &entries[from].snapshot;
+	sample.elapsed = static_cast<float>(renderTime - fromTime);
+
+	if (from == newest)
+	{
+		// Past the newest snapshot, so the caller extrapolates, but no further than the cap
+		sample.elapsed = std::min(sample.elapsed, maxExtrapolation);
+	}
+	else
+	{
+		double span = PlayoutTime(entries[from + 1]) - fromTime;
+		sample.to = &entries[from + 1].snapshot;
+		sample.fraction = static_cast<float>(std::min((renderTime - fromTime) / span, 1.0));
+	}
+
+	sample.time = fromTime + sample.elapsed;
+	return true;
+}
+
+double PlayoutBuffer::NewestPlayoutTime() const
+{
+	if (entries.Empty())
+	{
+		return 0.0;
+	}
+
+	return (tickInterval > 0.0f) ? PlayoutTime(entries.Newest()) : entries.Newest().arrival;
+}
+
+void PlayoutBuffer::Clear()
+{
+	entries.Clear();
+	newestTick = 0;
+	newestArrivalBase = 0.0;
+	sendTimes = false;
+	transit = 0.0;
+	tickInterval = 0.0f;
+	snapshotInterval = 0.0f;
+	jitter = 0.0f;
+	delay = 0.0f;
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include "History.h"
+#include "Protocol.h"
+
+const int PLAYOUT_BUFFER_SIZE = 32; // snapshots kept, and looked at to measure the tick interval and jitter
+const float DEFAULT_MAX_EXTRAPOLATION = 100.0f; // milliseconds the render time may run past the newest snapshot
+const float MAX_INTERPOLATION_DELAY = 250.0f; // milliseconds
+const float JITTER_DELAY_MULTIPLE = 3.0f; // lateness covered by the delay, in multiples of the mean lateness
+const float DELAY_ADAPT_RATE = 0.1f; // fraction of the way the delay moves towards its target with each snapshot
+
+// Where a frame is drawn between the buffered snapshots
+struct PlayoutSample
+{
+	const WorldSnapshot* from = NULL; // newest snapshot at or before the render time, or the oldest if all are after it
+	const WorldSnapshot* to = NULL; // snapshot after from, NULL when the render time is past the newest snapshot
+	float fraction = 0.0f; // how far the render time is from from to to, between 0 and 1
+	float elapsed = 0.0f; // milliseconds from from to the render time, at most the extrapolation cap past the newest
+	double time = 0.0; // render time in the milliseconds of the arrival times, past the newest snapshot by at most the cap
+};
+
+// Playout buffer of snapshots for drawing the world a little in the past at an even pace
+// Each snapshot is given the time it would have arrived without jitter. Once the clock is synchronized with the server,
+// that is when the server sent it, converted to this client's clock, plus the quickest any snapshot in the buffer took
+// to arrive. Before then the tick interval is fitted to the arrival times in the buffer and the earliest arrivals mark
+// the fastest path from the server. Frames are drawn at the current time less an interpolation delay, which follows the
+// lateness measured from that fastest path so that the snapshots either side of the render time have nearly always
+// arrived. Works with any server tick rate
+class PlayoutBuffer
+{
+public:
+	PlayoutBuffer(float maxExtrapolation = DEFAULT_MAX_EXTRAPOLATION);
+
+	// Add a snapshot that arrived at arrival milliseconds, and was sent at sent milliseconds of the same clock if known.
+	// Returns false for duplicates and snapshots older than the buffer
+	bool Add(const WorldSnapshot& snapshot, double arrival);
+	bool Add(const WorldSnapshot& snapshot, double arrival, double sent);
+
+	// Find the snapshots to draw at now milliseconds. Returns false if the buffer is empty
+	bool Sample(double now, PlayoutSample& sample) const;
+
+	// When the newest snapshot would have arrived without jitter, which is where it sits on the render timeline
+	double NewestPlayoutTime() const;
+
+	float Delay() const { return delay; }
+	float Jitter() const { return jitter; }
+	float TickInterval() const { return tickInterval; }
+	float SnapshotInterval() const { return snapshotInterval; }
+	int Size() const { return entries.Size(); }
+	void SetMaxExtrapolation(float milliseconds) { maxExtrapolation = milliseconds; }
+	void Clear();
+
+private:
+	struct Entry
+	{
+		double timestamp = 0.0; // tick, unwrapped, which orders the buffer
+		double arrival = 0.0;
+		double sent = 0.0; // when the server sent it, on the clock of the arrival times
+		bool sentKnown = false;
+		WorldSnapshot snapshot;
+	};
+
+	bool AddEntry(const Entry& entry);
+
+	int64_t Unwrap(uint32_t tick) const;
+	void Measure();
+	double PlayoutTime(const Entry& entry) const;
+
+	History<Entry, PLAYOUT_BUFFER_SIZE> entries;
+	int64_t newestTick = 0;
+	double newestArrivalBase = 0.0; // earliest the newest tick would have arrived, judged from every snapshot in the buffer
+	bool sendTimes = false; // every snapshot in the buffer has a send time, so they are timed by it
+	double transit = 0.0; // quickest milliseconds from being sent to arriving of the snapshots in the buffer
+	float tickInterval = 0.0f; // milliseconds, 0 until two snapshots have arrived
+	float snapshotInterval = 0.0f; // mean milliseconds between the snapshots in the buffer, more than a tick when the server skips ticks
+	float jitter = 0.0f; // mean milliseconds a snapshot arrives after the earliest it could have
+	float delay = 0.0f;
+	float maxExtrapolation;
+};
\ No newline at end of file
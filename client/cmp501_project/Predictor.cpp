@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <cmath>
+#include "Predictor.h"
+
+Predictor::Predictor(int depth)
+	: depth(std::min(std::max(depth, MIN_PREDICTION_DEPTH), PREDICTION_HISTORY_SIZE))
+{
+}
+
+bool Predictor::Predict(const PredictionHistory& history, double time, Vec2& predicted) const
+{
+	int count = std::min(depth, history.Size());
+	if (count < MIN_PREDICTION_DEPTH)
+	{
+		return false;
+	}
+
+	Message samples[PREDICTION_HISTORY_SIZE];
+	for (int i = 0; i < count; i++)
+	{
+		samples[i] = history.Newest(count - 1 - i);
+	}
+
+	predicted = Extrapolate(samples, count, time);
+	return true;
+}
+
+// Least squares line through one coordinate of the samples, evaluated at time
+// Times are taken relative to the newest sample to keep the sums small
+static float FitLine(const Message* samples, int count, double time, float Message::* coordinate)
+{
+	double origin = samples[count - 1].timestamp;
+	double meanT = 0.0;
+	double meanX = 0.0;
+	for (int i = 0; i < count; i++)
+	{
+		meanT += samples[i].timestamp - origin;
+		meanX += samples[i].*coordinate;
+	}
+	meanT /= count;
+	meanX /= count;
+
+	double sumTT = 0.0;
+	double sumTX = 0.0;
+	for (int i = 0; i < count; i++)
+	{
+		double t = samples[i].timestamp - origin - meanT;
+		sumTT += t * t;
+		sumTX += t * (samples[i].*coordinate - meanX);
+	}
+
+	// All samples at the same time, so there is no speed to go on
+	if (sumTT <= 0.0)
+	{
+		return samples[count - 1].*coordinate;
+	}
+
+	return static_cast<float>(meanX + (sumTX / sumTT) * (time - origin - meanT));
+}
+
+// Least squares parabola through one coordinate of the samples, evaluated at time
+static float FitParabola(const Message* samples, int count, double time, float Message::* coordinate)
+{
+	double origin = samples[count - 1].timestamp;
+
+	// Sums of t^k and of t^k * x for the normal equations
+	double s[5] = {};
+	double sx[3] = {};
+	for (int i = 0; i < count; i++)
+	{
+		double t = samples[i].timestamp - origin;
+		double x = samples[i].*coordinate;
+		double tk = 1.0;
+		for (int k = 0; k < 5; k++)
+		{
+			s[k] += tk;
+			if (k < 3)
+			{
+				sx[k] += tk * x;
+			}
+			tk *= t;
+		}
+	}
+
+	// Solve for x = a + b*t + c*t^2 by Cramer's rule
+	double det = s[0] * (s[2] * s[4] - s[3] * s[3]) - s[1] * (s[1] * s[4] - s[3] * s[2]) + s[2] * (s[1] * s[3] - s[2] * s[2]);
+	if (std::fabs(det) < 1e-18)
+	{
+		return FitLine(samples, count, time, coordinate);
+	}
+
+	double a = (sx[0] * (s[2] * s[4] - s[3] * s[3]) - s[1] * (sx[1] * s[4] - s[3] * sx[2]) + s[2] * (sx[1] * s[3] - s[2] * sx[2])) / det;
+	double b = (s[0] * (sx[1] * s[4] - s[3] * sx[2]) - sx[0] * (s[1] * s[4] - s[3] * s[2]) + s[2] * (s[1] * sx[2] - sx[1] * s[2])) / det;
+	double c = (s[0] * (s[2] * sx[2] - sx[1] * s[3]) - s[1] * (s[1] * sx[2] - sx[1] * s[2]) + sx[0] * (s[1] * s[3] - s[2] * s[2])) / det;
+
+	double t = time - origin;
+	return static_cast<float>(a + b * t + c * t * t);
+}
+
+Vec2 LinearPredictor::Extrapolate(const Message* samples, int count, double time) const
+{
+	return Vec2(FitLine(samples, count, time, &Message::x), FitLine(samples, count, time, &Message::y));
+}
+
+Vec2 ConstantAccelerationPredictor::Extrapolate(const Message* samples, int count, double time) const
+{
+	if (count < 3)
+	{
+		return Vec2(FitLine(samples, count, time, &Message::x), FitLine(samples, count, time, &Message::y));
+	}
+
+	return Vec2(FitParabola(samples, count, time, &Message::x), FitParabola(samples, count, time, &Message::y));
+}
+
+AlphaBetaPredictor::AlphaBetaPredictor(int depth, float alpha, float beta)
+	: Predictor(depth), alpha(alpha), beta(beta)
+{
+}
+
+Vec2 AlphaBetaPredictor::Extrapolate(const Message* samples, int count, double time) const
+{
+	// Start from the line through the oldest two samples, then filter the rest
+	Vec2 position(samples[1].x, samples[1].y);
+	Vec2 speed;
+	double dt = samples[1].timestamp - samples[0].timestamp;
+	if (dt > 0.0)
+	{
+		speed = Vec2(static_cast<float>((samples[1].x - samples[0].x) / dt), static_cast<float>((samples[1].y - samples[0].y) / dt));
+	}
+
+	for (int i = 2; i < count; i++)
+	{
+		dt = samples[i].timestamp - samples[i - 1].timestamp;
+		if (dt <= 0.0)
+		{
+			continue;
+		}
+
+		Vec2 expected = position + speed * static_cast<float>(dt);
+		Vec2 residual(samples[i].x - expected.x, samples[i].y - expected.y);
+		position = expected + residual * alpha;
+		speed += residual * static_cast<float>(beta / dt);
+	}
+
+	return position + speed * static_cast<float>(time - samples[count - 1].timestamp);
+}
+
+KalmanPredictor::KalmanPredictor(int depth, double accelerationNoise, double measurementNoise)
+	: Predictor(depth), accelerationNoise(accelerationNoise), measurementNoise(measurementNoise)
+{
+}
+
+// Run a position/speed Kalman filter over one coordinate of the samples and extrapolate the estimate to time
+static float FilterKalman(const Message* samples, int count, double time, float Message::* coordinate,
+	double accelerationNoise, double measurementNoise)
+{
+	// State estimate and its covariance. The speed starts unknown
+	double p = samples[0].*coordinate;
+	double v = 0.0;
+	double p00 = measurementNoise, p01 = 0.0, p11 = 1.0e6;
+
+	for (int i = 1; i < count; i++)
+	{
+		double dt = samples[i].timestamp - samples[i - 1].timestamp;
+		if (dt <= 0.0)
+		{
+			continue;
+		}
+
+		// Predict forward by dt, adding the uncertainty of an unknown acceleration over that time
+		p += v * dt;
+		double dt2 = dt * dt;
+		double n00 = p00 + 2.0 * dt * p01 + dt2 * p11 + accelerationNoise * dt2 * dt2 / 4.0;
+		double n01 = p01 + dt * p11 + accelerationNoise * dt2 * dt / 2.0;
+		double n11 = p11 + accelerationNoise * dt2;
+
+		// Correct with the sample
+		double innovation = samples[i].*coordinate - p;
+		double s = n00 + measurementNoise;
+		double k0 = n00 / s;
+		double k1 = n01 / s;
+		p += k0 * innovation;
+		v += k1 * innovation;
+		p00 = (1.0 - k0) * n00;
+		p01 = (1.0 - k0) * n01;
+		p11 = n11 - k1 * n01;
+	}
+
+	return static_cast<float>(p + v * (time - samples[count - 1].timestamp));
+}
+
+Vec2 KalmanPredictor::Extrapolate(const Message* samples, int count, double time) const
+{
+	return Vec2(
+		FilterKalman(samples, count, time, &Message::x, accelerationNoise, measurementNoise),
+		FilterKalman(samples, count, time, &Message::y, accelerationNoise, measurementNoise)
+	);
+}
+
+std::unique_ptr<Predictor> CreatePredictor(PredictorType type, int depth)
+{
+	switch (type)
+	{
+	case PredictorType::ConstantAcceleration:
+		return std::unique_ptr<Predictor>(new ConstantAccelerationPredictor(depth));
+	case PredictorType::AlphaBeta:
+		return std::unique_ptr<Predictor>(new AlphaBetaPredictor(depth));
+	case PredictorType::Kalman:
+		return std::unique_ptr<Predictor>(new KalmanPredictor(depth));
+	default:
+		return std::unique_ptr<Predictor>(new LinearPredictor(depth));
+	}
+}
+
+bool ParsePredictorType(const std::string& name, PredictorType& type)
+{
+	if (name == "linear")
+	{
+		type = PredictorType::Linear;
+	}
+	else if (name == "acceleration")
+	{
+		type = PredictorType::ConstantAcceleration;
+	}
+	else if (name == "alpha-beta")
+	{
+		type = PredictorType::AlphaBeta;
+	}
+	else if (name == "kalman")
+	{
+		type = PredictorType::Kalman;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+const char* PredictorName(PredictorType type)
+{
+	switch (type)
+	{
+	case PredictorType::ConstantAcceleration:
+		return "acceleration";
+	case PredictorType::AlphaBeta:
+		return "alpha-beta";
+	case PredictorType::Kalman:
+		return "kalman";
+	default:
+		return "linear";
+	}
+}
\ No newline at end of file
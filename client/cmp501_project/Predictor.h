@@ -0,0 +1,100 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "Global.h"
+#include "Vec2.h"
+#include "History.h"
+
+using PredictionHistory = History<Message, PREDICTION_HISTORY_SIZE>;
+
+const int MIN_PREDICTION_DEPTH = 2;
+const int DEFAULT_PREDICTION_DEPTH = 2;
+
+enum class PredictorType
+{
+	Linear,
+	ConstantAcceleration,
+	AlphaBeta,
+	Kalman
+};
+
+// Predicts where an entity will be from the newest samples of one of its histories
+// Each engine looks at up to depth samples (at most PREDICTION_HISTORY_SIZE), so a deeper history costs
+// more per prediction in exchange for smoothing out more of the jitter in the samples
+class Predictor
+{
+public:
+	Predictor(int depth);
+	virtual ~Predictor() = default;
+
+	// Predict the position at time (in seconds, like the sample timestamps). Returns false if there are not enough samples
+	bool Predict(const PredictionHistory& history, double time, Vec2& predicted) const;
+
+	int Depth() const { return depth; }
+	virtual PredictorType Type() const = 0;
+
+protected:
+	// samples holds count (at least MIN_PREDICTION_DEPTH) samples, oldest first
+	virtual Vec2 Extrapolate(const Message* samples, int count, double time) const = 0;
+
+private:
+	int depth;
+};
+
+// Least squares line through the samples. With a depth of 2 this is the line through the newest two samples
+class LinearPredictor : public Predictor
+{
+public:
+	using Predictor::Predictor;
+	PredictorType Type() const override { return PredictorType::Linear; }
+
+protected:
+	Vec2 Extrapolate(const Message* samples, int count, double time) const override;
+};
+
+// Least squares parabola through the samples, so a change of speed carries on. Falls back to a line with fewer than 3 samples
+class ConstantAccelerationPredictor : public Predictor
+{
+public:
+	using Predictor::Predictor;
+	PredictorType Type() const override { return PredictorType::ConstantAcceleration; }
+
+protected:
+	Vec2 Extrapolate(const Message* samples, int count, double time) const override;
+};
+
+// Alpha-beta filter run over the samples: each sample corrects the position by alpha and the speed by beta of the
+// difference between the sample and the position the filter expected
+class AlphaBetaPredictor : public Predictor
+{
+public:
+	AlphaBetaPredictor(int depth, float alpha = 0.85f, float beta = 0.5f);
+	PredictorType Type() const override { return PredictorType::AlphaBeta; }
+
+protected:
+	Vec2 Extrapolate(const Message* samples, int count, double time) const override;
+
+private:
+	float alpha;
+	float beta;
+};
+
+// Constant velocity Kalman filter on each axis, run over the samples. Weighs each sample against the filter's
+// estimate by how much the speed can change between samples and how noisy the samples are
+class KalmanPredictor : public Predictor
+{
+public:
+	KalmanPredictor(int depth, double accelerationNoise = 2.0e6, double measurementNoise = 0.05);
+	PredictorType Type() const override { return PredictorType::Kalman; }
+
+protected:
+	Vec2 Extrapolate(const Message* samples, int count, double time) const override;
+
+private:
+	double accelerationNoise; // variance of the acceleration between samples, in (pixels/s^2)^2
+	double measurementNoise; // variance of a sample position, in pixels^2
+};
+
+std::unique_ptr<Predictor> CreatePredictor(PredictorType type, int depth);
+bool ParsePredictorType(const std::string& name, PredictorType& type);
+const char* PredictorName(PredictorType type);
\ No newline at end of file
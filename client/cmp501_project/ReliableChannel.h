@@ -0,0 +1,68 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "Protocol.h"
+#include "RoundTrip.h"
+
+const double CONTROL_INITIAL_TIMEOUT = 200.0; // milliseconds before the first resend, until a round trip is measured
+const double CONTROL_MIN_TIMEOUT = 50.0;
+const double CONTROL_MAX_TIMEOUT = 2000.0;
+
+// Reliable, ordered delivery of control messages over udp, so they share the socket of the snapshots and never
+// wait behind a lost tcp segment. The sender numbers each message and sends every one not yet acknowledged in
+// one datagram, so a receiver that has missed one gets it again with everything after it. The receiver takes
+// messages strictly in order and acknowledges the newest it has taken, which acknowledges all before it too.
+// Unacknowledged messages are resent after a timeout worked out from the round trip as tcp does, doubling on
+// every resend that is not answered
+class ReliableSender
+{
+public:
+	void Queue(const ControlMessage& message);
+
+	// True when messages have been queued since the last send, or the oldest is due to be resent, at now (milliseconds)
+	bool ShouldSend(double now) const;
+	void Write(sf::Packet& packet, double now);
+
+	// Drop the messages up to and including sequence, which the receiver has taken
+	void Acknowledge(uint16_t sequence, double now);
+
+	bool Idle() const { return pending.empty(); } // every message queued has been acknowledged
+	double Timeout() const { return timeout; }
+	const RoundTripEstimator& RoundTrip() const { return roundTrip; }
+	uint64_t Resends() const { return resends; }
+
+private:
+	struct Pending
+	{
+		ControlMessage message;
+		uint16_t sequence = 0;
+		double sentTime = 0.0; // time first sent
+		bool resent = false;
+	};
+
+	std::deque<Pending> pending; // oldest first
+	uint16_t nextSequence = 1;
+	int unsent = 0; // newest messages in pending not sent yet
+	double resendTime = 0.0;
+	RoundTripEstimator roundTrip;
+	double timeout = CONTROL_INITIAL_TIMEOUT;
+	uint64_t resends = 0;
+};
+
+class ReliableReceiver
+{
+public:
+	// Read a control datagram, adding the messages not taken before to delivered, in order. Returns false if the
+	// packet is not a control datagram. An acknowledgement should be sent whenever it returns true, even if
+	// nothing was delivered, as the acknowledgement the sender is resending for may have been lost
+	bool Read(sf::Packet& packet, std::vector<ControlMessage>& delivered);
+
+	uint16_t Acknowledged() const { return received; } // newest sequence taken, 0 if none
+
+	void Clear();
+
+private:
+	uint16_t received = 0;
+};
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+// Smoothed round trip time and its variance, kept from samples the way tcp keeps them (RFC 6298), in milliseconds.
+// The variance is the smoothed mean deviation from the smoothed round trip, which is cheaper than the true variance
+// and what retransmission timeouts are worked out from
+class RoundTripEstimator
+{
+public:
+	void AddSample(double roundTrip)
+	{
+		latest = roundTrip;
+		if (!measured)
+		{
+			smoothed = roundTrip;
+			variance = roundTrip / 2.0;
+			measured = true;
+			return;
+		}
+
+		variance = 0.75 * variance + 0.25 * std::fabs(smoothed - roundTrip);
+		smoothed = 0.875 * smoothed + 0.125 * roundTrip;
+	}
+
+	// How long to wait for an answer before taking it as lost, between minimum and maximum
+	double Timeout(double minimum, double maximum) const
+	{
+		return std::min(std::max(smoothed + 4.0 * variance, minimum), maximum);
+	}
+
+	bool Measured() const { return measured; }
+	double Smoothed() const { return smoothed; }
+	double Variance() const { return variance; }
+	double Latest() const { return latest; }
+
+private:
+	double smoothed = 0.0;
+	double variance = 0.0;
+	double latest = 0.0;
+	bool measured = false;
+};
\ No newline at end of file
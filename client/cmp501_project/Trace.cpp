@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include "Collision.h"
+#include "Global.h"
+#include "Trace.h"
+
+bool TraceWriter::Open(const std::string& path)
+{
+	file.open(path);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	file << "# arrival tick time ballX ballY ballVelocityX ballVelocityY paddleOneY paddleTwoY playerOneScore playerTwoScore\n";
+	file << std::setprecision(9);
+	return true;
+}
+
+void TraceWriter::Write(const WorldSnapshot& snapshot, double arrival)
+{
+	if (!file.is_open())
+	{
+		return;
+	}
+
+	file << arrival << ' ' << snapshot.tick << ' ' << snapshot.time << ' '
+		<< snapshot.ballX << ' ' << snapshot.ballY << ' ' << snapshot.ballVelocityX << ' ' << snapshot.ballVelocityY << ' '
+		<< snapshot.paddleOneY << ' ' << snapshot.paddleTwoY << ' '
+		<< static_cast<int>(snapshot.playerOneScore) << ' ' << static_cast<int>(snapshot.playerTwoScore) << '\n';
+}
+
+bool LoadTrace(const std::string& path, std::vector<TraceEntry>& received)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	received.clear();
+	int64_t newestTick = 0;
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		std::istringstream fields(line);
+		TraceEntry entry;
+		WorldSnapshot& s = entry.snapshot;
+		uint32_t tick = 0;
+		int playerOneScore = 0;
+		int playerTwoScore = 0;
+		if (!(fields >> entry.arrival >> tick >> s.time >> s.ballX >> s.ballY >> s.ballVelocityX >> s.ballVelocityY
+			>> s.paddleOneY >> s.paddleTwoY >> playerOneScore >> playerTwoScore))
+		{
+			continue;
+		}
+
+		// Ticks are only known to 16 bits, so each is taken as the nearest to the newest so far
+		int64_t unwrapped = received.empty()
+			? (tick & 0xFFFF)
+			: newestTick + static_cast<int16_t>(static_cast<uint16_t>(tick) - static_cast<uint16_t>(newestTick));
+		newestTick = std::max(newestTick, unwrapped);
+		s.tick = static_cast<uint32_t>(unwrapped);
+		s.playerOneScore = static_cast<uint8_t>(playerOneScore);
+		s.playerTwoScore = static_cast<uint8_t>(playerTwoScore);
+		received.push_back(entry);
+	}
+
+	std::stable_sort(received.begin(), received.end(),
+		[](const TraceEntry& a, const TraceEntry& b) { return a.arrival < b.arrival; });
+	return !received.empty();
+}
+
+// Move a paddle towards where its player means to meet the ball, at most as fast as input allows
+static float ChasePaddle(float y, float aim, float dt)
+{
+	float target = std::min(std::max(aim - PADDLE_HEIGHT / 2.0f, 0.0f), static_cast<float>(WINDOW_HEIGHT - PADDLE_HEIGHT));
+	float step = PADDLE_SPEED * dt;
+	return y + std::min(std::max(target - y, -step), step);
+}
+
+void GenerateTrace(const TraceConfig& config, std::vector<TraceEntry>& received, std::vector<WorldSnapshot>& truth)
+{
+	std::mt19937 random(config.seed);
+	std::exponential_distribution<double> jitter(config.jitter > 0.0f ? 1.0 / config.jitter : 1.0);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	// Where on the paddle each player tries to meet the ball. Some aims are wide enough to miss
+	std::uniform_real_distribution<float> aimError(-0.7f * PADDLE_HEIGHT, 0.7f * PADDLE_HEIGHT);
+
+	float dt = 1000.0f / config.tickRate;
+	int tickCount = config.seconds * config.tickRate;
+
+	Vec2 ball((WINDOW_WIDTH / 2.0f) - (BALL_WIDTH / 2.0f), (WINDOW_HEIGHT / 2.0f) - (BALL_WIDTH / 2.0f));
+	Vec2 velocity(BALL_SPEED, 0.0f);
+	Vec2 paddleOne(50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
+	Vec2 paddleTwo(WINDOW_WIDTH - 50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
+	int playerOneScore = 0;
+	int playerTwoScore = 0;
+	float aimOne = 0.0f;
+	float aimTwo = 0.0f;
+	bool headingRight = false;
+
+	truth.clear();
+	received.clear();
+	truth.reserve(tickCount);
+	received.reserve(tickCount);
+
+	for (int tick = 1; tick <= tickCount; tick++)
+	{
+		// A new aim each time the ball turns, and the player waiting for it drifts back to the middle
+		if ((velocity.x > 0.0f) != headingRight)
+		{
+			headingRight = velocity.x > 0.0f;
+			(headingRight ? aimTwo : aimOne) = aimError(random);
+		}
+
+		float ballCentre = ball.y + BALL_HEIGHT / 2.0f;
+		paddleOne.y = ChasePaddle(paddleOne.y, headingRight ? WINDOW_HEIGHT / 2.0f : ballCentre + aimOne, dt);
+		paddleTwo.y = ChasePaddle(paddleTwo.y, headingRight ? ballCentre + aimTwo : WINDOW_HEIGHT / 2.0f, dt);
+
+		BallMove move = MoveBall(ball, velocity, dt, paddleOne, paddleTwo);
+		if (move.goal != BallEdge::None)
+		{
+			// Served from the middle towards the player who scored, as the server does
+			bool left = move.goal == BallEdge::Left;
+			playerOneScore += !left;
+			playerTwoScore += left;
+			ball = Vec2(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f);
+			velocity = Vec2(left ? BALL_SPEED : -BALL_SPEED, 0.75f * BALL_SPEED);
+		}
+
+		WorldSnapshot snapshot;
+		snapshot.tick = tick;
+		snapshot.time = static_cast<uint32_t>(tick * dt);
+		snapshot.ballX = ball.x;
+		snapshot.ballY = ball.y;
+		snapshot.ballVelocityX = velocity.x;
+		snapshot.ballVelocityY = velocity.y;
+		snapshot.paddleOneY = paddleOne.y;
+		snapshot.paddleTwoY = paddleTwo.y;
+		snapshot.playerOneScore = static_cast<uint8_t>(playerOneScore);
+		snapshot.playerTwoScore = static_cast<uint8_t>(playerTwoScore);
+		truth.push_back(snapshot);
+
+		if (unit(random) < config.loss)
+		{
+			continue;
+		}
+
+		// Quantized as the protocol sends it, and stamped to the millisecond on arrival like SDL_GetTicks
+		TraceEntry entry;
+		entry.snapshot = snapshot;
+		entry.snapshot.ballX = DequantizePosition(QuantizePosition(ball.x));
+		entry.snapshot.ballY = DequantizePosition(QuantizePosition(ball.y));
+		entry.snapshot.ballVelocityX = DequantizeVelocity(QuantizeVelocity(velocity.x));
+		entry.snapshot.ballVelocityY = DequantizeVelocity(QuantizeVelocity(velocity.y));
+		entry.snapshot.paddleOneY = DequantizePosition(QuantizePosition(paddleOne.y));
+		entry.snapshot.paddleTwoY = DequantizePosition(QuantizePosition(paddleTwo.y));
+		entry.arrival = std::floor(tick * dt + config.latency + (config.jitter > 0.0f ? jitter(random) : 0.0));
+		received.push_back(entry);
+	}
+
+	std::stable_sort(received.begin(), received.end(),
+		[](const TraceEntry& a, const TraceEntry& b) { return a.arrival < b.arrival; });
+}
\ No newline at end of file
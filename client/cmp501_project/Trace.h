@@ -0,0 +1,44 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Protocol.h"
+
+// A snapshot as this client received it
+struct TraceEntry
+{
+	double arrival = 0.0; // milliseconds of the client clock
+	WorldSnapshot snapshot; // tick unwrapped past 16 bits
+};
+
+// How a synthetic trace is played and sent
+struct TraceConfig
+{
+	int seconds = 60;
+	int tickRate = 60; // snapshots per second
+	float latency = 50.0f; // milliseconds each way
+	float jitter = 10.0f; // mean milliseconds of extra, exponentially distributed latency on each snapshot
+	float loss = 0.01f; // fraction of snapshots lost
+	unsigned int seed = 1;
+};
+
+// Records the snapshots a client receives to a text file, one line per snapshot:
+// arrival tick time ballX ballY ballVelocityX ballVelocityY paddleOneY paddleTwoY playerOneScore playerTwoScore
+class TraceWriter
+{
+public:
+	bool Open(const std::string& path);
+	void Write(const WorldSnapshot& snapshot, double arrival);
+	bool IsOpen() const { return file.is_open(); }
+
+private:
+	std::ofstream file;
+};
+
+// Read a trace written by TraceWriter, in arrival order. Returns false if the file cannot be read or has no snapshots
+bool LoadTrace(const std::string& path, std::vector<TraceEntry>& received);
+
+// Play a match the way the server does, with both paddles chasing the ball, and send its snapshots over a
+// network with the configured latency, jitter and loss. received is filled in arrival order, and truth with
+// the snapshot of every tick, in tick order
+void GenerateTrace(const TraceConfig& config, std::vector<TraceEntry>& received, std::vector<WorldSnapshot>& truth);
\ No newline at end of file
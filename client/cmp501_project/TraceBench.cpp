@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Global.h"
+#include "FrameView.h"
+#include "Predictor.h"
+#include "PlayoutBuffer.h"
+#include "Trajectory.h"
+#include "Trace.h"
+
+// Offline replay of snapshot traces through the client's drawing pipeline: the playout buffer, the ball trajectory
+// and the opponent paddle predictor. Each frame is compared with where the server really had the ball and paddle
+// at the tick being drawn, to measure how far off and how jumpy the drawn world is, and what a frame costs
+//
+// A trace recorded by the client with --record-trace <file> is replayed with --trace <file>. Its truth is the
+// snapshots it holds, so lost snapshots are filled in by following the ball from the one before. Otherwise a
+// trace is generated from a match played out like the server plays it: --seconds <match length> at
+// --tick-rate <ticks per second>, sent with --latency <milliseconds>, --jitter <mean extra milliseconds>
+// and --loss <fraction of snapshots lost>, from --seed <number>
+// The client draws at --fps <frames per second>, extrapolating at most --max-extrapolation <milliseconds>, and a frame
+// where the drawn position moves more than --snap <pixels> further than the true one did counts as a visible snap.
+// Every paddle predictor is compared unless one is picked with --paddle-predictor <linear|acceleration|alpha-beta|kalman>,
+// and each is run with --paddle-prediction-depth <number of samples>
+
+static volatile float benchSink; // keeps timed results from being optimized away
+
+const float DEFAULT_FPS = 144.0f;
+const float DEFAULT_SNAP_DISTANCE = 5.0f; // pixels
+const int TIMING_PASSES = 5;
+
+struct ReplayConfig
+{
+	float fps = DEFAULT_FPS;
+	float maxExtrapolation = DEFAULT_MAX_EXTRAPOLATION;
+	float snapDistance = DEFAULT_SNAP_DISTANCE;
+	PredictorType paddlePredictor = PredictorType::Linear;
+	int paddlePredictionDepth = DEFAULT_PREDICTION_DEPTH;
+};
+
+// The world the server really had, tick by tick
+struct Truth
+{
+	std::vector<WorldSnapshot> ticks; // in tick order
+	float tickInterval = 0.0f; // milliseconds
+
+	// Where the ball and paddle two were at a fractional tick. Returns false outside the trace
+	bool At(double tick, Vec2& ball, float& paddleTwoY) const
+	{
+		auto next = std::upper_bound(ticks.begin(), ticks.end(), tick,
+			[](double t, const WorldSnapshot& s) { return t < s.tick; });
+		if (next == ticks.begin() || (next == ticks.end() && tick > ticks.back().tick + 1.0))
+		{
+			return false;
+		}
+
+		const WorldSnapshot& from = *(next - 1);
+		float sinceFrom = static_cast<float>(tick - from.tick);
+		paddleTwoY = from.paddleTwoY;
+		if (next != ticks.end())
+		{
+			paddleTwoY += (next->paddleTwoY - from.paddleTwoY) * sinceFrom / (next->tick - from.tick);
+		}
+
+		BallState state{ Vec2(from.ballX, from.ballY), Vec2(from.ballVelocityX, from.ballVelocityY) };
+		ball = ProjectBall(state, sinceFrom * tickInterval,
+			Vec2(50.0f, from.paddleOneY), Vec2(WINDOW_WIDTH - 50.0f, from.paddleTwoY)).position;
+		return true;
+	}
+};
+
+// Errors in pixels of every frame drawn, and the frames where the drawn position jumped
+struct ErrorStats
+{
+	std::vector<float> errors;
+	int snaps = 0;
+
+	double Mean() const
+	{
+		double total = 0.0;
+		for (float e : errors)
+		{
+			total += e;
+		}
+		return errors.empty() ? 0.0 : total / errors.size();
+	}
+
+	double Percentile(double p)
+	{
+		if (errors.empty())
+		{
+			return 0.0;
+		}
+		std::vector<float>::iterator nth = errors.begin() + static_cast<std::size_t>(p * (errors.size() - 1));
+		std::nth_element(errors.begin(), nth, errors.end());
+		return *nth;
+	}
+};
+
+struct ReplayStats
+{
+	ErrorStats ball;
+	ErrorStats paddle;
+	int frames = 0;
+	int extrapolatedFrames = 0;
+	double totalDelay = 0.0;
+};
+
+// Play the received snapshots through the pipeline at the client frame rate with ViewFrame, as main does each frame.
+// This client plays paddle one, which with no inputs of its own stays where the newest snapshot has it.
+// With truth given, each frame is scored against it. Returns the nanoseconds the frames took, per frame
+static double Replay(const std::vector<TraceEntry>& received, const ReplayConfig& config, const Truth* truth, ReplayStats& stats)
+{
+	PlayoutBuffer playoutBuffer(config.maxExtrapolation);
+	PredictionHistory paddleMessages;
+	std::unique_ptr<Predictor> predictor = CreatePredictor(config.paddlePredictor, config.paddlePredictionDepth);
+	std::size_t next = 0;
+	uint32_t newestTick = 0;
+	Vec2 localPaddle(50.0f, 0.0f);
+	bool haveDrawn = false;
+	Vec2 lastBall, lastTrueBall;
+	float lastPaddle = 0.0f, lastTruePaddle = 0.0f;
+	float checksum = 0.0f;
+	double frameInterval = 1000.0 / config.fps;
+	double end = received.back().arrival;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (double now = received.front().arrival; now <= end; now += frameInterval)
+	{
+		while (next < received.size() && received[next].arrival <= now)
+		{
+			const WorldSnapshot& snapshot = received[next].snapshot;
+			if (playoutBuffer.Add(snapshot, received[next].arrival) && (newestTick == 0 || snapshot.tick > newestTick))
+			{
+				newestTick = snapshot.tick;
+				localPaddle.y = snapshot.paddleOneY;
+
+				Message msg;
+				msg.timestamp = playoutBuffer.NewestPlayoutTime() / 1000.0;
+				msg.x = WINDOW_WIDTH - 50.0f;
+				msg.y = snapshot.paddleTwoY;
+				paddleMessages.Add(msg);
+			}
+			next++;
+		}
+
+		FrameView view;
+		if (!ViewFrame(playoutBuffer, now, 2, WINDOW_WIDTH - 50.0f, localPaddle, *predictor, paddleMessages, view))
+		{
+			continue;
+		}
+
+		const PlayoutSample& sample = view.sample;
+		const WorldSnapshot& from = *sample.from;
+		float paddleY = view.opponentY;
+		Vec2 ball = view.ball.position;
+		checksum += ball.x + paddleY;
+
+		if (truth == NULL || playoutBuffer.TickInterval() <= 0.0f)
+		{
+			continue;
+		}
+
+		// The tick this frame shows, going by the interval the buffer measured
+		Vec2 trueBall;
+		float truePaddle = 0.0f;
+		if (!truth->At(from.tick + sample.elapsed / playoutBuffer.TickInterval(), trueBall, truePaddle))
+		{
+			haveDrawn = false;
+			continue;
+		}
+
+		stats.ball.errors.push_back(std::hypot(ball.x - trueBall.x, ball.y - trueBall.y));
+		stats.paddle.errors.push_back(std::fabs(paddleY - truePaddle));
+		stats.frames++;
+		stats.extrapolatedFrames += sample.to == NULL;
+		stats.totalDelay += playoutBuffer.Delay();
+
+		if (haveDrawn)
+		{
+			float jumpX = (ball.x - lastBall.x) - (trueBall.x - lastTrueBall.x);
+			float jumpY = (ball.y - lastBall.y) - (trueBall.y - lastTrueBall.y);
+			stats.ball.snaps += std::hypot(jumpX, jumpY) > config.snapDistance;
+			stats.paddle.snaps += std::fabs((paddleY - lastPaddle) - (truePaddle - lastTruePaddle)) > config.snapDistance;
+		}
+
+		haveDrawn = true;
+		lastBall = ball;
+		lastTrueBall = trueBall;
+		lastPaddle = paddleY;
+		lastTruePaddle = truePaddle;
+	}
+
+	std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+	benchSink = checksum;
+	int frames = static_cast<int>((end - received.front().arrival) / frameInterval) + 1;
+	return std::chrono::duration<double, std::nano>(stop - start).count() / frames;
+}
+
+// The truth of a recorded trace is what it received, one snapshot per tick, paced at the interval fitted to the arrivals
+static void TruthFromReceived(const std::vector<TraceEntry>& received, Truth& truth)
+{
+	truth.ticks.clear();
+	for (const TraceEntry& entry : received)
+	{
+		truth.ticks.push_back(entry.snapshot);
+	}
+
+	std::sort(truth.ticks.begin(), truth.ticks.end(),
+		[](const WorldSnapshot& a, const WorldSnapshot& b) { return a.tick < b.tick; });
+	truth.ticks.erase(std::unique(truth.ticks.begin(), truth.ticks.end(),
+		[](const WorldSnapshot& a, const WorldSnapshot& b) { return a.tick == b.tick; }), truth.ticks.end());
+
+	double meanTick = 0.0;
+	double meanArrival = 0.0;
+	for (const TraceEntry& entry : received)
+	{
+		meanTick += entry.snapshot.tick;
+		meanArrival += entry.arrival;
+	}
+	meanTick /= received.size();
+	meanArrival /= received.size();
+
+	double sumTT = 0.0;
+	double sumTA = 0.0;
+	for (const TraceEntry& entry : received)
+	{
+		double t = entry.snapshot.tick - meanTick;
+		sumTT += t * t;
+		sumTA += t * (entry.arrival - meanArrival);
+	}
+
+	truth.tickInterval = sumTT > 0.0 ? static_cast<float>(sumTA / sumTT) : 1000.0f / 60.0f;
+}
+
+static void PrintErrors(const char* name, ErrorStats& stats)
+{
+	std::cout << name << ": " << stats.Mean() << " pixels mean error, " << stats.Percentile(0.99)
+		<< " pixels p99 error, " << stats.snaps << " snaps";
+}
+
+int main(int argc, char* argv[])
+{
+	std::string tracePath;
+	TraceConfig traceConfig;
+	ReplayConfig replayConfig;
+	bool allPredictors = true;
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (std::string(argv[i]) == "--trace")
+		{
+			tracePath = argv[i + 1];
+		}
+		else if (std::string(argv[i]) == "--seconds")
+		{
+			traceConfig.seconds = atoi(argv[i + 1]);
+		}
+		else if (std::string(argv[i]) == "--tick-rate")
+		{
+			traceConfig.tickRate = atoi(argv[i + 1]);
+		}
+		else if (std::string(argv[i]) == "--latency")
+		{
+			traceConfig.latency = static_cast<float>(atof(argv[i + 1]));
+		}
+		else if (std::string(argv[i]) == "--jitter")
+		{
+			traceConfig.jitter = static_cast<float>(atof(argv[i + 1]));
+		}
+		else if (std::string(argv[i]) == "--loss")
+		{
+			traceConfig.loss = static_cast<float>(atof(argv[i + 1]));
+		}
+		else if (std::string(argv[i]) == "--seed")
+		{
+			traceConfig.seed = static_cast<unsigned int>(atoi(argv[i + 1]));
+		}
+		else if (std::string(argv[i]) == "--fps")
+		{
+			replayConfig.fps = static_cast<float>(atof(argv[i + 1]));
+		}
+		else if (std::string(argv[i]) == "--max-extrapolation")
+		{
+			replayConfig.maxExtrapolation = static_cast<float>(atof(argv[i + 1]));
+		}
+		else if (std::string(argv[i]) == "--snap")
+		{
+			replayConfig.snapDistance = static_cast<float>(atof(argv[i + 1]));
+		}
+		else if (std::string(argv[i]) == "--paddle-predictor")
+		{
+			allPredictors = !ParsePredictorType(argv[i + 1], replayConfig.paddlePredictor);
+		}
+		else if (std::string(argv[i]) == "--paddle-prediction-depth")
+		{
+			replayConfig.paddlePredictionDepth = atoi(argv[i + 1]);
+		}
+	}
+
+	if (traceConfig.tickRate <= 0 || traceConfig.seconds <= 0 || replayConfig.fps <= 0.0f)
+	{
+		std::cerr << "Tick rate, match length and frame rate must be positive" << std::endl;
+		return 1;
+	}
+
+	std::vector<TraceEntry> received;
+	Truth truth;
+	if (!tracePath.empty())
+	{
+		if (!LoadTrace(tracePath, received))
+		{
+			std::cerr << "Could not read a trace from " << tracePath << std::endl;
+			return 1;
+		}
+
+		TruthFromReceived(received, truth);
+		std::cout << "Trace " << tracePath << ": " << received.size() << " snapshots over "
+			<< (received.back().arrival - received.front().arrival) / 1000.0 << " seconds, "
+			<< truth.tickInterval << " ms tick interval";
+	}
+	else
+	{
+		GenerateTrace(traceConfig, received, truth.ticks);
+		truth.tickInterval = 1000.0f / traceConfig.tickRate;
+		if (received.empty())
+		{
+			std::cerr << "Every snapshot of the generated trace was lost" << std::endl;
+			return 1;
+		}
+
+		std::cout << "Synthetic trace: " << traceConfig.seconds << " seconds at " << traceConfig.tickRate << " ticks per second, "
+			<< traceConfig.latency << " ms latency with " << traceConfig.jitter << " ms mean jitter and "
+			<< traceConfig.loss * 100.0f << "% loss";
+	}
+	std::cout << ", drawn at " << replayConfig.fps << " frames per second" << std::endl;
+
+	std::vector<PredictorType> types;
+	if (allPredictors)
+	{
+		types = { PredictorType::Linear, PredictorType::ConstantAcceleration, PredictorType::AlphaBeta, PredictorType::Kalman };
+	}
+	else
+	{
+		types = { replayConfig.paddlePredictor };
+	}
+
+	for (PredictorType type : types)
+	{
+		replayConfig.paddlePredictor = type;
+
+		ReplayStats stats;
+		Replay(received, replayConfig, &truth, stats);
+
+		// Time the frames separately, so the cost is not lost among the scoring
+		double ns = 0.0;
+		for (int pass = 0; pass < TIMING_PASSES; pass++)
+		{
+			ReplayStats unscored;
+			ns += Replay(received, replayConfig, NULL, unscored) / TIMING_PASSES;
+		}
+
+		std::cout << "\t" << PredictorName(type) << " depth " << replayConfig.paddlePredictionDepth << ": "
+			<< ns << " ns per frame, " << stats.frames << " frames, "
+			<< (stats.frames > 0 ? 100.0 * stats.extrapolatedFrames / stats.frames : 0.0) << "% extrapolated, "
+			<< (stats.frames > 0 ? stats.totalDelay / stats.frames : 0.0) << " ms mean delay" << std::endl;
+		std::cout << "\t\t";
+		PrintErrors("Ball", stats.ball);
+		std::cout << std::endl << "\t\t";
+		PrintErrors("Opponent paddle", stats.paddle);
+		std::cout << std::endl;
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#include "Collision.h"
+#include "Trajectory.h"
+
+BallState ProjectBall(const BallState& start, float elapsed, const Vec2& paddleOne, const Vec2& paddleTwo)
+{
+	BallState state = start;
+	if (elapsed <= 0.0f)
+	{
+		return state;
+	}
+
+	// Sweep the ball along its path as the server does, so every bounce the server will make is followed
+	BallMove move = MoveBall(state.position, state.velocity, elapsed, paddleOne, paddleTwo);
+	if (move.goal != BallEdge::None)
+	{
+		// Goal, so hold the ball at the edge until the server puts it back in the middle
+		state.velocity = Vec2(0.0f, 0.0f);
+	}
+
+	return state;
+}
\ No newline at end of file
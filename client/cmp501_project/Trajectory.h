@@ -0,0 +1,16 @@
+#pragma once
+#include "Global.h"
+#include "Vec2.h"
+
+// Position and velocity (in pixels per millisecond) of the ball at one moment
+struct BallState
+{
+	Vec2 position;
+	Vec2 velocity;
+};
+
+// Where the ball will be elapsed milliseconds after start, following the same rules the server plays by
+// The ball is swept along its path with the collision code the server uses (see Collision.h), so the result does not
+// depend on how often it is asked for. The paddles (their top left corners) are taken to stay where they are, and a
+// ball that gets past a paddle stops at the edge of the field to wait for the server to restart it
+BallState ProjectBall(const BallState& start, float elapsed, const Vec2& paddleOne, const Vec2& paddleTwo);
\ No newline at end of file
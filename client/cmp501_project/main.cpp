@@ -4,148 +4,122 @@
 #include <SFML/Network.hpp>
 #include <SFML/System/Time.hpp>
 #include <stdio.h>
-#include <iostream>
+#include <algorithm>
 #include <math.h>
+#include <vector>
 #include "Global.h"
 #include "Vec2.h"
 #include "Ball.h"
 #include "Paddle.h"
+#include "Predictor.h"
+#include "Trajectory.h"
+#include "FrameView.h"
+#include "PlayoutBuffer.h"
+#include "ExtraBalls.h"
+#include "LockstepReplay.h"
+#include "ClockSync.h"
+#include "ReliableChannel.h"
+#include "Trace.h"
 #include "PlayerScore.h"
 #include "MenuText.h"
+#include "Protocol.h"
+#include "Logger.h"
+#include "Benchmark.h"
 
-struct ScoreMessage
-{
-	double timestamp = 0;
-	int playerOneScore, playerTwoScore = 0;
-};
-
-sf::Packet& operator <<(sf::Packet& packet, const Message& message)
-{
-	return packet << message.timestamp << message.x << message.y << message.ball << message.port;
-}
-
-sf::Packet& operator >>(sf::Packet& packet, Message& message)
-{
-	return packet >> message.timestamp >> message.x >> message.y >> message.ball >> message.port;
-}
-
-sf::Packet& operator <<(sf::Packet& packet, const ScoreMessage& scoreMessage)
-{
-	return packet << scoreMessage.timestamp << scoreMessage.playerOneScore << scoreMessage.playerTwoScore;
-}
-
-sf::Packet& operator >>(sf::Packet& packet, ScoreMessage& scoreMessage)
-{
-	return packet >> scoreMessage.timestamp >> scoreMessage.playerOneScore >> scoreMessage.playerTwoScore;
-}
-
-struct Ball::Contact CheckPaddleCollision(Ball const& ball, Paddle const& paddle)
+int main(int argc, char* argv[])
 {
-	float ballLeft = ball.position.x;
-	float ballRight = ball.position.x + BALL_WIDTH;
-	float ballTop = ball.position.y;
-	float ballBottom = ball.position.y + BALL_HEIGHT;	
-
-	float paddleLeft = paddle.position.x;
-	float paddleRight = paddle.position.x + PADDLE_WIDTH;
-	float paddleTop = paddle.position.y;
-	float paddleBottom = paddle.position.y + PADDLE_HEIGHT;
-
-	Ball::Contact contact{};
-	
-	if (ballLeft >= paddleRight)
+	// Logging can be limited to --log-level <debug|info|warning|error|off>, and to --log-rate <lines per second> for each category
+	// Log lines are written to the console by a background thread so that the frame never waits on it
+	// Passing --bench-history <number of frames> runs the prediction history benchmark instead of the game
+	// The opponent paddle is predicted with --paddle-predictor <linear|acceleration|alpha-beta|kalman>,
+	// from the newest --paddle-prediction-depth <number of samples> of its history
+	// Passing --bench-predictors <number of samples> compares the cost and error of every predictor instead of running the game
+	// The ball and the opponent paddle are drawn a little in the past from a playout buffer, and are extrapolated at most
+	// --max-extrapolation <milliseconds> past the newest snapshot when it is late
+	// Passing --record-trace <file> writes every snapshot received to a trace that trace_bench can replay offline
+	// The server is reached at --server <address> (default 127.0.0.1), --server-tcp-port <port> (default 4445) and
+	// --server-udp-port <port> (default 4444), which can point at the impairment proxy instead
+	LogLevel logLevel = Logger::Instance().GetLevel();
+	int logRateLimit = DEFAULT_LOG_RATE_LIMIT;
+	int benchHistoryFrames = 0;
+	int benchPredictorSamples = 0;
+	PredictorType paddlePredictor = PredictorType::Linear;
+	int paddlePredictionDepth = DEFAULT_PREDICTION_DEPTH;
+	float maxExtrapolation = DEFAULT_MAX_EXTRAPOLATION;
+	std::string recordTracePath;
+	std::string serverAddress = "127.0.0.1";
+	unsigned short serverPort = 4444;
+	unsigned short serverTcpPort = 4445;
+	for (int i = 1; i < argc - 1; i++)
 	{
-		return contact;
-	}
-
-	if (ballRight <= paddleLeft)
-	{
-		return contact;
-	}
-
-	if (ballTop >= paddleBottom)
-	{
-		return contact;
-	}
-
-	if (ballBottom <= paddleTop)
-	{
-		return contact;
+		if (std::string(argv[i]) == "--bench-history")
+		{
+			benchHistoryFrames = atoi(argv[i + 1]);
+		}
+		else if (std::string(argv[i]) == "--bench-predictors")
+		{
+			benchPredictorSamples = atoi(argv[i + 1]);
+		}
+		else if (std::string(argv[i]) == "--paddle-predictor")
+		{
+			ParsePredictorType(argv[i + 1], paddlePredictor);
+		}
+		else if (std::string(argv[i]) == "--paddle-prediction-depth")
+		{
+			paddlePredictionDepth = atoi(argv[i + 1]);
+		}
+		else if (std::string(argv[i]) == "--max-extrapolation")
+		{
+			maxExtrapolation = static_cast<float>(atof(argv[i + 1]));
+		}
+		else if (std::string(argv[i]) == "--record-trace")
+		{
+			recordTracePath = argv[i + 1];
+		}
+		else if (std::string(argv[i]) == "--server")
+		{
+			serverAddress = argv[i + 1];
+		}
+		else if (std::string(argv[i]) == "--server-tcp-port")
+		{
+			serverTcpPort = static_cast<unsigned short>(atoi(argv[i + 1]));
+		}
+		else if (std::string(argv[i]) == "--server-udp-port")
+		{
+			serverPort = static_cast<unsigned short>(atoi(argv[i + 1]));
+		}
+		else if (std::string(argv[i]) == "--log-level")
+		{
+			Logger::ParseLevel(argv[i + 1], logLevel);
+		}
+		else if (std::string(argv[i]) == "--log-rate")
+		{
+			logRateLimit = atoi(argv[i + 1]);
+		}
 	}
 
-	float paddleRangeUpper = paddleBottom - (2.0f * PADDLE_HEIGHT / 3.0f);
-	float paddleRangeMiddle = paddleBottom - (PADDLE_HEIGHT / 3.0f);
-
-	if (ball.position.x < WINDOW_WIDTH/2)
+	if (benchHistoryFrames > 0)
 	{
-		// Left paddle
-		contact.penetration = paddleRight - ballLeft;
-	}
-	else
-	{
-		// Right paddle
-		contact.penetration = paddleLeft - ballRight;
+		RunHistoryBenchmark(benchHistoryFrames);
+		return 0;
 	}
 
-	if ((ballBottom > paddleTop)
-		&& (ballBottom < paddleRangeUpper))
-	{
-		contact.type = Ball::CollisionType::Top;
-	}
-	else if ((ballBottom > paddleRangeUpper)
-		&& (ballBottom < paddleRangeMiddle))
+	if (benchPredictorSamples > 0)
 	{
-		contact.type = Ball::CollisionType::Middle;
-	}
-	else
-	{
-		contact.type = Ball::CollisionType::Bottom;
+		RunPredictorBenchmark(benchPredictorSamples);
+		return 0;
 	}
 
-	return contact;
-}
+	Logger::Instance().SetLevel(logLevel);
+	Logger::Instance().SetRateLimit(logRateLimit);
+	Logger::Instance().Start();
 
-struct Ball::Contact CheckWallCollision(Ball const& ball)
-{
-	float ballLeft = ball.position.x;
-	float ballRight = ball.position.x + BALL_WIDTH;
-	float ballTop = ball.position.y;
-	float ballBottom = ball.position.y + BALL_HEIGHT;	
-
-	Ball::Contact contact{};
-
-	if (ballLeft < 0.0f)
-	{
-		contact.type = Ball::CollisionType::Left;
-	}
-	else if (ballRight > WINDOW_WIDTH)
-	{
-		contact.type = Ball::CollisionType::Right;
-	}
-	else if (ballTop < 0.0f)
-	{
-		contact.type = Ball::CollisionType::Top;
-		contact.penetration = -ballTop;
-	}
-	else if (ballBottom > WINDOW_HEIGHT)
+	TraceWriter traceWriter;
+	if (!recordTracePath.empty() && !traceWriter.Open(recordTracePath))
 	{
-		contact.type = Ball::CollisionType::Bottom;
-		contact.penetration = WINDOW_HEIGHT - ballBottom;
+		LOG_ERROR(LogCategory::General) << "Could not open " << recordTracePath << " to record a trace";
 	}
 
-	return contact;
-}
-
-float lerp(float begin, float end, float t)
-{
-	return begin + t * (end - begin);
-}
-
-int main(int argc, char* argv[])
-{
-	// Start global timer for timestamping messages and logs
-	Uint64 globalTime = SDL_GetTicks();
-
 	// Initialize random seed
 	srand(time(NULL));
 	
@@ -183,43 +157,24 @@ int main(int argc, char* argv[])
 	Mix_Chunk* loseSound = Mix_LoadWAV("lose.wav");
 
 	// Server connection
-	const sf::IpAddress serverIp = "127.0.0.1";
-	const unsigned short serverPort = 4444;
-	const unsigned short serverTcpPort = 4445;
+	const sf::IpAddress serverIp = serverAddress;
 	
 	// Initialize client TCP socket for sending and receiving player score data
 	sf::TcpSocket tcpSocket;
 	sf::Socket::Status status = tcpSocket.connect(serverIp, serverTcpPort);
 	if (status != sf::Socket::Done)
 	{
-		std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-			<< "\t| tcp socket connect error to server at " << serverIp << ":" << serverTcpPort
-			<< std::endl;
+		LOG_ERROR(LogCategory::Network) << "tcp socket connect error to server at " << serverIp.toString() << ":" << serverTcpPort;
 		return 0;
 	}
 
-	// Create a selector
-	sf::SocketSelector selector;
-
-	// Initialize client UDP socket for sending and receiving position data
+	// Initialize client UDP socket for everything sent to and received from the server during a match. It stays
+	// bound for as long as the client runs, and the server tells its datagrams apart by the session ID in them
 	sf::UdpSocket udpSocket;
-	unsigned short port = tcpSocket.getLocalPort(); // use same port as tcp socket
 	udpSocket.setBlocking(false); // make socket non-blocking
-	if (udpSocket.bind(port) != sf::Socket::Done)
+	if (udpSocket.bind(sf::Socket::AnyPort) != sf::Socket::Done) // use OS-allocated port
 	{
-		std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-			<< "\t| udp socket bind error on port " << port
-			<< std::endl;
-	}
-
-	// Initialize client UDP socket for receiving ball position data
-	sf::UdpSocket udpSocketBallPos;
-	udpSocketBallPos.setBlocking(false);
-	if (udpSocketBallPos.bind(sf::Socket::AnyPort) != sf::Socket::Done) // use OS-allocated port
-	{
-		std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-			<< "\t| ball position udp socket bind error"
-			<< std::endl;
+		LOG_ERROR(LogCategory::Network) << "udp socket bind error";
 	}
 
 	// Properties of received messages
@@ -229,8 +184,6 @@ int main(int argc, char* argv[])
 	// Declare variables used to create network messages
 	sf::Packet packet;
 	Message msg;
-	ScoreMessage scores;
-	sf::Uint8 header;	
 
 	// Define buttons
 	enum Buttons
@@ -255,6 +208,10 @@ int main(int argc, char* argv[])
 		Vec2(0.0f, 0.0f)
 	);
 
+	// Either paddle can end up as the opponent, so both get the paddle predictor
+	paddleOne.SetPredictor(paddlePredictor, paddlePredictionDepth);
+	paddleTwo.SetPredictor(paddlePredictor, paddlePredictionDepth);
+
 	// Create the text fields
 	PlayerScore playerOneScoreText(Vec2(WINDOW_WIDTH / 4, 20), renderer, scoreFont);
 	PlayerScore playerTwoScoreText(Vec2(3 * WINDOW_WIDTH / 4, 20), renderer, scoreFont);
@@ -271,17 +228,50 @@ int main(int argc, char* argv[])
 		std::string winnerText = "";
 
 		int assignedPaddle = 0;
+		sf::Uint64 sessionId = 0; // given by the server with the paddle, and sent in every datagram to it
+		uint64_t welcomedSession = 0;
+		bool welcomed = false;
 		Paddle* playerOnePaddle = &paddleOne;
 		Paddle* playerTwoPaddle = &paddleTwo;
 		
 		bool gameStarted = false;
 		bool playerReady = false;
-		std::string oppDisconnected = "";
+		bool opponentDisconnected = false;
 	
-		Ball::Contact contact{};
-		
-		double newestPaddlePosTimestamp = 0;
-		double newestBallPosTimestamp = 0;
+		// Input commands of this client's paddle, starting at sequence 1 each game. Commands are applied to the
+		// paddle straight away and kept until a snapshot shows the server has applied them too
+		std::vector<InputCommand> pendingInputs;
+		InputCommand inputCommand;
+		uint16_t inputSequence = 0;
+		float inputAccumulator = 0.0f; // milliseconds of play not yet turned into input commands
+		bool inputsAdded = false;
+
+		// Snapshots received from the server. The tick of the newest one applied is sent back as the acknowledged
+		// snapshot tick of each input commands message, and 0 means none has been applied yet
+		SnapshotHistory snapshotHistory;
+		WorldSnapshot snapshot;
+		WorldSnapshot receivedSnapshot;
+		bool snapshotReceived = false;
+		uint16_t newestSnapshotTick = 0;
+
+		// In a lockstep match the server sends the inputs of both paddles instead of snapshots, and the match is
+		// simulated here from them. Each tick simulated is taken like a snapshot received
+		LockstepReplay lockstepReplay;
+		bool snapshotDecoded = false;
+
+		// Estimate of the server clock, kept up by clock requests from when the server welcomes this client for as long as
+		// it runs, so snapshots are played out by when the server sent them rather than when they happened to arrive
+		ClockSync clockSync;
+		ClockExchange clockExchange;
+
+		// Control messages from the server (the winner, the opponent disconnecting) arrive reliably and in order
+		// with the snapshots, and are acknowledged straight away
+		ReliableReceiver controlReceiver;
+		std::vector<ControlMessage> controlMessages;
+		bool controlAckDue = false;
+
+		// Heartbeats from the server are echoed straight back, so it can measure the round trip and knows this client is there
+		uint32_t heartbeatTime = 0;
 
 		bool running = true;
 		bool buttons[2] = {};		
@@ -290,10 +280,6 @@ int main(int argc, char* argv[])
 		float dt = 0.004f;
 		Uint64 startTicks = 0;
 		Uint64 endTicks = 0;
-		float sendDt = 0.0f;
-		float sendRate = 100.0f;
-		Uint64 sendStartTicks = SDL_GetTicks();
-		Uint64 sendEndTicks = 0;
 		float logDt = 0.0f;
 		float logRate = 1500.0f;
 		Uint64 logStartTicks = SDL_GetTicks();
@@ -307,80 +293,61 @@ int main(int argc, char* argv[])
 
 		// Prediction and interpolation variables
 		bool enablePandI = true;
-		int numPredictions = 0;
-		Message msgBasedPrediction{};
-		Message predictionBasedPrediction{};
-		Message validPredictionMsg{};
-		Message ballPosition{};
-		Message positionBasedPrediction{};
-		Vec2 validPrediction{};
-		Vec2 validPrediction2{};
-		float averagePredictionX = 0;
-		float averagePredictionY = 0;
-		float interpolatedPositionX = 0;
-		float interpolatedPositionY = 0;
-		float interpolationPcntg = 0.005;	
+
+		// Snapshots waiting to be drawn. The ball and the opponent paddle are drawn at the render time of the buffer,
+		// between the snapshots either side of it, while this client's paddle stays reconciled to the newest snapshot
+		PlayoutBuffer playoutBuffer(maxExtrapolation);
+		FrameView frameView;
+		const WorldSnapshot* drawnSnapshot = NULL;
+		BallState ballProjected{ ball.position, Vec2(0.0f, 0.0f) };
+
+		// Extra balls of a multi-ball match, drawn at the same tick as the snapshot
+		ExtraBalls extraBalls;
+		BallsMessage ballsMessage;
+		std::vector<Vec2> extraBallPositions;
 		
 		// Continue looping and processing events until user exits
 		while (running)
 		{			
 			startTicks = SDL_GetTicks();			
 
+			// Synchronize with the server clock. Responses come back with the snapshots. The server only answers a session
+			// that has said hello, so requests wait for the welcome
+			if (welcomed && clockSync.ShouldSend(static_cast<double>(SDL_GetTicks())))
+			{
+				packet.clear();
+				clockSync.WriteRequest(packet, sessionId, static_cast<double>(SDL_GetTicks()));
+				if (udpSocket.send(packet, serverIp, serverPort) != sf::Socket::Done)
+				{
+					//LOG_ERROR(LogCategory::Network) << "udp socket send error";
+				}
+			}
+
 			// Get paddle number from server and wait for confirmation of other player ready before starting game
 			// socket is in blocking mode so game can't start until certain messages sent/received
 			if(assignedPaddle == 0)
 			{				
-				// Server closes connections to all clients when any client disconnects, so reconnection to server and udp rebind required
-				if (oppDisconnected == "opponent disconnected")
+				// Server closes connections to all clients when any client disconnects, so reconnection to server required
+				if (opponentDisconnected)
 				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Opponent disconnected. Reconnecting tcp socket to " << serverIp << " at port " << serverTcpPort
-						<< std::endl;
+					LOG_INFO(LogCategory::Network) << "Opponent disconnected. Reconnecting tcp socket to " << serverIp.toString() << " at port " << serverTcpPort;
 					
 					sf::Socket::Status status = tcpSocket.connect(serverIp, serverTcpPort);
 					if (status != sf::Socket::Done)
 					{
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| tcp socket connect error to " << serverIp << ":" << serverTcpPort
-							<< std::endl;
+						LOG_ERROR(LogCategory::Network) << "tcp socket connect error to " << serverIp.toString() << ":" << serverTcpPort;
 					}
 
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Bind paddle position udp socket to new tcp port (" << tcpSocket.getLocalPort() << ")"
-						<< std::endl;
-
-					port = tcpSocket.getLocalPort();
-					if (udpSocket.bind(port) != sf::Socket::Done)
-					{
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| udp socket bind error on port " << port
-							<< std::endl;
-					}
-
-					oppDisconnected = "";
+					opponentDisconnected = false;
 					mainMenuText.SetText(Vec2(WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2 - 15), "Opponent disconnected! [Enter] to play again");
 				}
-				// Server disconnects clients after game ends normally, so reconnect and udp rebind required
+				// Server disconnects clients after game ends normally, so reconnect required
 				else if (winner) 
 				{
 					sf::Socket::Status status = tcpSocket.connect(serverIp, serverTcpPort);
 					if (status != sf::Socket::Done)
 					{
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| tcp socket connect error to " << serverIp << ":" << serverTcpPort
-							<< std::endl;
-					}
-
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Bind paddle position udp socket to new tcp port (" << tcpSocket.getLocalPort() << ")"
-						<< std::endl;
-
-					port = tcpSocket.getLocalPort();
-					if (udpSocket.bind(port) != sf::Socket::Done)
-					{
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| udp socket bind error on port " << port
-							<< std::endl;
+						LOG_ERROR(LogCategory::Network) << "tcp socket connect error to " << serverIp.toString() << ":" << serverTcpPort;
 					}
 
 					winner = 0;
@@ -435,26 +402,20 @@ int main(int argc, char* argv[])
 				SDL_RenderPresent(renderer);
 				
 				// Wait to receive packet with paddle number from server
-				std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-					<< "\t| Waiting for server to assign paddle..."
-					<< std::endl;
+				LOG_INFO(LogCategory::Network) << "Waiting for server to assign paddle...";
 				
 				packet.clear();
 				if (tcpSocket.receive(packet) != sf::Socket::Done)
 				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| tcp socket receive error"
-						<< std::endl;
+					LOG_ERROR(LogCategory::Network) << "tcp socket receive error";
 				}
 
 				// Set this client's paddle number and assign each paddle to player pointers
 				if (packet.getDataSize() > 0)
 				{
-					packet >> assignedPaddle;
+					packet >> assignedPaddle >> sessionId;
 
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Assigned paddle = " << assignedPaddle
-						<< std::endl;
+					LOG_INFO(LogCategory::Network) << "Assigned paddle = " << assignedPaddle << "; Session=" << sessionId;
 
 					if (assignedPaddle == 1)
 					{
@@ -468,38 +429,50 @@ int main(int argc, char* argv[])
 					}
 				}
 
-				// Send udp ball position socket's port number to server using existing tcp connection
-				std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-					<< "\t| Sending udp ball position socket port number (" << udpSocketBallPos.getLocalPort() << ") to server"
-					<< std::endl;
+				// Say hello over udp until the server welcomes the session, which tells it where the udp socket is and
+				// that this client is ready. Either datagram may be lost, so the hello is resent every HELLO_INTERVAL.
+				// Anything else arriving in the meantime is left over from the last game and dropped
+				LOG_INFO(LogCategory::Network) << "Saying hello from udp port " << udpSocket.getLocalPort() << "...";
 
-				packet.clear();
-				packet << udpSocketBallPos.getLocalPort();
-				if (tcpSocket.send(packet) != sf::Socket::Done)
+				welcomed = false;
+				for (int attempt = 0; attempt < HELLO_ATTEMPTS && !welcomed; attempt++)
+				{
+					packet.clear();
+					WriteSessionMessage(packet, MessageType::Hello, sessionId);
+					if (udpSocket.send(packet, serverIp, serverPort) != sf::Socket::Done)
+					{
+						LOG_ERROR(LogCategory::Network) << "udp socket send error";
+					}
+
+					Uint64 helloTicks = SDL_GetTicks();
+					while (!welcomed && SDL_GetTicks() - helloTicks < HELLO_INTERVAL)
+					{
+						packet.clear();
+						if (udpSocket.receive(packet, receiveIp, receivePort) != sf::Socket::Done)
+						{
+							SDL_Delay(1);
+						}
+						else if (ReadSessionMessage(packet, MessageType::Welcome, welcomedSession) && welcomedSession == sessionId)
+						{
+							welcomed = true;
+						}
+					}
+				}
+
+				if (!welcomed)
 				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| tcp socket send error"
-						<< std::endl;
+					LOG_ERROR(LogCategory::Network) << "No welcome from the server after " << HELLO_ATTEMPTS << " hellos";
 				}
 
 				// Wait for server message to confirm other player ready (tcp socket is in blocking mode)
-				std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-					<< "\t| Waiting for server confirm game start..."
-					<< std::endl;
+				LOG_INFO(LogCategory::Network) << "Waiting for server confirm game start...";
 				packet.clear();
 				if (tcpSocket.receive(packet) != sf::Socket::Done)
 				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| tcp socket receive error"
-						<< std::endl;
+					LOG_ERROR(LogCategory::Network) << "tcp socket receive error";
 				}
 				
-				// Add tcp socket to selector to stop it blocking if there is no data to send/receive when game is running
-				selector.add(tcpSocket);
-				
-				std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-					<< "\t| Starting game..."
-					<< std::endl;
+				LOG_INFO(LogCategory::Match) << "Starting game...";
 			}
 
 			// Poll for pending key press or SQL_QUIT event
@@ -564,621 +537,388 @@ int main(int argc, char* argv[])
 				}
 			}
 
-			// Change paddle velocity based on key pressed
-			if (buttons[Buttons::PaddleUp])
+			// Turn the keys held into an input command for every input tick that has passed, and move the paddle
+			// by each one straight away rather than waiting for the server. After a long frame only a few ticks are caught up
+			inputAccumulator = std::min(inputAccumulator + dt, 5 * INPUT_DT);
+			inputsAdded = false;
+			while (inputAccumulator >= INPUT_DT)
 			{
-				playerOnePaddle->velocity.y = -PADDLE_SPEED;
-			}
-			else if (buttons[Buttons::PaddleDown])
-			{
-				playerOnePaddle->velocity.y = PADDLE_SPEED;
+				inputAccumulator -= INPUT_DT;
+
+				inputCommand.sequence = ++inputSequence;
+				if (buttons[Buttons::PaddleUp])
+				{
+					inputCommand.input = PaddleInput::Up;
+				}
+				else if (buttons[Buttons::PaddleDown])
+				{
+					inputCommand.input = PaddleInput::Down;
+				}
+				else
+				{
+					inputCommand.input = PaddleInput::None;
+				}
+
+				playerOnePaddle->Move(inputCommand.input, INPUT_DT);
+				pendingInputs.push_back(inputCommand);
+				inputsAdded = true;
 			}
-			else
+
+			// Only the newest commands fit in a message, so older ones can be forgotten if the server stops acknowledging
+			if (static_cast<int>(pendingInputs.size()) > MAX_INPUTS_PER_MESSAGE)
 			{
-				playerOnePaddle->velocity.y = 0.0f;
+				pendingInputs.erase(pendingInputs.begin(), pendingInputs.end() - MAX_INPUTS_PER_MESSAGE);
 			}
 
-			// Update player one position and send to server
-			playerOnePaddle->Update(dt);
-			
-			sendEndTicks = SDL_GetTicks();
-			sendDt = (sendEndTicks - sendStartTicks);
-			if(sendDt > sendRate) // If sendRate milliseconds passed since last sent paddle position, send again
+			// Send every unacknowledged command with the tick of the newest snapshot applied, so a lost message loses nothing
+			if (inputsAdded)
 			{
-				// Send paddle position to server	
 				packet.clear();
-				msg.timestamp = static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0);
-				msg.port = port;
-				msg.x = playerOnePaddle->position.x;
-				msg.y = playerOnePaddle->position.y;				
-				msg.ball = false;
-				packet << msg;
-				
+				WriteInputs(packet, sessionId, newestSnapshotTick, pendingInputs.data(), static_cast<int>(pendingInputs.size()));
+
 				logEndTicks = SDL_GetTicks();
 				logDt = (logEndTicks - logStartTicks);
 				if (logDt > logRate) // If logRate milliseconds passed since log timer last reset, print to console
 				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Sending paddle position message: Timestamp=" << msg.timestamp
-						<< "; Port=" << msg.port
-						<< "; x=" << msg.x << "; y=" << msg.y
-						<< "; ball=" << msg.ball
-						<< std::endl;
+					LOG_DEBUG(LogCategory::Input) << "Sending input commands: Newest=" << inputSequence
+						<< "; Unacknowledged=" << pendingInputs.size()
+						<< "; Tick=" << newestSnapshotTick
+						<< "; y=" << playerOnePaddle->position.y;
 				}
 
 				if (udpSocket.send(packet, serverIp, serverPort) != sf::Socket::Done)
 				{
-					//std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						//<< "\t| udp socket send error"
-						//<< std::endl;
+					//LOG_ERROR(LogCategory::Network) << "udp socket send error";
 				}
-				
-				// Reset send rate timer
-				sendStartTicks = SDL_GetTicks();
 			}
 
-			if (enablePandI)
-			{
-				// Predict position of player two paddle based on prevous messages
-				msgBasedPrediction = playerTwoPaddle->RunPrediction(static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0), false);
-
-				// If message based prediction is different to the previous one, add to predictions
-				numPredictions = playerTwoPaddle->paddlePredictions.size();
-				if (numPredictions > 0)
-				{
-					if (msgBasedPrediction.y != playerTwoPaddle->paddlePredictions[numPredictions - 1].y)
-					{
-						playerTwoPaddle->AddPrediction(msgBasedPrediction);
-					}
-				}
-				else
-				{
-					playerTwoPaddle->AddPrediction(msgBasedPrediction);
-				}
-
-				// Predict position based on previous predictions				
-				predictionBasedPrediction = playerTwoPaddle->RunPrediction(static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0), true);
-				playerTwoPaddle->AddPrediction(predictionBasedPrediction);
-
-				// Get average of messages-based and predictions-based predicted positions
-				averagePredictionY = (msgBasedPrediction.y + predictionBasedPrediction.y) / 2.0;
-
-				// Move percentage towards average of predictions
-				interpolatedPositionY = lerp(playerTwoPaddle->position.y, averagePredictionY, interpolationPcntg);
-				
-				playerTwoPaddle->position.y = interpolatedPositionY;
-
-				if (logDt > logRate)
-				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Predicted position of player two paddle: "
-						<< "message-based prediction y = " << msgBasedPrediction.y << "; "
-						<< "prediction-based prediction y = " << predictionBasedPrediction.y << "; "
-						<< "interpolated position y = " << interpolatedPositionY
-						<< std::endl;
-				}
-			}
-			
-			// Receive position of paddle two from server
+			// Receive every pending snapshot from the server. Each one is decoded against the snapshot it is a delta of
+			// and kept as a baseline for later deltas, and goes into the playout buffer to be drawn when its time comes.
+			// This client's paddle is reconciled to the newest. Ticks of a lockstep match are taken as soon as they are simulated.
+			// Clock responses, extra balls and control messages come on the same socket and are taken on the way
+			snapshotReceived = false;
 			packet.clear();
-			msg.timestamp = 0;
-			msg.port = 0;
-			msg.x = playerTwoPaddle->position.x;
-			msg.y = playerTwoPaddle->position.y;
-			msg.ball = false;			
-			
-			if (logDt > logRate)
-			{
-				std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-					<< "\t| Receiving paddle position message from server..."
-					<< std::endl;
-			}
 
-			// Receive new paddle position message
-			if (udpSocket.receive(packet, receiveIp, receivePort) != sf::Socket::Done)
+			while (true)
 			{
-				//std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-					//<< "\t| udp socket receive error"
-					//<< std::endl;
-			}
-
-			// Update player two paddle position based on new messages
-			if (packet.getDataSize() > 0)
-			{				
-				packet >> msg;	
-				msg.timestamp = static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0); // change timestamp to this client's time
-
-				if (!msg.ball)
+				snapshotDecoded = lockstepReplay.Next(receivedSnapshot);
+				if (!snapshotDecoded)
 				{
-					if (logDt > logRate)
+					if (udpSocket.receive(packet, receiveIp, receivePort) != sf::Socket::Done)
 					{
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| Received paddle position message from " << receiveIp << " on port " << receivePort
-							<< std::endl;
-
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| Timestamp=" << msg.timestamp
-							<< "; Port=" << msg.port
-							<< "; x=" << msg.x << "; y=" << msg.y
-							<< "; ball=" << msg.ball
-							<< std::endl;
+						break;
 					}
 
-					if (msg.timestamp > newestPaddlePosTimestamp)
+					if (packet.getDataSize() > 0
+						&& (static_cast<const uint8_t*>(packet.getData())[0] & 0x0F) == static_cast<uint8_t>(MessageType::ClockResponse))
 					{
-						newestPaddlePosTimestamp = msg.timestamp;
-						// Add message to history of player two position messages
-						playerTwoPaddle->AddMessage(msg);
-
-						// Move percentage towards new position received from server
-						if (enablePandI)
+						if (ReadClockResponse(packet, clockExchange))
 						{
-							interpolatedPositionY = lerp(playerTwoPaddle->position.y, msg.y, interpolationPcntg);
+							clockSync.AddResponse(clockExchange, static_cast<double>(SDL_GetTicks()));
 
-							if (logDt > logRate)
-							{
-								std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-									<< "\t| Moving player two paddle to interpolated position y=" << interpolatedPositionY
-									<< std::endl;
-							}
-
-							playerTwoPaddle->position.y = interpolatedPositionY;
+							LOG_DEBUG(LogCategory::Network) << "Clock sync: Offset=" << clockSync.Offset() << "ms"
+								<< "; Drift=" << clockSync.Drift() * 1.0e6 << "ppm; RoundTrip=" << clockSync.RoundTripTime() << "ms";
 						}
-						else // Move straight to received position for player two paddle
+					}
+					else if (packet.getDataSize() > 0
+						&& (static_cast<const uint8_t*>(packet.getData())[0] & 0x0F) == static_cast<uint8_t>(MessageType::Balls))
+					{
+						if (ReadBalls(packet, ballsMessage))
+						{
+							extraBalls.Add(ballsMessage);
+						}
+					}
+					else if (packet.getDataSize() > 0
+						&& (static_cast<const uint8_t*>(packet.getData())[0] & 0x0F) == static_cast<uint8_t>(MessageType::Control))
+					{
+						controlAckDue = controlReceiver.Read(packet, controlMessages) || controlAckDue;
+					}
+					else if (packet.getDataSize() > 0
+						&& (static_cast<const uint8_t*>(packet.getData())[0] & 0x0F) == static_cast<uint8_t>(MessageType::Heartbeat))
+					{
+						// Echo heartbeats as soon as they are read, as the server takes the time they are away as the round trip
+						if (ReadHeartbeat(packet, heartbeatTime))
 						{
-							if (logDt > logRate)
+							packet.clear();
+							WriteHeartbeatEcho(packet, sessionId, heartbeatTime);
+							if (udpSocket.send(packet, serverIp, serverPort) != sf::Socket::Done)
 							{
-								std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-									<< "\t| Moving player two paddle to y=" << msg.y
-									<< std::endl;
+								//LOG_ERROR(LogCategory::Network) << "udp socket send error";
 							}
-
-							playerTwoPaddle->position.y = msg.y;
 						}
 					}
+					else if (!lockstepReplay.Read(packet))
+					{
+						snapshotDecoded = ReadSnapshot(packet, snapshotHistory, receivedSnapshot);
+					}
 				}
-			}
 
-			if (enablePandI)
-			{
-				// Predict position of ball based on prevous messages
-				msgBasedPrediction = ball.RunPrediction(static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0), 0, ball);
-
-				// Check for ball phasing through paddle and correct
-				validPrediction =
-					ball.ValidatePrediction(
-						ball,
-						msgBasedPrediction.x,
-						msgBasedPrediction.y,
-						paddleOne.position.x,
-						paddleOne.position.y,
-						paddleTwo.position.x,
-						paddleTwo.position.y
-					);
-
-				// Store validated prediction as message
-				validPredictionMsg.timestamp = static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0);
-				validPredictionMsg.x = validPrediction.x;
-				validPredictionMsg.y = validPrediction.y;
-				validPredictionMsg.ball = true;
-				validPredictionMsg.port = 0;
-				
-				// If validated messages-based prediction is different to the previous one, add to predictions
-				numPredictions = ball.ballPredictions.size();
-				if (numPredictions > 0)
+				if (snapshotDecoded)
 				{
-					if (Vec2(validPrediction.x, validPrediction.y) != Vec2(ball.ballPredictions[numPredictions - 1].x, ball.ballPredictions[numPredictions - 1].y))
+					snapshotHistory.Store(receivedSnapshot);
+					double arrival = static_cast<double>(SDL_GetTicks());
+					if (clockSync.Synchronized())
 					{
-						ball.AddPrediction(validPredictionMsg);
+						playoutBuffer.Add(receivedSnapshot, arrival,
+							clockSync.ToLocalTime(clockSync.UnwrapServerTime(static_cast<uint16_t>(receivedSnapshot.time), arrival)));
 					}
-				}
-				else
-				{
-					ball.AddPrediction(validPredictionMsg);
+					else
+					{
+						playoutBuffer.Add(receivedSnapshot, arrival);
+					}
+					traceWriter.Write(receivedSnapshot, static_cast<double>(SDL_GetTicks()));
 
+					// Drop duplicates and snapshots that arrived out of order
+					if (newestSnapshotTick == 0 || SequenceGreaterThan(static_cast<uint16_t>(receivedSnapshot.tick), newestSnapshotTick))
+					{
+						newestSnapshotTick = static_cast<uint16_t>(receivedSnapshot.tick);
+						snapshot = receivedSnapshot;
+						snapshotReceived = true;
+					}
 				}
 
-				// Predict position based on previous predictions
-				predictionBasedPrediction = ball.RunPrediction(static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0), 1, ball);
-
-				// Validate predictions-based prediction (check for paddle phase)
-				validPrediction2 =
-					ball.ValidatePrediction(
-						ball,
-						predictionBasedPrediction.x,
-						predictionBasedPrediction.y,
-						paddleOne.position.x,
-						paddleOne.position.y,
-						paddleTwo.position.x,
-						paddleTwo.position.y
-					);
-				
-				/*validPredictionMsg.timestamp = static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0);
-				validPredictionMsg.x = validPrediction2.x;
-				validPredictionMsg.y = validPrediction2.y;
-				validPredictionMsg.ball = true;
-				validPredictionMsg.port = 0;*/
-
-				// If validated predictions-based prediction is different to previous prediction, add to predictions history
-				/*numPredictions = ball.ballPredictions.size();
-				if (numPredictions > 0)
+				packet.clear();
+			}
+
+			// Acknowledge control messages as soon as they arrive, so the server does not resend them
+			if (controlAckDue)
+			{
+				packet.clear();
+				WriteControlAck(packet, sessionId, controlReceiver.Acknowledged());
+				if (udpSocket.send(packet, serverIp, serverPort) != sf::Socket::Done)
 				{
-					if (Vec2(validPrediction2.x, validPrediction2.y) != Vec2(ball.ballPredictions[numPredictions - 1].x, ball.ballPredictions[numPredictions - 1].y))
-					{						
-						ball.AddPrediction(validPredictionMsg);
-					}
+					//LOG_ERROR(LogCategory::Network) << "udp socket send error";
 				}
-				else
-				{
-					ball.AddPrediction(validPredictionMsg);
-				}*/
-
-				// Get average of messages-based prediction and predictions-based prediction
-				averagePredictionX = (validPrediction.x + validPrediction2.x) / 2.0;
-				averagePredictionY = (validPrediction.y + validPrediction2.y) / 2.0;
 
-				// Move percentage towards average of predictions
-				interpolatedPositionX = lerp(ball.position.x, averagePredictionX, interpolationPcntg);
-				interpolatedPositionY = lerp(ball.position.y, averagePredictionY, interpolationPcntg);
+				controlAckDue = false;
+			}
 
+			if (snapshotReceived)
+			{
 				if (logDt > logRate)
 				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Predicted position of ball: "
-						<< "message-based prediction = (" << validPrediction.x << "," << validPrediction.y << ")" << "; "
-						<< "prediction-based prediction = (" << validPrediction2.x << "," << validPrediction2.y << ")" << "; "
-						<< "interpolated position = (" << interpolatedPositionX << "," << interpolatedPositionY << ")"
-						<< std::endl;
+					LOG_DEBUG(LogCategory::Snapshot) << "Received snapshot: Tick=" << snapshot.tick
+						<< "; Latency=" << (clockSync.Synchronized()
+							? SDL_GetTicks() - clockSync.ToLocalTime(clockSync.UnwrapServerTime(static_cast<uint16_t>(snapshot.time), static_cast<double>(SDL_GetTicks())))
+							: 0.0) << "ms"
+						<< "; Ball=(" << snapshot.ballX << "," << snapshot.ballY << ")"
+						<< "; PaddleOne=" << snapshot.paddleOneY << "; PaddleTwo=" << snapshot.paddleTwoY
+						<< "; Scores=" << static_cast<int>(snapshot.playerOneScore) << "-" << static_cast<int>(snapshot.playerTwoScore);
 				}
 
-				ball.position.x = interpolatedPositionX;
-				ball.position.y = interpolatedPositionY;
-			}
-		
-			// Receive position of ball from server
-			packet.clear();
-			msg.timestamp = 0;
-			msg.port = 0;
-			msg.x = 0;
-			msg.y = 0;
-			msg.ball = false;
+				// Reconcile this client's paddle: start from where the server has it after the newest input command it
+				// applied, forget the commands it has applied, and replay the ones it has not reached yet
+				while (!pendingInputs.empty() && !SequenceGreaterThan(pendingInputs.front().sequence, snapshot.inputAck))
+				{
+					pendingInputs.erase(pendingInputs.begin());
+				}
 
-			if (logDt > logRate)
-			{
-				std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-					<< "\t| Receiving ball position message..."
-					<< std::endl;
+				playerOnePaddle->position.y = (playerOnePaddle == &paddleOne) ? snapshot.paddleOneY : snapshot.paddleTwoY;
+				for (const InputCommand& command : pendingInputs)
+				{
+					playerOnePaddle->Move(command.input, INPUT_DT);
+				}
+
+				// Convert the opponent's paddle to a message timestamped with when the snapshot is due to be drawn, so the
+				// paddle predictor can carry it on past the newest snapshot on the same timeline as the playout buffer
+				msg.timestamp = playoutBuffer.NewestPlayoutTime() / 1000.0;
+				msg.port = receivePort;
+				msg.x = playerTwoPaddle->position.x;
+				msg.y = (playerTwoPaddle == &paddleOne) ? snapshot.paddleOneY : snapshot.paddleTwoY;
+				msg.ball = false;
+
+				// Add message to history of player two position messages
+				playerTwoPaddle->paddleMessages.Add(msg);
 			}
 
-			if (udpSocketBallPos.receive(packet, receiveIp, receivePort) != sf::Socket::Done)
+			// Apply the whole snapshot drawn at once, so that the ball, opponent paddle and scores shown are all from the same tick
+			// Without prediction and interpolation the newest snapshot is drawn as it is
+			drawnSnapshot = NULL;
+			if (ViewFrame(playoutBuffer, static_cast<double>(SDL_GetTicks()), (playerTwoPaddle == &paddleOne) ? 1 : 2,
+				playerTwoPaddle->position.x, playerOnePaddle->position, *playerTwoPaddle->predictor, playerTwoPaddle->paddleMessages, frameView))
 			{
-				//std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-					//<< "\t| udp ball position socket receive error"
-					//<< std::endl;
+				drawnSnapshot = enablePandI ? frameView.sample.from : &snapshot;
 			}
 
-			// Update ball position
-			if (packet.getDataSize() > 0)
+			if (drawnSnapshot != NULL)
 			{
-				packet >> msg;
-				msg.timestamp = static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0); // change timestamp to this client's time
-
-				if (msg.ball)
-				{					
-					if (logDt > logRate)
-					{
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| Received ball position message " << receiveIp << " on port " << receivePort
-							<< std::endl;
-
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| Timestamp=" << msg.timestamp
-							<< "; Port=" << msg.port
-							<< "; x=" << msg.x << "; y=" << msg.y
-							<< "; ball=" << msg.ball
-							<< std::endl;
-					}			
-
-					if (msg.timestamp > newestBallPosTimestamp)
-					{
-						newestBallPosTimestamp = msg.timestamp;
-						// Add message to history of ball position messages
-						ball.AddMessage(msg);
-
-						// Move percentage towards new position received from server
-						if (enablePandI)
-						{
-							// If ball has moved to center of the screen after a player has scored, don't interpolate or predict
-							if (std::fabs(msg.x - ball.position.x) >= (WINDOW_WIDTH / 2 - BALL_WIDTH * 2))
-							{
-								std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-									<< "\t| Ball position reset after goal"
-									<< std::endl;
-
-								ball.position.x = msg.x;
-								ball.position.y = msg.y;
-								ball.ballMessages.clear();
-								ball.ballPredictions.clear();
-							}
-							else
-							{
-								// Interpolate new x and y positions and move ball there
-								interpolatedPositionX = lerp(ball.position.x, msg.x, interpolationPcntg);
-								interpolatedPositionY = lerp(ball.position.y, msg.y, interpolationPcntg);
-								;
-								if (logDt > logRate)
-								{
-									std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-										<< "\t| Moving ball towards latest received position via interpolation: "
-										<< "(" << interpolatedPositionX << "," << interpolatedPositionY << ")"
-										<< std::endl;
-								}
-
-								ball.position.x = interpolatedPositionX;
-								ball.position.y = interpolatedPositionY;
-							}
-						}
-						else
-						{
-							if (logDt > logRate)
-							{
-								std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-									<< "\t| Moving ball to latest received position: "
-									<< "(" << interpolatedPositionX << "," << interpolatedPositionY << ")"
-									<< std::endl;
-							}
-
-							// Move ball directly to received position if prediction and interpolation toggled off
-							ball.position.x = msg.x;
-							ball.position.y = msg.y;
-						}
-					}
-				}
-			}									
-
-			// Collision checking
-			contact = {};
-
-			collisionEndTicks = SDL_GetTicks();
-			collisionDt = (collisionEndTicks - collisionStartTicks);
-			if (collisionDt > collisionRate) // To prevent multiple collision sounds being played in quick succession, limit number of collisions per unit of time
-			{												
-				if (contact = CheckPaddleCollision(ball, paddleOne); contact.type != Ball::CollisionType::None)
+				if (enablePandI)
 				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Paddle one collision detected"
-						<< std::endl;
-					
-					ball.CollideWithPaddle(contact);
-					Mix_PlayChannel(-1, paddleHitSound, 0);
-
-					collisionStartTicks = SDL_GetTicks();
+					playerTwoPaddle->position.y = frameView.opponentY;
+					ballProjected = frameView.ball;
 				}
-				else if (contact = CheckPaddleCollision(ball, paddleTwo); contact.type != Ball::CollisionType::None)
+				else
 				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Paddle two collision detected"
-						<< std::endl;
-					
-					ball.CollideWithPaddle(contact);
-					Mix_PlayChannel(-1, paddleHitSound, 0);
-
-					collisionStartTicks = SDL_GetTicks();
+					playerTwoPaddle->position.y = (playerTwoPaddle == &paddleOne) ? (*drawnSnapshot).paddleOneY : (*drawnSnapshot).paddleTwoY;
+					ballProjected.position = Vec2((*drawnSnapshot).ballX, (*drawnSnapshot).ballY);
+					ballProjected.velocity = Vec2((*drawnSnapshot).ballVelocityX, (*drawnSnapshot).ballVelocityY);
 				}
-				else if (contact = CheckWallCollision(ball); contact.type != Ball::CollisionType::None)
+
+				if (logDt > logRate)
 				{
-					ball.CollideWithWall(contact);
-					Mix_PlayChannel(-1, wallHitSound, 0);
+					LOG_DEBUG(LogCategory::Prediction) << "Drawing snapshot " << (*drawnSnapshot).tick
+						<< (frameView.sample.to != NULL ? " interpolated" : " extrapolated") << " by " << frameView.sample.elapsed << "ms"
+						<< "; Delay=" << playoutBuffer.Delay() << "ms; Jitter=" << playoutBuffer.Jitter() << "ms"
+						<< "; TickInterval=" << playoutBuffer.TickInterval() << "ms; SnapshotInterval=" << playoutBuffer.SnapshotInterval() << "ms"
+						<< "; PaddleTwo y=" << playerTwoPaddle->position.y;
+				}
 
-					collisionStartTicks = SDL_GetTicks();
-				}				
-			}
+				playerOneScore = (*drawnSnapshot).playerOneScore;
+				playerTwoScore = (*drawnSnapshot).playerTwoScore;
 
-			/*	Update ball position
-			* 
-			*	Required because ball may have changed direction as the result of a collision and
-			*	should continue moving in that direction (client ignores ball velocity property to
-			*	prevent case where ball oscillates due to delay between client and server collisions)
-			*/
-			
-			// Add current position to history of positions
-			ballPosition.timestamp = static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0);
-			ballPosition.port = 0;
-			ballPosition.x = ball.position.x;
-			ballPosition.y = ball.position.y;
-			ballPosition.ball = true;
+				// Extra balls are projected the same way, from the newest tick of them at or before the drawn snapshot
+				extraBallPositions.clear();
+				uint16_t ballsTick = 0;
+				const std::vector<BallState>* balls = extraBalls.Find(static_cast<uint16_t>((*drawnSnapshot).tick), ballsTick);
+				if (balls != NULL)
+				{
+					float elapsed = enablePandI
+						? frameView.sample.elapsed + static_cast<uint16_t>((*drawnSnapshot).tick - ballsTick) * playoutBuffer.TickInterval()
+						: 0.0f;
+					for (const BallState& extraBall : *balls)
+					{
+						extraBallPositions.push_back(ProjectBall(extraBall, elapsed, paddleOne.position, paddleTwo.position).position);
+					}
+				}
+			}
 
-			if (logDt > logRate)
+			if (std::fabs(ballProjected.position.x - ball.position.x) >= (WINDOW_WIDTH / 2 - BALL_WIDTH * 2))
 			{
-				std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-					<< "\t| Adding current ball position to history: (" << ballPosition.x << "," << ballPosition.y << ")"
-					<< std::endl;
+				LOG_INFO(LogCategory::Prediction) << "Ball position reset after goal";
 			}
+			else
+			{
+				// The ball turning round is a collision. To prevent multiple collision sounds being played in quick
+				// succession when a snapshot disagrees with the projection about a bounce, limit collisions per unit of time
+				collisionEndTicks = SDL_GetTicks();
+				collisionDt = (collisionEndTicks - collisionStartTicks);
+				if (collisionDt > collisionRate)
+				{
+					if (ballProjected.velocity.x * ball.velocity.x < 0.0f)
+					{
+						LOG_INFO(LogCategory::Match) << ((ballProjected.position.x < WINDOW_WIDTH / 2) ? "Paddle one" : "Paddle two") << " collision detected";
 
-			ball.AddPosition(ballPosition);
-
-			// Predict new position based on previous positions and interpolate between current position and prediction
-			positionBasedPrediction = ball.RunPrediction(static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0), 2, ball);
-			interpolatedPositionX = lerp(ball.position.x, positionBasedPrediction.x, interpolationPcntg);
-			interpolatedPositionY = lerp(ball.position.y, positionBasedPrediction.y, interpolationPcntg);
-			
-			// Validate prediction in case of paddle phase
-			validPrediction =
-				ball.ValidatePrediction(
-					ball,
-					interpolatedPositionX,
-					interpolatedPositionY,
-					paddleOne.position.x,
-					paddleOne.position.y,
-					paddleTwo.position.x,
-					paddleTwo.position.y
-				);
-
-			// Add validated prediction to history of predictions
-			validPredictionMsg.timestamp = static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0);
-			validPredictionMsg.x = validPrediction.x;
-			validPredictionMsg.y = validPrediction.y;
-			validPredictionMsg.ball = true;
-			validPredictionMsg.port = 0;
-
-			ball.AddPrediction(validPredictionMsg);
+						Mix_PlayChannel(-1, paddleHitSound, 0);
+						collisionStartTicks = SDL_GetTicks();
+					}
+					else if (ballProjected.velocity.y * ball.velocity.y < 0.0f)
+					{
+						Mix_PlayChannel(-1, wallHitSound, 0);
+						collisionStartTicks = SDL_GetTicks();
+					}
+				}
+			}
 
 			if (logDt > logRate)
 			{
-				std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-					<< "\t| Moving ball percentage towards history-based predicted position: (" << interpolatedPositionX << "," << interpolatedPositionY << ")"
-					<< std::endl;
+				LOG_DEBUG(LogCategory::Prediction) << "Projected position of ball: (" << ballProjected.position.x << "," << ballProjected.position.y << ")";
 			}
 
-			// Set ball position to new valid prediction (that was based on history of positions)
-			ball.position = validPrediction;
-
-			// Add new position to history of positions
-			ballPosition.timestamp = static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0);
-			ballPosition.port = 0;
-			ballPosition.x = ball.position.x;
-			ballPosition.y = ball.position.y;
-			ballPosition.ball = true;
+			ball.position = ballProjected.position;
+			ball.velocity = ballProjected.velocity;
 
-			ball.AddPosition(ballPosition);
-
-			// Receive player scores or opponent disconnected message from server and update
-			if (selector.wait(sf::microseconds(1)))
+			// Act on the control messages received this frame: the winner, or the opponent disconnecting
+			for (const ControlMessage& control : controlMessages)
 			{
-				if (selector.isReady(tcpSocket))
+				switch (control.opcode)
 				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Receiving score message from server"
-						<< std::endl;
+				case ControlOpcode::OpponentDisconnected:
+					LOG_INFO(LogCategory::Network) << "Received opponent disconnected message";
+					LOG_INFO(LogCategory::Match) << "Resetting the game";
+
+					// Reset game
+					opponentDisconnected = true;
+					gameStarted = false;
+					playerReady = false;
+					assignedPaddle = 0;
+					winner = 0;
+					playerTwoPaddle->paddleMessages.Clear();
+					paddleOne.position = Vec2(50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
+					paddleTwo.position = Vec2(WINDOW_WIDTH - 50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
+					ball.position = Vec2((WINDOW_WIDTH / 2.0f) - (BALL_WIDTH / 2.0f), (WINDOW_HEIGHT / 2.0f) - (BALL_WIDTH / 2.0f));
+					ballProjected = { ball.position, Vec2(0.0f, 0.0f) };
+					playerOneScore = 0;
+					playerTwoScore = 0;
+					inputSequence = 0;
+					inputAccumulator = 0.0f;
+					pendingInputs.clear();
+					newestSnapshotTick = 0;
+					snapshotHistory.Clear();
+					playoutBuffer.Clear();
+					extraBalls.Clear();
+					lockstepReplay.Clear();
+					controlReceiver.Clear();
+					extraBallPositions.clear();
+					logStartTicks = SDL_GetTicks();
+					collisionStartTicks = SDL_GetTicks();
 
-					packet.clear();
-					if (tcpSocket.receive(packet) != sf::Socket::Done)
+					break;
+				case ControlOpcode::Winner:
+					winner = control.values[0];
+
+					LOG_INFO(LogCategory::Match) << "Received winner message. Paddle " << winner << " won";
+
+					if (assignedPaddle == winner)
 					{
-						//std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							//<< "\t| tcp socket receive error"
-							//<< std::endl;
+						winnerText = "You win! ";
+						Mix_PlayChannel(-1, winSound, 0);
 					}
-
-					if (packet.getDataSize() > 0)
+					else
 					{
-						// Check packet header to process message from server
-						// 0 = opponent disconnect message
-						// 1 = score update
-						packet >> header;
-						
-						switch (header)
-						{
-						case 0:
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| Received opponent disconnected message"
-								<< std::endl;
+						winnerText = "You lose! ";
+						Mix_PlayChannel(-1, loseSound, 0);
+					}
+					winnerText += "Returning to start screen...";
 
-							packet >> oppDisconnected;
-							if (oppDisconnected == "opponent disconnected")
-							{
-								std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-									<< "\t| Resetting the game"
-									<< std::endl;
-
-								// Reset game
-								gameStarted = false;
-								playerReady = false;
-								assignedPaddle = 0;
-								winner = 0;
-								ball.ballMessages.clear();
-								ball.ballPredictions.clear();
-								ball.ballPositions.clear();
-								playerTwoPaddle->paddleMessages.clear();
-								playerTwoPaddle->paddlePredictions.clear();
-								paddleOne.position = Vec2(50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
-								paddleTwo.position = Vec2(WINDOW_WIDTH - 50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
-								ball.position = Vec2((WINDOW_WIDTH / 2.0f) - (BALL_WIDTH / 2.0f), (WINDOW_HEIGHT / 2.0f) - (BALL_WIDTH / 2.0f));
-								playerOneScore = 0;
-								playerTwoScore = 0;
-								selector.remove(tcpSocket);
-								sendStartTicks = SDL_GetTicks();
-								logStartTicks = SDL_GetTicks();
-								collisionStartTicks = SDL_GetTicks();
-							}
-							
-							break;
-						case 1:
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| Received score update message"
-								<< std::endl;
-
-							scores.timestamp = 0;
-							scores.playerOneScore = playerOneScore;
-							scores.playerTwoScore = playerTwoScore;
-
-							packet >> scores;
-							playerOneScore = scores.playerOneScore;
-							playerTwoScore = scores.playerTwoScore;
-							
-							break;						
-						case 2:														
-							packet >> winner;
-							
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| Received winner message. Paddle " << winner << " won"
-								<< std::endl;
-							
-							if (assignedPaddle == winner)
-							{
-								winnerText = "You win! ";
-								Mix_PlayChannel(-1, winSound, 0);
-							}
-							else
-							{
-								winnerText = "You lose! ";
-								Mix_PlayChannel(-1, loseSound, 0);
-							}
-							winnerText += "Returning to start screen...";
+					mainMenuText.SetText(Vec2(WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2 - 15), winnerText);
 
-							mainMenuText.SetText(Vec2(WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2 - 15), winnerText);
-						
-							SDL_SetRenderDrawColor(renderer, 0x0, 0x0, 0x0, 0xFF);
-							SDL_RenderClear(renderer);
+					SDL_SetRenderDrawColor(renderer, 0x0, 0x0, 0x0, 0xFF);
+					SDL_RenderClear(renderer);
 
-							// Display start text
-							mainMenuText.Draw();
+					// Display start text
+					mainMenuText.Draw();
 
-							// Present the backbuffer
-							SDL_RenderPresent(renderer);
+					// Present the backbuffer
+					SDL_RenderPresent(renderer);
 
-							// Wait for 5 seconds						
-							winScreenEndTicks = SDL_GetTicks();								
-							winScreenStartTicks = SDL_GetTicks();
-							while ((winScreenEndTicks - winScreenStartTicks) <= 5000)
-							{
-								winScreenEndTicks = SDL_GetTicks();
-							}
-							
-							// Reset game
-							gameStarted = false;
-							playerReady = false;
-							assignedPaddle = 0;
-							ball.ballMessages.clear();
-							ball.ballPredictions.clear();
-							ball.ballPositions.clear();
-							playerTwoPaddle->paddleMessages.clear();
-							playerTwoPaddle->paddlePredictions.clear();
-							paddleOne.position = Vec2(50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
-							paddleTwo.position = Vec2(WINDOW_WIDTH - 50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
-							ball.position = Vec2((WINDOW_WIDTH / 2.0f) - (BALL_WIDTH / 2.0f), (WINDOW_HEIGHT / 2.0f) - (BALL_WIDTH / 2.0f));
-							playerOneScore = 0;
-							playerTwoScore = 0;
-							selector.remove(tcpSocket);
-							sendStartTicks = SDL_GetTicks();
-							logStartTicks = SDL_GetTicks();
-							collisionStartTicks = SDL_GetTicks();
-
-							break;
-						}
+					// Wait for 5 seconds
+					winScreenEndTicks = SDL_GetTicks();
+					winScreenStartTicks = SDL_GetTicks();
+					while ((winScreenEndTicks - winScreenStartTicks) <= 5000)
+					{
+						winScreenEndTicks = SDL_GetTicks();
 					}
+
+					// Reset game
+					gameStarted = false;
+					playerReady = false;
+					assignedPaddle = 0;
+					playerTwoPaddle->paddleMessages.Clear();
+					paddleOne.position = Vec2(50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
+					paddleTwo.position = Vec2(WINDOW_WIDTH - 50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
+					ball.position = Vec2((WINDOW_WIDTH / 2.0f) - (BALL_WIDTH / 2.0f), (WINDOW_HEIGHT / 2.0f) - (BALL_WIDTH / 2.0f));
+					ballProjected = { ball.position, Vec2(0.0f, 0.0f) };
+					playerOneScore = 0;
+					playerTwoScore = 0;
+					inputSequence = 0;
+					inputAccumulator = 0.0f;
+					pendingInputs.clear();
+					newestSnapshotTick = 0;
+					snapshotHistory.Clear();
+					playoutBuffer.Clear();
+					extraBalls.Clear();
+					lockstepReplay.Clear();
+					controlReceiver.Clear();
+					extraBallPositions.clear();
+					logStartTicks = SDL_GetTicks();
+					collisionStartTicks = SDL_GetTicks();
+
+					break;
 				}
 			}
-			
+
+			controlMessages.clear();
+
 			playerOneScoreText.SetScore(playerOneScore);
 			playerTwoScoreText.SetScore(playerTwoScore);
 
@@ -1200,6 +940,11 @@ int main(int argc, char* argv[])
 			
 			// Draw the ball
 			ball.Draw(renderer);
+			for (const Vec2& position : extraBallPositions)
+			{
+				SDL_Rect extraBallRect{ static_cast<int>(position.x), static_cast<int>(position.y), BALL_WIDTH, BALL_HEIGHT };
+				SDL_RenderFillRect(renderer, &extraBallRect);
+			}
 
 			// Draw the paddles
 			paddleOne.Draw(renderer);
@@ -1228,11 +973,6 @@ int main(int argc, char* argv[])
 				logStartTicks = SDL_GetTicks();
 			}			
 			
-			// Lerp t = 1 - f^dt
-			// f is the remaining distance to travel each second
-			// dt in above formula is delta time as a fraction of a second
-			interpolationPcntg = 1.0 - pow(0.000001, dt / 1000.0);
-
 			// Calculate frame time
 			endTicks = SDL_GetTicks();
 			dt = (endTicks - startTicks);
@@ -1248,6 +988,7 @@ int main(int argc, char* argv[])
 	Mix_Quit();
 	TTF_Quit();
 	SDL_Quit();
+	Logger::Instance().Stop();
 
 	return 0;
 }
\ No newline at end of file
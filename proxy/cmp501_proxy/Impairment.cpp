@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include "Impairment.h"
+
+bool ParseCondition(const std::string& name, const std::string& value, LinkConditions& conditions)
+{
+	char* end = NULL;
+	double number = strtod(value.c_str(), &end);
+	if (value.empty() || *end != '\0' || number < 0.0)
+	{
+		return false;
+	}
+
+	if (name == "delay")
+	{
+		conditions.delay = number;
+	}
+	else if (name == "jitter")
+	{
+		conditions.jitter = number;
+	}
+	else if (name == "loss")
+	{
+		conditions.loss = number;
+	}
+	else if (name == "duplicate")
+	{
+		conditions.duplicate = number;
+	}
+	else if (name == "reorder")
+	{
+		conditions.reorder = number;
+	}
+	else if (name == "bandwidth")
+	{
+		conditions.bandwidth = number;
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+std::string DescribeConditions(const LinkConditions& conditions)
+{
+	std::ostringstream text;
+	text << "delay=" << conditions.delay << "ms jitter=" << conditions.jitter << "ms loss=" << conditions.loss
+		<< " duplicate=" << conditions.duplicate << " reorder=" << conditions.reorder << " bandwidth=";
+	if (conditions.bandwidth > 0.0)
+	{
+		text << conditions.bandwidth << "kbit/s";
+	}
+	else
+	{
+		text << "unlimited";
+	}
+
+	return text.str();
+}
+
+ImpairedLink::ImpairedLink(unsigned int seed)
+	: random(seed), unit(0.0, 1.0)
+{
+}
+
+void ImpairedLink::Submit(const char* data, std::size_t size, int tag, double now, bool stream)
+{
+	if (!stream && unit(random) < conditions.loss)
+	{
+		stats.lost++;
+		return;
+	}
+
+	// The bandwidth cap sends one thing at a time, so data waits for what is queued ahead of it to be sent
+	double sent = now;
+	if (conditions.bandwidth > 0.0)
+	{
+		double start = std::max(linkFree, now);
+		if (start - now > MAX_QUEUE_MILLISECONDS && !stream)
+		{
+			stats.overflowed++;
+			return;
+		}
+
+		sent = start + size * 8.0 / conditions.bandwidth; // kilobits per second is bits per millisecond
+		linkFree = sent;
+	}
+
+	if (!stream && unit(random) < conditions.reorder)
+	{
+		stats.reordered++;
+		Schedule(data, size, tag, sent);
+		return;
+	}
+
+	double due = std::max(sent + conditions.delay + conditions.jitter * unit(random), lastInOrderDue);
+	lastInOrderDue = due;
+	Schedule(data, size, tag, due);
+
+	if (!stream && unit(random) < conditions.duplicate)
+	{
+		stats.duplicated++;
+		Schedule(data, size, tag, sent + conditions.delay + conditions.jitter * unit(random));
+	}
+}
+
+void ImpairedLink::Schedule(const char* data, std::size_t size, int tag, double due)
+{
+	Pending entry;
+	entry.due = due;
+	entry.order = submitted++;
+	entry.tag = tag;
+	entry.data.assign(data, data + size);
+	pending.push(std::move(entry));
+}
+
+bool ImpairedLink::Poll(double now, std::vector<char>& data, int& tag)
+{
+	if (pending.empty() || pending.top().due > now)
+	{
+		return false;
+	}
+
+	data = pending.top().data;
+	tag = pending.top().tag;
+	pending.pop();
+
+	stats.delivered++;
+	stats.bytes += data.size();
+	return true;
+}
+
+double ImpairedLink::NextDue() const
+{
+	return pending.empty() ? -1.0 : pending.top().due;
+}
+
+bool ImpairmentProfile::Load(const std::string& path, const LinkConditions& initial, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		error = "cannot open " + path;
+		return false;
+	}
+
+	steps.clear();
+	repeat = 0.0;
+	LinkConditions conditions = initial;
+	std::string line;
+	int lineNumber = 0;
+
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		std::istringstream fields(line);
+		std::string word;
+		if (!(fields >> word) || word[0] == '#')
+		{
+			continue;
+		}
+
+		char* end = NULL;
+		double time = strtod(word.c_str(), &end);
+		if (*end != '\0' || time < 0.0 || (!steps.empty() && time < steps.back().time))
+		{
+			error = path + ":" + std::to_string(lineNumber) + ": expected a time in seconds, no earlier than the line before";
+			return false;
+		}
+
+		if (repeat > 0.0)
+		{
+			error = path + ":" + std::to_string(lineNumber) + ": nothing can follow repeat";
+			return false;
+		}
+
+		while (fields >> word)
+		{
+			std::size_t equals = word.find('=');
+			if (word == "repeat")
+			{
+				repeat = time;
+			}
+			else if (equals == std::string::npos || !ParseCondition(word.substr(0, equals), word.substr(equals + 1), conditions))
+			{
+				error = path + ":" + std::to_string(lineNumber) + ": cannot read " + word;
+				return false;
+			}
+		}
+
+		if (repeat == 0.0)
+		{
+			// Until the first line takes effect, the link keeps the conditions it started with
+			if (steps.empty() && time > 0.0)
+			{
+				Step start;
+				start.time = 0.0;
+				start.conditions = initial;
+				steps.push_back(start);
+			}
+
+			Step step;
+			step.time = time;
+			step.conditions = conditions;
+			steps.push_back(step);
+		}
+	}
+
+	return true;
+}
+
+int ImpairmentProfile::At(double seconds, LinkConditions& conditions) const
+{
+	if (steps.empty())
+	{
+		return -1;
+	}
+
+	if (repeat > 0.0)
+	{
+		seconds = std::fmod(seconds, repeat);
+	}
+
+	int step = 0;
+	while (step + 1 < static_cast<int>(steps.size()) && steps[step + 1].time <= seconds)
+	{
+		step++;
+	}
+
+	conditions = steps[step].conditions;
+	return step;
+}
\ No newline at end of file
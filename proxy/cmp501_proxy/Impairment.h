@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+const double MAX_QUEUE_MILLISECONDS = 1000.0; // data that would wait longer than this for the bandwidth cap is dropped
+
+// What one direction of a link does to the data going through it
+struct LinkConditions
+{
+	double delay = 0.0; // milliseconds added to everything
+	double jitter = 0.0; // up to this many milliseconds more, uniformly at random
+	double loss = 0.0; // fraction of datagrams dropped
+	double duplicate = 0.0; // fraction of datagrams delivered twice
+	double reorder = 0.0; // fraction of datagrams delivered without the delay, ahead of those already waiting
+	double bandwidth = 0.0; // kilobits per second, 0 for no cap
+};
+
+// Set the condition called name (delay, jitter, loss, duplicate, reorder or bandwidth) from its value.
+// Returns false if there is no such condition or the value is not a number
+bool ParseCondition(const std::string& name, const std::string& value, LinkConditions& conditions);
+
+std::string DescribeConditions(const LinkConditions& conditions);
+
+struct LinkStats
+{
+	uint64_t delivered = 0;
+	uint64_t bytes = 0;
+	uint64_t lost = 0;
+	uint64_t duplicated = 0;
+	uint64_t reordered = 0;
+	uint64_t overflowed = 0; // dropped because the bandwidth cap had too much queued
+};
+
+// One direction of an impaired link. Data is handed in as it arrives and taken out when it is due, with a tag the
+// caller uses to tell where it goes. Stream data (tcp) keeps every byte in order and is never lost, duplicated or
+// reordered, so only the delay, jitter and bandwidth cap apply to it
+class ImpairedLink
+{
+public:
+	ImpairedLink(unsigned int seed);
+
+	void Submit(const char* data, std::size_t size, int tag, double now, bool stream);
+
+	// Take the next data due by now, oldest due first. Returns false if nothing is due
+	bool Poll(double now, std::vector<char>& data, int& tag);
+
+	// When the next data is due, or a negative number if nothing is waiting
+	double NextDue() const;
+
+	LinkConditions conditions;
+	LinkStats stats;
+
+private:
+	struct Pending
+	{
+		double due = 0.0;
+		uint64_t order = 0; // keeps data due at the same time in the order it was submitted
+		int tag = 0;
+		std::vector<char> data;
+	};
+
+	struct LaterDue
+	{
+		bool operator()(const Pending& a, const Pending& b) const
+		{
+			return a.due > b.due || (a.due == b.due && a.order > b.order);
+		}
+	};
+
+	void Schedule(const char* data, std::size_t size, int tag, double due);
+
+	std::priority_queue<Pending, std::vector<Pending>, LaterDue> pending;
+	std::mt19937 random;
+	std::uniform_real_distribution<double> unit;
+	uint64_t submitted = 0;
+	double linkFree = 0.0; // when the bandwidth cap has sent everything queued
+	double lastInOrderDue = 0.0; // data that is not reordered is never due before data submitted ahead of it
+};
+
+// Conditions that change over time, read from a text file. Each line is a time in seconds from the start
+// followed by name=value conditions, which last until a later line changes them; before the first line, the
+// conditions it was loaded with apply. A line with a time and the word repeat starts the profile over at
+// that time. Blank lines and lines starting with # are skipped:
+//
+//	0	delay=20 jitter=5
+//	10	delay=120 jitter=40 loss=0.02
+//	20	loss=0.2 reorder=0.05
+//	30	repeat
+class ImpairmentProfile
+{
+public:
+	bool Load(const std::string& path, const LinkConditions& initial, std::string& error);
+
+	// The step in force seconds after the start, and its conditions. Returns -1 if the profile is empty
+	int At(double seconds, LinkConditions& conditions) const;
+
+private:
+	struct Step
+	{
+		double time = 0.0;
+		LinkConditions conditions;
+	};
+
+	std::vector<Step> steps;
+	double repeat = 0.0; // length of the profile if it repeats, 0 if it holds the last step
+};
\ No newline at end of file
@@ -0,0 +1,417 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include "Proxy.h"
+
+const std::size_t PROXY_BUFFER_SIZE = 65536;
+
+// Message type of a hello in the low four bits of a datagram's header, and the size of the server's paddle
+// assignment: a 32-bit paddle number and a 64-bit session ID (see Protocol.h in the server)
+const uint8_t HELLO_MESSAGE_TYPE = 11;
+const uint32_t ASSIGNMENT_SIZE = 12;
+
+static uint32_t ReadUint32(const char* bytes)
+{
+	return (static_cast<uint32_t>(static_cast<uint8_t>(bytes[0])) << 24) | (static_cast<uint8_t>(bytes[1]) << 16)
+		| (static_cast<uint8_t>(bytes[2]) << 8) | static_cast<uint8_t>(bytes[3]);
+}
+
+static uint64_t ReadUint64(const char* bytes)
+{
+	return (static_cast<uint64_t>(ReadUint32(bytes)) << 32) | ReadUint32(bytes + 4);
+}
+
+ProxySession::ProxySession(unsigned int seed)
+	: udpUp(seed), udpDown(seed + 1), tcpUp(seed + 2), tcpDown(seed + 3)
+{
+}
+
+static void AddStats(LinkStats& total, const LinkStats& stats)
+{
+	total.delivered += stats.delivered;
+	total.bytes += stats.bytes;
+	total.lost += stats.lost;
+	total.duplicated += stats.duplicated;
+	total.reordered += stats.reordered;
+	total.overflowed += stats.overflowed;
+}
+
+static uint64_t MonotonicMicroseconds()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Proxy::Proxy(const std::string& serverAddress, unsigned short serverTcpPort, unsigned short serverUdpPort, unsigned int seed)
+	: serverAddress(serverAddress), serverTcpPort(serverTcpPort), serverUdpPort(serverUdpPort), seed(seed),
+	startTime(MonotonicMicroseconds())
+{
+}
+
+double Proxy::Now() const
+{
+	return (MonotonicMicroseconds() - startTime) / 1000.0;
+}
+
+bool Proxy::Listen(unsigned short tcpPort, unsigned short udpPort)
+{
+	listener.setBlocking(false);
+	if (listener.listen(tcpPort) != sf::Socket::Done)
+	{
+		std::cerr << "Cannot listen on tcp port " << tcpPort << std::endl;
+		return false;
+	}
+
+	listenUdp.setBlocking(false);
+	if (listenUdp.bind(udpPort) != sf::Socket::Done)
+	{
+		std::cerr << "Cannot bind udp port " << udpPort << std::endl;
+		return false;
+	}
+
+	RebuildSelector();
+	return true;
+}
+
+void Proxy::SetConditions(const LinkConditions& newConditions)
+{
+	conditions = newConditions;
+	for (ProxySession& session : sessions)
+	{
+		session.udpUp.conditions = conditions;
+		session.udpDown.conditions = conditions;
+		session.tcpUp.conditions = conditions;
+		session.tcpDown.conditions = conditions;
+	}
+}
+
+void Proxy::Update(double maxWait)
+{
+	double wait = maxWait;
+	double nextDue = NextDue();
+	if (nextDue >= 0.0)
+	{
+		wait = std::min(wait, nextDue - Now());
+	}
+
+	// A zero timeout would make the selector wait forever
+	if (wait > 0.0)
+	{
+		selector.wait(sf::microseconds(static_cast<sf::Int64>(wait * 1000.0) + 1));
+	}
+
+	double now = Now();
+	Accept();
+	ReceiveListenUdp(now);
+
+	bool removed = false;
+	std::list<ProxySession>::iterator it = sessions.begin();
+	while (it != sessions.end())
+	{
+		ReceiveFromClient(*it, now);
+		ReceiveFromServer(*it, now);
+		Deliver(*it, now);
+
+		if ((*it).closing && (*it).toClient.empty() && (*it).toServer.empty())
+		{
+			std::cout << "Connection from " << (*it).clientAddress.toString() << ":" << (*it).clientPort << " closed" << std::endl;
+			(*(*it).client).disconnect();
+			(*(*it).server).disconnect();
+			AddStats(closedUp, (*it).udpUp.stats);
+			AddStats(closedDown, (*it).udpDown.stats);
+			closedTcpBytes += (*it).tcpUp.stats.bytes + (*it).tcpDown.stats.bytes;
+			it = sessions.erase(it);
+			removed = true;
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	if (removed)
+	{
+		RebuildSelector();
+	}
+}
+
+// Accept every pending client, and connect it to the server through sockets of its own. Each session's random
+// choices are seeded from --seed and the number of sessions accepted before it, so a run can be repeated
+void Proxy::Accept()
+{
+	std::unique_ptr<sf::TcpSocket> client(new sf::TcpSocket);
+	while (listener.accept(*client) == sf::Socket::Done)
+	{
+		sessionsAccepted++;
+		sessions.emplace_back(seed + 4 * sessionsAccepted);
+		ProxySession& session = sessions.back();
+		session.clientAddress = (*client).getRemoteAddress();
+		session.clientPort = (*client).getRemotePort();
+		session.client = std::move(client);
+		client.reset(new sf::TcpSocket);
+
+		session.server.reset(new sf::TcpSocket);
+		if ((*session.server).connect(serverAddress, serverTcpPort, sf::seconds(2.0f)) != sf::Socket::Done)
+		{
+			std::cerr << "Cannot connect to the server at " << serverAddress.toString() << ":" << serverTcpPort
+				<< " for " << session.clientAddress.toString() << ":" << session.clientPort << std::endl;
+			(*session.client).disconnect();
+			sessions.pop_back();
+			continue;
+		}
+
+		(*session.client).setBlocking(false);
+		(*session.server).setBlocking(false);
+
+		session.upstream.reset(new sf::UdpSocket);
+		(*session.upstream).setBlocking(false);
+		if ((*session.upstream).bind(sf::Socket::AnyPort) != sf::Socket::Done)
+		{
+			std::cerr << "Cannot bind a udp socket for " << session.clientAddress.toString() << ":" << session.clientPort << std::endl;
+		}
+
+		SetConditions(conditions);
+
+		std::cout << "Connection from " << session.clientAddress.toString() << ":" << session.clientPort
+			<< " passed to the server from port " << (*session.server).getLocalPort() << std::endl;
+	}
+
+	RebuildSelector();
+}
+
+void Proxy::ReceiveFromClient(ProxySession& session, double now)
+{
+	char buffer[PROXY_BUFFER_SIZE];
+	std::size_t received = 0;
+	sf::Socket::Status status;
+
+	while ((status = (*session.client).receive(buffer, sizeof(buffer), received)) == sf::Socket::Done)
+	{
+		session.tcpUp.Submit(buffer, received, static_cast<int>(ProxyRoute::Stream), now, true);
+	}
+
+	if (status == sf::Socket::Disconnected || status == sf::Socket::Error)
+	{
+		session.tcpUp.Submit(NULL, 0, static_cast<int>(ProxyRoute::Close), now, true);
+	}
+}
+
+// The first packet the server sends is the paddle assignment, an sf::Packet after the 32-bit size sf::TcpSocket
+// puts in front of every packet. It is passed on as it is, and the session ID in it kept
+void Proxy::ReadAssignment(ProxySession& session)
+{
+	std::vector<char>& bytes = session.assignmentBytes;
+	if (bytes.size() < 4)
+	{
+		return;
+	}
+
+	uint32_t size = ReadUint32(bytes.data());
+	if (bytes.size() < 4 + static_cast<std::size_t>(size))
+	{
+		return;
+	}
+
+	if (size == ASSIGNMENT_SIZE)
+	{
+		session.sessionId = ReadUint64(bytes.data() + 8);
+	}
+
+	bytes.clear();
+	session.assigned = true;
+}
+
+void Proxy::ReceiveFromServer(ProxySession& session, double now)
+{
+	char buffer[PROXY_BUFFER_SIZE];
+	std::size_t received = 0;
+	sf::IpAddress address;
+	unsigned short port = 0;
+	sf::Socket::Status status;
+
+	while ((status = (*session.server).receive(buffer, sizeof(buffer), received)) == sf::Socket::Done)
+	{
+		if (!session.assigned)
+		{
+			session.assignmentBytes.insert(session.assignmentBytes.end(), buffer, buffer + received);
+			ReadAssignment(session);
+		}
+
+		session.tcpDown.Submit(buffer, received, static_cast<int>(ProxyRoute::Stream), now, true);
+	}
+
+	if (status == sf::Socket::Disconnected || status == sf::Socket::Error)
+	{
+		session.tcpDown.Submit(NULL, 0, static_cast<int>(ProxyRoute::Close), now, true);
+	}
+
+	while ((*session.upstream).receive(buffer, sizeof(buffer), received, address, port) == sf::Socket::Done)
+	{
+		session.udpDown.Submit(buffer, received, static_cast<int>(ProxyRoute::ToClientUdp), now, false);
+	}
+}
+
+// Datagrams from clients all arrive on the one port, and are told apart by the endpoint they come from
+void Proxy::ReceiveListenUdp(double now)
+{
+	char buffer[PROXY_BUFFER_SIZE];
+	std::size_t received = 0;
+	sf::IpAddress address;
+	unsigned short port = 0;
+
+	while (listenUdp.receive(buffer, sizeof(buffer), received, address, port) == sf::Socket::Done)
+	{
+		ProxySession* session = FindUdpSender(buffer, received, address, port);
+		if (session != NULL)
+		{
+			(*session).udpUp.Submit(buffer, received, static_cast<int>(ProxyRoute::ToServerUdp), now, false);
+		}
+	}
+}
+
+// Find the session a client datagram belongs to. A hello belongs to the session whose ID it carries, and moves the
+// session to the endpoint it came from, taking it from any earlier session of the same client. Anything else
+// belongs to the session at its endpoint
+ProxySession* Proxy::FindUdpSender(const char* data, std::size_t size, const sf::IpAddress& address, unsigned short port)
+{
+	if (size >= 9 && (static_cast<uint8_t>(data[0]) & 0x0F) == HELLO_MESSAGE_TYPE)
+	{
+		uint64_t sessionId = ReadUint64(data + 1);
+		for (ProxySession& session : sessions)
+		{
+			if (session.assigned && session.sessionId == sessionId && session.clientAddress == address)
+			{
+				for (ProxySession& other : sessions)
+				{
+					if (other.clientAddress == address && other.clientUdpPort == port)
+					{
+						other.clientUdpPort = 0;
+					}
+				}
+
+				session.clientUdpPort = port;
+				return &session;
+			}
+		}
+	}
+
+	for (ProxySession& session : sessions)
+	{
+		if (session.clientUdpPort != 0 && session.clientAddress == address && session.clientUdpPort == port)
+		{
+			return &session;
+		}
+	}
+
+	return NULL;
+}
+
+void Proxy::Deliver(ProxySession& session, double now)
+{
+	std::vector<char> data;
+	int tag = 0;
+
+	while (session.udpUp.Poll(now, data, tag))
+	{
+		(*session.upstream).send(data.data(), data.size(), serverAddress, serverUdpPort);
+	}
+
+	while (session.udpDown.Poll(now, data, tag))
+	{
+		listenUdp.send(data.data(), data.size(), session.clientAddress, session.clientUdpPort);
+	}
+
+	while (session.tcpUp.Poll(now, data, tag))
+	{
+		session.toServer.insert(session.toServer.end(), data.begin(), data.end());
+		session.closing = session.closing || static_cast<ProxyRoute>(tag) == ProxyRoute::Close;
+	}
+
+	while (session.tcpDown.Poll(now, data, tag))
+	{
+		session.toClient.insert(session.toClient.end(), data.begin(), data.end());
+		session.closing = session.closing || static_cast<ProxyRoute>(tag) == ProxyRoute::Close;
+	}
+
+	Flush(*session.server, session.toServer);
+	Flush(*session.client, session.toClient);
+}
+
+// Send as much of bytes as the socket takes without blocking, keeping the rest for later
+void Proxy::Flush(sf::TcpSocket& socket, std::vector<char>& bytes)
+{
+	if (bytes.empty())
+	{
+		return;
+	}
+
+	std::size_t sent = 0;
+	sf::Socket::Status status = socket.send(bytes.data(), bytes.size(), sent);
+	if (status == sf::Socket::Disconnected || status == sf::Socket::Error)
+	{
+		bytes.clear();
+		return;
+	}
+
+	bytes.erase(bytes.begin(), bytes.begin() + sent);
+}
+
+double Proxy::NextDue() const
+{
+	double next = -1.0;
+	for (const ProxySession& session : sessions)
+	{
+		for (const ImpairedLink* link : { &session.udpUp, &session.udpDown, &session.tcpUp, &session.tcpDown })
+		{
+			double due = (*link).NextDue();
+			if (due >= 0.0 && (next < 0.0 || due < next))
+			{
+				next = due;
+			}
+		}
+
+		// Bytes the socket would not take yet are retried every wait
+		if (!session.toClient.empty() || !session.toServer.empty())
+		{
+			next = (next < 0.0) ? Now() + 1.0 : std::min(next, Now() + 1.0);
+		}
+	}
+
+	return next;
+}
+
+void Proxy::RebuildSelector()
+{
+	selector.clear();
+	selector.add(listener);
+	selector.add(listenUdp);
+	for (ProxySession& session : sessions)
+	{
+		selector.add(*session.client);
+		selector.add(*session.server);
+		selector.add(*session.upstream);
+	}
+}
+
+void Proxy::PrintStats(double seconds) const
+{
+	LinkStats up = closedUp;
+	LinkStats down = closedDown;
+	uint64_t tcpBytes = closedTcpBytes;
+	for (const ProxySession& session : sessions)
+	{
+		AddStats(up, session.udpUp.stats);
+		AddStats(down, session.udpDown.stats);
+		tcpBytes += session.tcpUp.stats.bytes + session.tcpDown.stats.bytes;
+	}
+
+	const LinkStats* directions[] = { &up, &down };
+	const char* names[] = { "client to server", "server to client" };
+	std::cout << seconds << " s: " << sessions.size() << " connections, " << tcpBytes << " tcp bytes" << std::endl;
+	for (int i = 0; i < 2; i++)
+	{
+		const LinkStats& stats = *directions[i];
+		std::cout << "\t" << names[i] << ": " << stats.delivered << " datagrams (" << stats.bytes << " bytes) delivered, "
+			<< stats.lost << " lost, " << stats.duplicated << " duplicated, " << stats.reordered << " reordered, "
+			<< stats.overflowed << " over the bandwidth cap" << std::endl;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Impairment.h"
+
+/* Proxy between game clients and the server, passing everything through impaired links
+*
+*	Clients connect to the proxy as if it was the server. Each tcp connection gets its own connection to the server
+*	and its own udp socket, so the server sees every client as it would without the proxy. The session ID the server
+*	gives the client with its paddle is read on the way through, and the first hello carrying it ties the endpoint
+*	it came from to the session, after which the client's datagrams are told apart by that endpoint. So datagrams
+*	a client sends before its hello, such as its first clock requests, are dropped
+*	Each direction of each connection goes through its own ImpairedLink, all with the same conditions
+*/
+
+// Where data taken from a link goes
+enum class ProxyRoute
+{
+	ToServerUdp, // client's datagrams, from the session's udp socket
+	ToClientUdp, // server's datagrams, from the proxy's listening udp socket
+	Stream, // tcp data, in the direction of the link
+	Close // end of the tcp stream, in the direction of the link
+};
+
+struct ProxySession
+{
+	ProxySession(unsigned int seed);
+
+	std::unique_ptr<sf::TcpSocket> client;
+	std::unique_ptr<sf::TcpSocket> server;
+	std::unique_ptr<sf::UdpSocket> upstream; // the port the server is told the client's udp socket is on
+
+	sf::IpAddress clientAddress;
+	unsigned short clientPort = 0; // tcp port of the client
+	unsigned short clientUdpPort = 0; // 0 until the client has said hello
+
+	std::vector<char> assignmentBytes; // server to client bytes kept until the first tcp packet is complete
+	bool assigned = false; // the first packet has been read, so sessionId is known
+	uint64_t sessionId = 0;
+	std::vector<char> toClient; // tcp bytes due but not yet taken by the socket
+	std::vector<char> toServer;
+	bool closing = false;
+
+	ImpairedLink udpUp;
+	ImpairedLink udpDown;
+	ImpairedLink tcpUp;
+	ImpairedLink tcpDown;
+};
+
+class Proxy
+{
+public:
+	Proxy(const std::string& serverAddress, unsigned short serverTcpPort, unsigned short serverUdpPort, unsigned int seed);
+
+	// Listen for clients. Returns false if either port cannot be bound
+	bool Listen(unsigned short tcpPort, unsigned short udpPort);
+
+	// Apply conditions to every link, now and for sessions started later
+	void SetConditions(const LinkConditions& conditions);
+
+	// Move everything that has arrived into the links and everything due out of them, waiting at most
+	// maxWait milliseconds for something to arrive or come due
+	void Update(double maxWait);
+
+	// Milliseconds since the proxy started
+	double Now() const;
+
+	// Totals of every link, by direction, for sessions still open and closed
+	void PrintStats(double seconds) const;
+
+private:
+	void Accept();
+	void ReceiveFromClient(ProxySession& session, double now);
+	void ReceiveFromServer(ProxySession& session, double now);
+	void ReceiveListenUdp(double now);
+	void Deliver(ProxySession& session, double now);
+	void ReadAssignment(ProxySession& session);
+	ProxySession* FindUdpSender(const char* data, std::size_t size, const sf::IpAddress& address, unsigned short port);
+	void Flush(sf::TcpSocket& socket, std::vector<char>& bytes);
+	double NextDue() const;
+	void RebuildSelector();
+
+	sf::IpAddress serverAddress;
+	unsigned short serverTcpPort;
+	unsigned short serverUdpPort;
+	unsigned int seed;
+	unsigned int sessionsAccepted = 0; // every session ever accepted, for the seed of the next
+
+	sf::TcpListener listener;
+	sf::UdpSocket listenUdp;
+	sf::SocketSelector selector;
+	std::list<ProxySession> sessions;
+	LinkConditions conditions;
+
+	uint64_t startTime;
+	LinkStats closedUp; // totals of sessions that have closed
+	LinkStats closedDown;
+	uint64_t closedTcpBytes = 0;
+};
\ No newline at end of file
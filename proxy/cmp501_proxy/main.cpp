@@ -0,0 +1,140 @@
+#include <SFML/Network.hpp>
+#include <stdlib.h>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include "Impairment.h"
+#include "Proxy.h"
+
+const double STATS_INTERVAL_SECONDS = 5.0;
+const double PROFILE_CHECK_MILLISECONDS = 50.0; // longest wait, so profile steps start on time
+
+// Set from the signal handler when the proxy is asked to stop
+static volatile std::sig_atomic_t shutdownRequested = 0;
+
+static void RequestShutdown(int)
+{
+	shutdownRequested = 1;
+}
+
+int main(int argc, char* argv[])
+{
+	// Clients connect to --listen-tcp-port <port> and send udp to --listen-udp-port <port>, and are passed on to the
+	// server at --server <address>, --server-tcp-port <port> and --server-udp-port <port>. Start the client with
+	// --server-tcp-port and --server-udp-port set to the listen ports to play through the proxy
+	// Every direction of every connection is impaired by --delay <milliseconds>, --jitter <milliseconds>,
+	// --loss <fraction>, --duplicate <fraction>, --reorder <fraction> and --bandwidth <kilobits per second>.
+	// Only the delay, jitter and bandwidth apply to tcp
+	// Passing --profile <file> changes the conditions over time, starting from those on the command line
+	// Random choices are made from --seed <number>, so a run can be repeated
+	unsigned short listenTcpPort = 5445;
+	unsigned short listenUdpPort = 5444;
+	std::string serverAddress = "127.0.0.1";
+	unsigned short serverTcpPort = 4445;
+	unsigned short serverUdpPort = 4444;
+	LinkConditions conditions;
+	std::string profilePath;
+	unsigned int seed = 1;
+
+	for (int i = 1; i < argc - 1; i++)
+	{
+		std::string option = argv[i];
+		if (option == "--listen-tcp-port")
+		{
+			listenTcpPort = static_cast<unsigned short>(atoi(argv[i + 1]));
+		}
+		else if (option == "--listen-udp-port")
+		{
+			listenUdpPort = static_cast<unsigned short>(atoi(argv[i + 1]));
+		}
+		else if (option == "--server")
+		{
+			serverAddress = argv[i + 1];
+		}
+		else if (option == "--server-tcp-port")
+		{
+			serverTcpPort = static_cast<unsigned short>(atoi(argv[i + 1]));
+		}
+		else if (option == "--server-udp-port")
+		{
+			serverUdpPort = static_cast<unsigned short>(atoi(argv[i + 1]));
+		}
+		else if (option == "--profile")
+		{
+			profilePath = argv[i + 1];
+		}
+		else if (option == "--seed")
+		{
+			seed = static_cast<unsigned int>(atoi(argv[i + 1]));
+		}
+		else if (option.compare(0, 2, "--") == 0 && !ParseCondition(option.substr(2), argv[i + 1], conditions))
+		{
+			std::cerr << "Unknown option or bad value: " << option << " " << argv[i + 1] << std::endl;
+			return 1;
+		}
+		else
+		{
+			continue;
+		}
+
+		i++;
+	}
+
+	ImpairmentProfile profile;
+	if (!profilePath.empty())
+	{
+		std::string error;
+		if (!profile.Load(profilePath, conditions, error))
+		{
+			std::cerr << "Cannot load profile " << profilePath << ": " << error << std::endl;
+			return 1;
+		}
+	}
+
+	std::signal(SIGINT, RequestShutdown);
+	std::signal(SIGTERM, RequestShutdown);
+#ifdef __linux__
+	std::signal(SIGPIPE, SIG_IGN);
+#endif
+
+	Proxy proxy(serverAddress, serverTcpPort, serverUdpPort, seed);
+	proxy.SetConditions(conditions);
+	if (!proxy.Listen(listenTcpPort, listenUdpPort))
+	{
+		return 1;
+	}
+
+	std::cout << "Proxy listening on tcp port " << listenTcpPort << " and udp port " << listenUdpPort
+		<< " for the server at " << serverAddress << ":" << serverTcpPort << "/" << serverUdpPort << std::endl;
+	std::cout << "Conditions: " << DescribeConditions(conditions) << std::endl;
+
+	int profileStep = -1;
+	double nextStats = STATS_INTERVAL_SECONDS;
+	while (!shutdownRequested)
+	{
+		double seconds = proxy.Now() / 1000.0;
+
+		if (!profilePath.empty())
+		{
+			LinkConditions stepConditions;
+			int step = profile.At(seconds, stepConditions);
+			if (step != profileStep)
+			{
+				profileStep = step;
+				proxy.SetConditions(stepConditions);
+				std::cout << seconds << " s: " << DescribeConditions(stepConditions) << std::endl;
+			}
+		}
+
+		if (seconds >= nextStats)
+		{
+			proxy.PrintStats(seconds);
+			nextStats += STATS_INTERVAL_SECONDS;
+		}
+
+		proxy.Update(PROFILE_CHECK_MILLISECONDS);
+	}
+
+	proxy.PrintStats(proxy.Now() / 1000.0);
+	return 0;
+}
\ No newline at end of file
@@ -5,9 +5,9 @@ Ball::Ball(Vec2 position, Vec2 velocity)
 {	
 }
 
-void Ball::Update(float dt)
+BallMove Ball::Move(float dt, const Vec2& paddleOne, const Vec2& paddleTwo)
 {
-	position += velocity * dt;
+	return MoveBall(position, velocity, dt, paddleOne, paddleTwo);
 }
 
 void Ball::CollideWithPaddle(Contact const& contact)
@@ -25,22 +25,16 @@ void Ball::CollideWithPaddle(Contact const& contact)
 	}
 }
 
-void Ball::CollideWithWall(Contact const& contact)
+void Ball::Serve(BallEdge goal)
 {
-	if ((contact.type == CollisionType::Top)
-		|| (contact.type == CollisionType::Bottom))
-	{
-		position.y += contact.penetration;
-		velocity.y = -velocity.y;
-	}
-	else if (contact.type == CollisionType::Left)
+	if (goal == BallEdge::Left)
 	{
 		position.x = WINDOW_WIDTH / 2.0f;
 		position.y = WINDOW_HEIGHT / 2.0f;
 		velocity.x = BALL_SPEED;
 		velocity.y = 0.75f * BALL_SPEED;
 	}
-	else if (contact.type == CollisionType::Right)
+	else if (goal == BallEdge::Right)
 	{
 		position.x = WINDOW_WIDTH / 2.0f;
 		position.y = WINDOW_HEIGHT / 2.0f;
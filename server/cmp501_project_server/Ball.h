@@ -1,9 +1,7 @@
 #pragma once
 #include "Global.h"
 #include "Vec2.h"
-
-const int BALL_WIDTH = 15;
-const int BALL_HEIGHT = 15;
+#include "Collision.h"
 
 class Ball
 {
@@ -26,9 +24,11 @@ public:
 
 	Ball(Vec2 position, Vec2 velocity);
 
-	void Update(float dt);
+	// Move the ball for dt milliseconds, bouncing it off the walls and the paddles (top left corners) on the way
+	BallMove Move(float dt, const Vec2& paddleOne, const Vec2& paddleTwo);
 	void CollideWithPaddle(Contact const& contact);
-	void CollideWithWall(Contact const& contact);
+	// Put the ball back in the middle after it reached an edge, served towards the player who scored
+	void Serve(BallEdge goal);
 
 	Vec2 position;
 	Vec2 velocity;
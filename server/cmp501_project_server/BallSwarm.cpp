@@ -0,0 +1,296 @@
+#include <cmath>
+#include "BallSwarm.h"
+
+#if defined(__AVX__)
+#define BALL_SWARM_AVX
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BALL_SWARM_SSE
+#include <emmintrin.h>
+#endif
+
+void BallSwarm::Add(const Vec2& position, const Vec2& velocity)
+{
+	x.push_back(position.x);
+	y.push_back(position.y);
+	velocityX.push_back(velocity.x);
+	velocityY.push_back(velocity.y);
+}
+
+void BallSwarm::Clear()
+{
+	x.clear();
+	y.clear();
+	velocityX.clear();
+	velocityY.clear();
+}
+
+// Everything a step needs that is the same for every ball
+struct StepConstants
+{
+	float dt;
+	float planeOne; // x the left side of a ball touches paddle one at
+	float planeTwo; // x the left side of a ball touches paddle two at
+	float paddleOneTop;
+	float paddleTwoTop;
+	float bottomWall; // largest y of a ball in the field
+	float rightEdge; // largest x of a ball in the field
+};
+
+static StepConstants MakeStepConstants(float dt, const Vec2& paddleOne, const Vec2& paddleTwo)
+{
+	StepConstants k;
+	k.dt = dt;
+	k.planeOne = paddleOne.x + PADDLE_WIDTH;
+	k.planeTwo = paddleTwo.x - BALL_WIDTH;
+	k.paddleOneTop = paddleOne.y;
+	k.paddleTwoTop = paddleTwo.y;
+	k.bottomWall = static_cast<float>(WINDOW_HEIGHT - BALL_HEIGHT);
+	k.rightEdge = static_cast<float>(WINDOW_WIDTH - BALL_WIDTH);
+	return k;
+}
+
+// One ball. The SIMD kernel below does exactly the same sums, lane by lane
+static void StepBall(float& x, float& y, float& velocityX, float& velocityY, const StepConstants& k, SwarmGoals& goals)
+{
+	float x0 = x;
+	float y0 = y;
+	float x1 = x0 + velocityX * k.dt;
+	float y1 = y0 + velocityY * k.dt;
+
+	// Height of the ball where it crosses each paddle's plane, if it does
+	float crossOne = y0 + (y1 - y0) * ((k.planeOne - x0) / (x1 - x0));
+	float crossTwo = y0 + (y1 - y0) * ((k.planeTwo - x0) / (x1 - x0));
+	bool hitOne = (x0 >= k.planeOne) && (x1 < k.planeOne)
+		&& (crossOne + BALL_HEIGHT > k.paddleOneTop) && (crossOne < k.paddleOneTop + PADDLE_HEIGHT);
+	bool hitTwo = (x0 <= k.planeTwo) && (x1 > k.planeTwo)
+		&& (crossTwo + BALL_HEIGHT > k.paddleTwoTop) && (crossTwo < k.paddleTwoTop + PADDLE_HEIGHT);
+
+	if (hitOne || hitTwo)
+	{
+		float plane = hitOne ? k.planeOne : k.planeTwo;
+		float paddleTop = hitOne ? k.paddleOneTop : k.paddleTwoTop;
+		float ballBottom = (hitOne ? crossOne : crossTwo) + BALL_HEIGHT;
+
+		x1 = plane + plane - x1;
+		velocityX = -velocityX;
+
+		// Thirds of the paddle, as for the main ball
+		bool top = (ballBottom > paddleTop) && (ballBottom < paddleTop + PADDLE_HEIGHT / 3.0f);
+		bool middle = (ballBottom > paddleTop + PADDLE_HEIGHT / 3.0f) && (ballBottom < paddleTop + 2.0f * PADDLE_HEIGHT / 3.0f);
+		velocityY = top ? -0.75f * BALL_SPEED : (middle ? velocityY : 0.75f * BALL_SPEED);
+	}
+
+	if (y1 < 0.0f)
+	{
+		y1 = -y1;
+		velocityY = std::fabs(velocityY);
+	}
+	else if (y1 > k.bottomWall)
+	{
+		y1 = k.bottomWall + k.bottomWall - y1;
+		velocityY = -std::fabs(velocityY);
+	}
+
+	if (x1 < 0.0f || x1 > k.rightEdge)
+	{
+		goals.left += x1 < 0.0f;
+		goals.right += x1 > k.rightEdge;
+		x1 = WINDOW_WIDTH / 2.0f;
+		velocityX = -velocityX;
+	}
+
+	x = x1;
+	y = y1;
+}
+
+#if defined(BALL_SWARM_SSE) || defined(BALL_SWARM_AVX)
+#ifdef BALL_SWARM_SSE
+struct SseLanes
+{
+	using Value = __m128;
+	static const int Width = 4;
+
+	static Value Set(float v) { return _mm_set1_ps(v); }
+	static Value Load(const float* p) { return _mm_loadu_ps(p); }
+	static void Store(float* p, Value v) { _mm_storeu_ps(p, v); }
+	static Value Add(Value a, Value b) { return _mm_add_ps(a, b); }
+	static Value Sub(Value a, Value b) { return _mm_sub_ps(a, b); }
+	static Value Mul(Value a, Value b) { return _mm_mul_ps(a, b); }
+	static Value Div(Value a, Value b) { return _mm_div_ps(a, b); }
+	static Value Less(Value a, Value b) { return _mm_cmplt_ps(a, b); }
+	static Value LessEqual(Value a, Value b) { return _mm_cmple_ps(a, b); }
+	static Value And(Value a, Value b) { return _mm_and_ps(a, b); }
+	static Value Or(Value a, Value b) { return _mm_or_ps(a, b); }
+	static Value Abs(Value a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static Value Select(Value mask, Value a, Value b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	static int Bits(Value mask) { return _mm_movemask_ps(mask); }
+};
+#endif
+
+#ifdef BALL_SWARM_AVX
+struct AvxLanes
+{
+	using Value = __m256;
+	static const int Width = 8;
+
+	static Value Set(float v) { return _mm256_set1_ps(v); }
+	static Value Load(const float* p) { return _mm256_loadu_ps(p); }
+	static void Store(float* p, Value v) { _mm256_storeu_ps(p, v); }
+	static Value Add(Value a, Value b) { return _mm256_add_ps(a, b); }
+	static Value Sub(Value a, Value b) { return _mm256_sub_ps(a, b); }
+	static Value Mul(Value a, Value b) { return _mm256_mul_ps(a, b); }
+	static Value Div(Value a, Value b) { return _mm256_div_ps(a, b); }
+	static Value Less(Value a, Value b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static Value LessEqual(Value a, Value b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	static Value And(Value a, Value b) { return _mm256_and_ps(a, b); }
+	static Value Or(Value a, Value b) { return _mm256_or_ps(a, b); }
+	static Value Abs(Value a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+	static Value Select(Value mask, Value a, Value b) { return _mm256_blendv_ps(b, a, mask); }
+	static int Bits(Value mask) { return _mm256_movemask_ps(mask); }
+};
+#endif
+
+static int CountBits(int bits)
+{
+	int count = 0;
+	for (; bits != 0; bits &= bits - 1)
+	{
+		count++;
+	}
+	return count;
+}
+
+// StepBall on Width balls at a time, from begin until fewer than Width are left. Returns where it stopped
+// Branches become masks: each lane works out both outcomes and keeps the one its condition picks
+template <typename L>
+static int StepLanes(BallSwarm& swarm, int begin, int end, const StepConstants& k, SwarmGoals& goals)
+{
+	using V = typename L::Value;
+	const V dt = L::Set(k.dt);
+	const V zero = L::Set(0.0f);
+	const V ballHeight = L::Set(static_cast<float>(BALL_HEIGHT));
+	const V paddleHeight = L::Set(static_cast<float>(PADDLE_HEIGHT));
+	const V firstThird = L::Set(PADDLE_HEIGHT / 3.0f);
+	const V secondThird = L::Set(2.0f * PADDLE_HEIGHT / 3.0f);
+	const V upSpeed = L::Set(-0.75f * BALL_SPEED);
+	const V downSpeed = L::Set(0.75f * BALL_SPEED);
+	const V planeOne = L::Set(k.planeOne);
+	const V planeTwo = L::Set(k.planeTwo);
+	const V paddleOneTop = L::Set(k.paddleOneTop);
+	const V paddleTwoTop = L::Set(k.paddleTwoTop);
+	const V bottomWall = L::Set(k.bottomWall);
+	const V rightEdge = L::Set(k.rightEdge);
+	const V middleX = L::Set(WINDOW_WIDTH / 2.0f);
+
+	int i = begin;
+	for (; i + L::Width <= end; i += L::Width)
+	{
+		V x0 = L::Load(&swarm.x[i]);
+		V y0 = L::Load(&swarm.y[i]);
+		V velocityX = L::Load(&swarm.velocityX[i]);
+		V velocityY = L::Load(&swarm.velocityY[i]);
+		V x1 = L::Add(x0, L::Mul(velocityX, dt));
+		V y1 = L::Add(y0, L::Mul(velocityY, dt));
+
+		// Only a few balls cross a paddle's plane in a step, so the rest of the paddle test is skipped when none of these do
+		V crossesOne = L::And(L::LessEqual(planeOne, x0), L::Less(x1, planeOne));
+		V crossesTwo = L::And(L::LessEqual(x0, planeTwo), L::Less(planeTwo, x1));
+		if (L::Bits(L::Or(crossesOne, crossesTwo)) != 0)
+		{
+			V moveX = L::Sub(x1, x0);
+			V moveY = L::Sub(y1, y0);
+			V crossOne = L::Add(y0, L::Mul(moveY, L::Div(L::Sub(planeOne, x0), moveX)));
+			V crossTwo = L::Add(y0, L::Mul(moveY, L::Div(L::Sub(planeTwo, x0), moveX)));
+			V hitOne = L::And(crossesOne,
+				L::And(L::Less(paddleOneTop, L::Add(crossOne, ballHeight)), L::Less(crossOne, L::Add(paddleOneTop, paddleHeight))));
+			V hitTwo = L::And(crossesTwo,
+				L::And(L::Less(paddleTwoTop, L::Add(crossTwo, ballHeight)), L::Less(crossTwo, L::Add(paddleTwoTop, paddleHeight))));
+			V hit = L::Or(hitOne, hitTwo);
+
+			V plane = L::Select(hitOne, planeOne, planeTwo);
+			V paddleTop = L::Select(hitOne, paddleOneTop, paddleTwoTop);
+			V ballBottom = L::Add(L::Select(hitOne, crossOne, crossTwo), ballHeight);
+			V top = L::And(L::Less(paddleTop, ballBottom), L::Less(ballBottom, L::Add(paddleTop, firstThird)));
+			V middle = L::And(L::Less(L::Add(paddleTop, firstThird), ballBottom), L::Less(ballBottom, L::Add(paddleTop, secondThird)));
+			V bouncedY = L::Select(top, upSpeed, L::Select(middle, velocityY, downSpeed));
+
+			x1 = L::Select(hit, L::Sub(L::Add(plane, plane), x1), x1);
+			velocityX = L::Select(hit, L::Sub(zero, velocityX), velocityX);
+			velocityY = L::Select(hit, bouncedY, velocityY);
+		}
+
+		V aboveTop = L::Less(y1, zero);
+		V belowBottom = L::Less(bottomWall, y1);
+		V speedY = L::Abs(velocityY);
+		y1 = L::Select(aboveTop, L::Sub(zero, y1), L::Select(belowBottom, L::Sub(L::Add(bottomWall, bottomWall), y1), y1));
+		velocityY = L::Select(aboveTop, speedY, L::Select(belowBottom, L::Sub(zero, speedY), velocityY));
+
+		V pastLeft = L::Less(x1, zero);
+		V pastRight = L::Less(rightEdge, x1);
+		V goal = L::Or(pastLeft, pastRight);
+		if (L::Bits(goal) != 0)
+		{
+			goals.left += CountBits(L::Bits(pastLeft));
+			goals.right += CountBits(L::Bits(pastRight));
+			x1 = L::Select(goal, middleX, x1);
+			velocityX = L::Select(goal, L::Sub(zero, velocityX), velocityX);
+		}
+
+		L::Store(&swarm.x[i], x1);
+		L::Store(&swarm.y[i], y1);
+		L::Store(&swarm.velocityX[i], velocityX);
+		L::Store(&swarm.velocityY[i], velocityY);
+	}
+
+	return i;
+}
+#endif
+
+const char* SwarmKernelName()
+{
+#if defined(BALL_SWARM_AVX)
+	return "AVX";
+#elif defined(BALL_SWARM_SSE)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
+
+SwarmGoals BallSwarm::Step(float dt, const Vec2& paddleOne, const Vec2& paddleTwo)
+{
+	StepConstants k = MakeStepConstants(dt, paddleOne, paddleTwo);
+	SwarmGoals goals;
+	int count = Size();
+	int i = 0;
+
+#ifdef BALL_SWARM_AVX
+	i = StepLanes<AvxLanes>(*this, i, count, k, goals);
+#endif
+#ifdef BALL_SWARM_SSE
+	i = StepLanes<SseLanes>(*this, i, count, k, goals);
+#endif
+
+	for (; i < count; i++)
+	{
+		StepBall(x[i], y[i], velocityX[i], velocityY[i], k, goals);
+	}
+
+	return goals;
+}
+
+SwarmGoals BallSwarm::StepScalar(float dt, const Vec2& paddleOne, const Vec2& paddleTwo)
+{
+	StepConstants k = MakeStepConstants(dt, paddleOne, paddleTwo);
+	SwarmGoals goals;
+
+	for (int i = 0; i < Size(); i++)
+	{
+		StepBall(x[i], y[i], velocityX[i], velocityY[i], k, goals);
+	}
+
+	return goals;
+}
\ No newline at end of file
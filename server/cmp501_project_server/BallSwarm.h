@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include "Global.h"
+#include "Vec2.h"
+
+const int MAX_BALLS = 1024; // balls in a multi-ball match, counting the one that scores
+
+// Balls that got past a paddle in a step
+struct SwarmGoals
+{
+	int left = 0; // past paddle one
+	int right = 0; // past paddle two
+};
+
+// Any number of balls, stored as a structure of arrays (x, y and each velocity in their own contiguous array)
+// so that a step moves four balls at a time with SSE, or eight with AVX when the build targets it
+// Each ball moves in a straight line for the step and is then bounced off the face of any paddle it crossed on the
+// way, and off the top and bottom walls, so it cannot pass through a paddle however long the step. A ball is only
+// bounced once each way a step, which holds as long as it moves less than the height of the field in a step.
+// A ball that gets past a paddle is served again from the middle, at the height it left, towards the other side
+class BallSwarm
+{
+public:
+	void Add(const Vec2& position, const Vec2& velocity);
+	void Clear();
+	int Size() const { return static_cast<int>(x.size()); }
+
+	// Move every ball for dt milliseconds against the paddles (top left corners), several at a time where the build has SIMD
+	SwarmGoals Step(float dt, const Vec2& paddleOne, const Vec2& paddleTwo);
+	// The same one ball at a time, which is what Step falls back to without SIMD and for the balls left over
+	SwarmGoals StepScalar(float dt, const Vec2& paddleOne, const Vec2& paddleTwo);
+
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> velocityX; // pixels per millisecond
+	std::vector<float> velocityY;
+};
+
+// Instruction set Step was built to use: "AVX", "SSE2" or "scalar"
+const char* SwarmKernelName();
\ No newline at end of file
@@ -0,0 +1,438 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <list>
+#include <random>
+#include <vector>
+#include "Benchmark.h"
+#include "Match.h"
+#include "Protocol.h"
+
+// Position message encoding used before the binary protocol, kept here as the benchmark baseline
+static sf::Packet& operator <<(sf::Packet& packet, const Message& message)
+{
+	return packet << message.timestamp << message.x << message.y << message.ball << message.port;
+}
+
+static sf::Packet& operator >>(sf::Packet& packet, Message& message)
+{
+	return packet >> message.timestamp >> message.x >> message.y >> message.ball >> message.port;
+}
+
+// Move a paddle towards the ball as a computer-controlled player would
+static void TrackBall(Paddle& paddle, const Ball& ball, float dt)
+{
+	float paddleCentre = paddle.position.y + PADDLE_HEIGHT / 2.0f;
+	float ballCentre = ball.position.y + BALL_HEIGHT / 2.0f;
+
+	if (ballCentre < paddleCentre - PADDLE_HEIGHT / 4.0f)
+	{
+		paddle.velocity.y = -PADDLE_SPEED;
+	}
+	else if (ballCentre > paddleCentre + PADDLE_HEIGHT / 4.0f)
+	{
+		paddle.velocity.y = PADDLE_SPEED;
+	}
+	else
+	{
+		paddle.velocity.y = 0.0f;
+	}
+
+	paddle.Update(dt);
+}
+
+// Simulate matchCount matches with computer-controlled paddles and no network traffic for
+// simulatedSeconds of game time, then report how many matches one core can run at tickRate
+void RunMatchBenchmark(int matchCount, int tickRate, int simulatedSeconds)
+{
+	std::list<Match> matches;
+	for (int i = 0; i < matchCount; i++)
+	{
+		matches.emplace_back(i + 1, MonotonicMilliseconds());
+		matches.back().logEvents = false;
+		matches.back().ball.velocity.y = 0.75f * BALL_SPEED * ((i % 3) - 1); // vary the serve between matches
+		matches.back().Start();
+	}
+
+	float dt = 1000.0f / tickRate;
+	int ticks = tickRate * simulatedSeconds;
+	long long points = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int t = 0; t < ticks; t++)
+	{
+		for (Match& m : matches)
+		{
+			TrackBall(m.paddleOne, m.ball, dt);
+			TrackBall(m.paddleTwo, m.ball, dt);
+			m.Tick(dt, false);
+		}
+	}
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	for (const Match& m : matches)
+	{
+		points += m.playerOneScore + m.playerTwoScore;
+	}
+
+	double elapsedSeconds = std::chrono::duration<double>(end - start).count();
+	double matchTicks = static_cast<double>(matchCount) * ticks;
+	double nsPerMatchTick = elapsedSeconds * 1e9 / matchTicks;
+	double matchesPerCore = 1e9 / (nsPerMatchTick * tickRate);
+
+	std::cout << "Match benchmark: " << matchCount << " matches, " << tickRate << " ticks per second, "
+		<< simulatedSeconds << " simulated seconds" << std::endl;
+	std::cout << "\t" << ticks << " ticks in " << elapsedSeconds << " s (" << points << " points scored)" << std::endl;
+	std::cout << "\t" << nsPerMatchTick << " ns per match tick" << std::endl;
+	std::cout << "\t" << static_cast<long long>(matchesPerCore) << " matches per core at " << tickRate << " ticks per second" << std::endl;
+}
+
+// Encode and decode messageCount ball positions with the old Message encoding and with the binary
+// protocol, and report the bytes per message, the cost of a round trip and the position error. Then send
+// the same positions as delta-compressed world snapshots and report their size
+void RunProtocolBenchmark(int messageCount)
+{
+	// Positions of a ball bouncing around the field, so the values cover the whole range being quantized
+	std::vector<Vec2> positions(messageCount);
+	Vec2 position((WINDOW_WIDTH / 2.0f), (WINDOW_HEIGHT / 2.0f));
+	Vec2 velocity(BALL_SPEED * 7.3f, BALL_SPEED * 5.1f);
+	for (int i = 0; i < messageCount; i++)
+	{
+		position += velocity;
+		if (position.x < 0.0f || position.x > WINDOW_WIDTH - BALL_WIDTH)
+		{
+			velocity.x = -velocity.x;
+		}
+		if (position.y < 0.0f || position.y > WINDOW_HEIGHT - BALL_HEIGHT)
+		{
+			velocity.y = -velocity.y;
+		}
+		positions[i] = position;
+	}
+
+	sf::Packet packet;
+	double checksum = 0.0;
+
+	// Old encoding
+	std::size_t legacyBytes = 0;
+	Message legacyMsg;
+	Message legacyDecoded;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < messageCount; i++)
+	{
+		legacyMsg.timestamp = i / 100.0;
+		legacyMsg.x = positions[i].x;
+		legacyMsg.y = positions[i].y;
+		legacyMsg.ball = true;
+		legacyMsg.port = 4444;
+
+		packet.clear();
+		packet << legacyMsg;
+		legacyBytes += packet.getDataSize();
+		packet >> legacyDecoded;
+		checksum += legacyDecoded.x + legacyDecoded.y;
+	}
+
+	double legacySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// Binary protocol
+	std::size_t binaryBytes = 0;
+	float maxError = 0.0f;
+	PositionMessage binaryMsg;
+	PositionMessage binaryDecoded;
+	binaryMsg.type = MessageType::PaddlePosition;
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < messageCount; i++)
+	{
+		binaryMsg.sequence = static_cast<uint16_t>(i);
+		binaryMsg.tick = static_cast<uint16_t>(i * 6);
+		binaryMsg.x = positions[i].x;
+		binaryMsg.y = positions[i].y;
+
+		packet.clear();
+		packet << binaryMsg;
+		binaryBytes += packet.getDataSize();
+		packet >> binaryDecoded;
+		checksum += binaryDecoded.x + binaryDecoded.y;
+		maxError = std::max(maxError, std::max(std::abs(binaryDecoded.x - binaryMsg.x), std::abs(binaryDecoded.y - binaryMsg.y)));
+	}
+
+	double binarySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// Snapshots of the same trace, each sent as a delta against the previous one as if every snapshot was
+	// acknowledged straight away, and decoded again against the receiver's history
+	std::size_t fullBytes = 0;
+	std::size_t deltaBytes = 0;
+	std::size_t quietBytes = 0;
+	int snapshotErrors = 0;
+	SnapshotHistory senderHistory;
+	SnapshotHistory receiverHistory;
+	WorldSnapshot snapshot;
+	WorldSnapshot decoded;
+	const WorldSnapshot* baseline = NULL;
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < messageCount; i++)
+	{
+		snapshot.tick = i + 1;
+		snapshot.time = static_cast<uint32_t>(i * 1000 / 60);
+		snapshot.ballX = positions[i].x;
+		snapshot.ballY = positions[i].y;
+		snapshot.paddleOneY = positions[i / 8].y; // paddles move less often than the ball
+		snapshot.playerOneScore = static_cast<uint8_t>(i / 10000);
+		senderHistory.Store(snapshot);
+
+		packet.clear();
+		WriteSnapshot(packet, snapshot, baseline);
+		deltaBytes += packet.getDataSize();
+		if (!ReadSnapshot(packet, receiverHistory, decoded) || decoded.tick != static_cast<uint16_t>(snapshot.tick))
+		{
+			snapshotErrors++;
+		}
+		receiverHistory.Store(decoded);
+		checksum += decoded.ballX + decoded.paddleOneY;
+
+		baseline = senderHistory.Find(static_cast<uint16_t>(snapshot.tick));
+	}
+
+	double snapshotSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	packet.clear();
+	WriteSnapshot(packet, snapshot, NULL);
+	fullBytes = packet.getDataSize();
+	packet.clear();
+	WriteSnapshot(packet, snapshot, &snapshot);
+	quietBytes = packet.getDataSize();
+
+	std::cout << "Protocol benchmark: " << messageCount << " ball position messages (checksum " << checksum << ")" << std::endl;
+	std::cout << "\tMessage:         " << static_cast<double>(legacyBytes) / messageCount << " bytes, "
+		<< legacySeconds * 1e9 / messageCount << " ns per round trip" << std::endl;
+	std::cout << "\tPositionMessage: " << static_cast<double>(binaryBytes) / messageCount << " bytes, "
+		<< binarySeconds * 1e9 / messageCount << " ns per round trip, "
+		<< maxError << " px largest position error" << std::endl;
+	std::cout << "\t" << 100.0 * (1.0 - static_cast<double>(binaryBytes) / legacyBytes) << "% fewer bytes per update" << std::endl;
+	std::cout << "\tWorldSnapshot:   " << fullBytes << " bytes full, " << static_cast<double>(deltaBytes) / messageCount << " bytes per delta, "
+		<< quietBytes << " bytes when nothing changed, " << snapshotSeconds * 1e9 / messageCount << " ns per round trip, "
+		<< snapshotErrors << " decode errors" << std::endl;
+}
+
+// Time testCount paddle collision tests against the current paddle and ball, and the same number rewound
+// to a tick up to rewindTicks in the past, to find the extra cost of lag compensation per collision test
+void RunRewindBenchmark(int testCount, int rewindTicks)
+{
+	Match match(1, MonotonicMilliseconds());
+	match.logEvents = false;
+	match.rewindTicks = rewindTicks;
+	match.Start();
+
+	// Fill the snapshot history, and the paddle history as a client seeing every tick would
+	for (int t = 0; t < MAX_REWIND_TICKS; t++)
+	{
+		TrackBall(match.paddleOne, match.ball, 1000.0f / DEFAULT_TICK_RATE);
+		match.RecordPaddlePosition(1, match.tick, match.paddleOne.position.y);
+		match.Tick(1000.0f / DEFAULT_TICK_RATE, false);
+	}
+
+	// Point the ball at paddle one so the rewound test runs to the end instead of returning early
+	match.ball.velocity.x = -BALL_SPEED;
+
+	int hits = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < testCount; i++)
+	{
+		hits += CheckPaddleCollision(match.ball, match.paddleOne).type != Ball::CollisionType::None;
+	}
+
+	double currentSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < testCount; i++)
+	{
+		uint32_t seenTick = match.tick - (i % rewindTicks);
+		hits += match.CheckRewoundPaddleCollision(1, seenTick).type != Ball::CollisionType::None;
+	}
+
+	double rewoundSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	double currentNs = currentSeconds * 1e9 / testCount;
+	double rewoundNs = rewoundSeconds * 1e9 / testCount;
+
+	std::cout << "Rewind benchmark: " << testCount << " collision tests, rewinding up to " << rewindTicks << " ticks (" << hits << " hits)" << std::endl;
+	std::cout << "\t" << currentNs << " ns per collision test against the current state" << std::endl;
+	std::cout << "\t" << rewoundNs << " ns per rewound collision test" << std::endl;
+	std::cout << "\t" << rewoundNs - currentNs << " ns extra per collision test for lag compensation" << std::endl;
+}
+
+// Move ballCount balls of a multi-ball match for enough ticks to take a moment, one Ball at a time with the swept
+// collision of the main ball, then as a BallSwarm one ball at a time and with SIMD, and report balls moved per microsecond
+void RunBallBenchmark(int ballCount, int tickRate)
+{
+	Match match(1, MonotonicMilliseconds());
+	match.logEvents = false;
+	match.extraBallCount = std::min(ballCount, MAX_BALLS - 1);
+	match.Start();
+
+	float dt = 1000.0f / tickRate;
+	int count = match.extraBalls.Size();
+	int ticks = std::max(10, 20000000 / std::max(count, 1));
+	double ballTicks = static_cast<double>(count) * ticks;
+
+	std::vector<Ball> balls;
+	for (int i = 0; i < count; i++)
+	{
+		balls.emplace_back(Vec2(match.extraBalls.x[i], match.extraBalls.y[i]),
+			Vec2(match.extraBalls.velocityX[i], match.extraBalls.velocityY[i]));
+	}
+
+	long long goals = 0;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int t = 0; t < ticks; t++)
+	{
+		for (Ball& b : balls)
+		{
+			if (b.Move(dt, match.paddleOne.position, match.paddleTwo.position).goal != BallEdge::None)
+			{
+				b.position.x = WINDOW_WIDTH / 2.0f;
+				b.velocity.x = -b.velocity.x;
+				goals++;
+			}
+		}
+	}
+	double ballSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	BallSwarm scalar = match.extraBalls;
+	start = std::chrono::steady_clock::now();
+	for (int t = 0; t < ticks; t++)
+	{
+		SwarmGoals g = scalar.StepScalar(dt, match.paddleOne.position, match.paddleTwo.position);
+		goals += g.left + g.right;
+	}
+	double scalarSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	BallSwarm simd = match.extraBalls;
+	start = std::chrono::steady_clock::now();
+	for (int t = 0; t < ticks; t++)
+	{
+		SwarmGoals g = simd.Step(dt, match.paddleOne.position, match.paddleTwo.position);
+		goals += g.left + g.right;
+	}
+	double simdSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// The two swarm kernels should agree, bar rounding where the compiler fused a multiply and add
+	float largestDifference = 0.0f;
+	for (int i = 0; i < count; i++)
+	{
+		largestDifference = std::max(largestDifference, std::fabs(simd.x[i] - scalar.x[i]));
+		largestDifference = std::max(largestDifference, std::fabs(simd.y[i] - scalar.y[i]));
+	}
+
+	std::cout << "Ball benchmark: " << count << " balls, " << ticks << " ticks at " << tickRate << " ticks per second ("
+		<< goals << " goals)" << std::endl;
+	std::cout << "	Ball::Move:             " << ballTicks / (ballSeconds * 1e6) << " balls per microsecond" << std::endl;
+	std::cout << "	BallSwarm::StepScalar:  " << ballTicks / (scalarSeconds * 1e6) << " balls per microsecond" << std::endl;
+	std::cout << "	BallSwarm::Step (" << SwarmKernelName() << "): " << ballTicks / (simdSeconds * 1e6) << " balls per microsecond, "
+		<< largestDifference << " px largest difference from StepScalar" << std::endl;
+
+	// A paddle that moved onto the ball since the last tick must still send it back, not let it pass through
+	const Vec2& paddle = match.paddleOne.position;
+	Ball caught(Vec2(paddle.x + PADDLE_WIDTH - BALL_WIDTH / 2.0f, paddle.y + (PADDLE_HEIGHT - BALL_HEIGHT) / 2.0f),
+		Vec2(-BALL_SPEED, 0.0f));
+	caught.Move(dt, paddle, match.paddleTwo.position);
+	bool returned = caught.velocity.x > 0.0f && caught.position.x >= paddle.x + PADDLE_WIDTH;
+	std::cout << "	Paddle moved onto the ball: " << (returned ? "returned" : "passed through") << std::endl;
+}
+
+// Input of a computer-controlled paddle in a lockstep match: follow the ball, but one tick in eight press something at
+// random so that points are scored. mt19937 gives the same numbers on every host, where the standard distributions do not
+static PaddleInput ChooseLockstepInput(Fixed paddleY, const LockstepState& state, std::mt19937& random)
+{
+	if (random() % 8 == 0)
+	{
+		return static_cast<PaddleInput>(random() % 3);
+	}
+
+	Fixed paddleCentre = paddleY + Fixed(PADDLE_HEIGHT / 2);
+	Fixed ballCentre = state.ballPosition.y + Fixed::FromRatio(BALL_HEIGHT, 2);
+	if (ballCentre < paddleCentre - Fixed(PADDLE_HEIGHT / 4))
+	{
+		return PaddleInput::Up;
+	}
+	else if (ballCentre > paddleCentre + Fixed(PADDLE_HEIGHT / 4))
+	{
+		return PaddleInput::Down;
+	}
+
+	return PaddleInput::None;
+}
+
+// Play tickCount ticks of a lockstep match between computer-controlled paddles, and report the cost of a tick and
+// the checksum of the final state, which is the same on every host and build. Then play it again to compare the bytes
+// per tick of lockstep updates, to a client that acknowledges every tick, with delta snapshots of the same match
+void RunLockstepBenchmark(int tickCount)
+{
+	std::vector<PaddleInput> inputs(2 * static_cast<std::size_t>(tickCount));
+	std::mt19937 random(1);
+	LockstepState state = StartLockstep();
+	int points = 0;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	for (int t = 0; t < tickCount; t++)
+	{
+		inputs[2 * t] = ChooseLockstepInput(state.paddleOneY, state, random);
+		inputs[2 * t + 1] = ChooseLockstepInput(state.paddleTwoY, state, random);
+		if (StepLockstep(state, inputs[2 * t], inputs[2 * t + 1]).goal != BallEdge::None)
+		{
+			points++;
+		}
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	uint16_t checksum = LockstepChecksum(state);
+
+	// The same inputs again, this time encoding what would be sent for each tick
+	sf::Packet packet;
+	std::size_t lockstepBytes = 0;
+	std::size_t snapshotBytes = 0;
+	std::size_t keyframeBytes = 0;
+	SnapshotHistory history;
+	const WorldSnapshot* baseline = NULL;
+	state = StartLockstep();
+
+	for (int t = 0; t < tickCount; t++)
+	{
+		StepLockstep(state, inputs[2 * t], inputs[2 * t + 1]);
+
+		packet.clear();
+		if (state.tick % LOCKSTEP_KEYFRAME_INTERVAL == 0)
+		{
+			WriteLockstepState(packet, state, 0, 0);
+			keyframeBytes = packet.getDataSize();
+		}
+		else
+		{
+			WriteLockstepInputs(packet, state.tick, 0, 0, LockstepChecksum(state), &inputs[2 * t], &inputs[2 * t + 1], 1);
+		}
+		lockstepBytes += packet.getDataSize();
+
+		WorldSnapshot snapshot = LockstepSnapshot(state);
+		history.Store(snapshot);
+		packet.clear();
+		WriteSnapshot(packet, snapshot, baseline);
+		snapshotBytes += packet.getDataSize();
+		baseline = history.Find(static_cast<uint16_t>(snapshot.tick));
+	}
+
+	std::cout << "Lockstep benchmark: " << tickCount << " ticks (" << points << " points scored)" << std::endl;
+	std::cout << "\t" << seconds * 1e9 / tickCount << " ns per tick, final state checksum " << checksum
+		<< (LockstepChecksum(state) == checksum ? "" : " (differs on the second run!)") << std::endl;
+	std::cout << "\t" << static_cast<double>(lockstepBytes) / tickCount << " bytes per tick with lockstep updates ("
+		<< keyframeBytes << " byte keyframe every " << LOCKSTEP_KEYFRAME_INTERVAL << " ticks), "
+		<< static_cast<double>(snapshotBytes) / tickCount << " bytes per tick with delta snapshots" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,7 @@
+#pragma once
+
+void RunMatchBenchmark(int matchCount, int tickRate, int simulatedSeconds);
+void RunProtocolBenchmark(int messageCount);
+void RunRewindBenchmark(int testCount, int rewindTicks);
+void RunBallBenchmark(int ballCount, int tickRate);
+void RunLockstepBenchmark(int tickCount);
\ No newline at end of file
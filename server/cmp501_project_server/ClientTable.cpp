@@ -0,0 +1,148 @@
+#include "ClientTable.h"
+#include "Match.h"
+#include "Logger.h"
+
+ClientTable::ClientTable()
+{
+	std::random_device device;
+	std::seed_seq seed{ device(), device(), device(), device() };
+	random.seed(seed);
+}
+
+bool ClientTable::IsFull() const
+{
+	return freeSlots.empty() && slots.size() == MAX_SESSIONS;
+}
+
+int ClientTable::Size() const
+{
+	return size;
+}
+
+// Give a client a slot, returning its session ID, or 0 if the table is full
+uint64_t ClientTable::Add(Match* match, Client* client)
+{
+	uint32_t index = 0;
+	if (!freeSlots.empty())
+	{
+		index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else if (slots.size() < MAX_SESSIONS)
+	{
+		index = static_cast<uint32_t>(slots.size());
+		slots.emplace_back();
+	}
+	else
+	{
+		return 0;
+	}
+
+	Slot& slot = slots[index];
+	slot.session.match = match;
+	slot.session.client = client;
+	slot.key = static_cast<uint32_t>(random());
+	slot.used = true;
+	size++;
+	return (static_cast<uint64_t>(slot.key) << 32) | (slot.generation << SESSION_INDEX_BITS) | index;
+}
+
+// Free the slot of a session, and retire its ID by moving the slot on a generation
+void ClientTable::Remove(uint64_t sessionId)
+{
+	if (Find(sessionId) == NULL)
+	{
+		return;
+	}
+
+	uint32_t index = static_cast<uint32_t>(sessionId) & (MAX_SESSIONS - 1);
+	Slot& slot = slots[index];
+	if (slot.endpoint != 0)
+	{
+		sessionsByEndpoint.erase(slot.endpoint);
+	}
+
+	uint32_t generation = slot.generation;
+	slot = Slot();
+	slot.generation = generation % (SESSION_GENERATIONS - 1) + 1;
+	freeSlots.push_back(index);
+	size--;
+}
+
+// Get a live session, or NULL if the ID was never given out, its client has departed or its key is wrong
+ClientSession* ClientTable::Find(uint64_t sessionId)
+{
+	uint32_t index = static_cast<uint32_t>(sessionId) & (MAX_SESSIONS - 1);
+	if (index >= slots.size())
+	{
+		return NULL;
+	}
+
+	Slot& slot = slots[index];
+	if (!slot.used
+		|| slot.generation != (static_cast<uint32_t>(sessionId) >> SESSION_INDEX_BITS)
+		|| slot.key != static_cast<uint32_t>(sessionId >> 32))
+	{
+		return NULL;
+	}
+
+	return &slot.session;
+}
+
+// Get the session of a datagram from address:port carrying sessionId, or NULL unless the session is bound to that
+// endpoint. Only a hello binds a session, so any other datagram must come from where its client said hello
+ClientSession* ClientTable::FindByEndpoint(const sf::IpAddress& address, unsigned short port, uint64_t sessionId)
+{
+	std::unordered_map<uint64_t, uint64_t>::iterator it = sessionsByEndpoint.find(EndpointKey(address, port));
+	if (it == sessionsByEndpoint.end() || it->second != sessionId)
+	{
+		return NULL;
+	}
+
+	return Find(sessionId);
+}
+
+// Take the hello of a session from address:port as where its client is from now on. Returns NULL if the session is
+// not live, or if the endpoint belongs to another live session, so a client can neither be reached through a stale
+// or guessed ID nor take over another client's endpoint
+ClientSession* ClientTable::Bind(uint64_t sessionId, const sf::IpAddress& address, unsigned short port)
+{
+	ClientSession* session = Find(sessionId);
+	if (session == NULL)
+	{
+		return NULL;
+	}
+
+	Slot& slot = slots[static_cast<uint32_t>(sessionId) & (MAX_SESSIONS - 1)];
+	uint64_t endpoint = EndpointKey(address, port);
+	if (slot.endpoint == endpoint)
+	{
+		return session;
+	}
+
+	// Entries are erased as sessions are removed, so any session still holding the endpoint is live
+	if (sessionsByEndpoint.count(endpoint) > 0)
+	{
+		return NULL;
+	}
+
+	// A client that says hello again from elsewhere, as after its NAT mapping changed, is sent datagrams there from now on
+	if (slot.endpoint != 0)
+	{
+		LOG_INFO(LogCategory::Network) << "Session " << sessionId << " now at " << address.toString() << " at " << "port " << port;
+		sessionsByEndpoint.erase(slot.endpoint);
+	}
+
+	slot.endpoint = endpoint;
+	sessionsByEndpoint[endpoint] = sessionId;
+	Client& client = *(*session).client;
+	client.udpAddress = address;
+	client.udpPort = port;
+	return session;
+}
+
+// Address in the high bits and port in the low bits. Never 0 for a real sender, which has a nonzero port
+uint64_t ClientTable::EndpointKey(const sf::IpAddress& address, unsigned short port)
+{
+	return (static_cast<uint64_t>(address.toInteger()) << 16) | port;
+}
\ No newline at end of file
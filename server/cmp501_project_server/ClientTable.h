@@ -0,0 +1,57 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+class Match;
+struct Client;
+
+// Session IDs hold the index of the client's slot in the low bits and the slot's generation above it, so the ID of a
+// departed client stops matching as soon as its slot is freed, even once the slot is reused. The high 32 bits are a
+// random key, checked against the slot, so an ID cannot be guessed by anyone it was not sent to over tcp
+const int SESSION_INDEX_BITS = 20;
+const uint32_t MAX_SESSIONS = 1u << SESSION_INDEX_BITS;
+const uint32_t SESSION_GENERATIONS = 1u << (32 - SESSION_INDEX_BITS); // generations run from 1, so no session ID is 0
+
+struct ClientSession
+{
+	Match* match = NULL;
+	Client* client = NULL;
+};
+
+// Every connected client by session ID and by the endpoint its datagrams come from, found in constant time
+// however many are connected. A slot map: sessions live in a vector indexed by session ID, and freed slots are reused
+class ClientTable
+{
+public:
+	ClientTable();
+
+	bool IsFull() const;
+	int Size() const;
+
+	uint64_t Add(Match* match, Client* client);
+	void Remove(uint64_t sessionId);
+	ClientSession* Find(uint64_t sessionId);
+	ClientSession* FindByEndpoint(const sf::IpAddress& address, unsigned short port, uint64_t sessionId);
+	ClientSession* Bind(uint64_t sessionId, const sf::IpAddress& address, unsigned short port);
+
+private:
+	struct Slot
+	{
+		ClientSession session;
+		uint64_t endpoint = 0; // key of the endpoint the session is bound to, 0 until it is bound
+		uint32_t generation = 1;
+		uint32_t key = 0; // random high bits of the session ID
+		bool used = false;
+	};
+
+	static uint64_t EndpointKey(const sf::IpAddress& address, unsigned short port);
+
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots; // indexes of unused slots, reused most recently freed first
+	std::unordered_map<uint64_t, uint64_t> sessionsByEndpoint;
+	std::mt19937 random; // seeded from std::random_device, for the keys of session IDs
+	int size = 0;
+};
\ No newline at end of file
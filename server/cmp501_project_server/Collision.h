@@ -0,0 +1,55 @@
+#pragma once
+#include "Global.h"
+#include "Vec2.h"
+#include "Fixed.h"
+
+/* Continuous collision of the ball with the walls and paddles
+*
+*	Shared by the server, which plays the ball with it, and the client, which projects the ball with
+*	it (keep the copies in both projects identical). The ball is swept along its path over the whole
+*	step and stopped at the first thing it touches, bounced, and swept on for the rest of the step, so
+*	it cannot pass through a paddle however long the step or fast the ball. Written for any number type:
+*	float for the snapshot game and Fixed for the lockstep simulation, which follows the same rules bit
+*	for bit on every host
+*/
+
+const int MAX_BALL_BOUNCES = 16; // bounces followed in one step, the rest of a step with more is dropped
+
+// First touch of a box swept along a move against a box standing still
+template <typename T>
+struct BasicSweepHit
+{
+	T time = T(0); // fraction of the move at first touch, from 0 to 1
+	Vector2<T> normal; // side of the obstacle touched, (-1, 0) for its left side and so on
+};
+
+typedef BasicSweepHit<float> SweepHit;
+
+// Slab test of a box (top left corner position) moved by move against an obstacle. Returns false if the box misses it
+// or moves away from it. A box that already overlaps it at the start of the move hits it at time 0, on the side it is
+// least far into
+template <typename T>
+bool SweepBox(const Vector2<T>& position, const Vector2<T>& size, const Vector2<T>& move, const Vector2<T>& obstacle,
+	const Vector2<T>& obstacleSize, BasicSweepHit<T>& hit);
+
+enum class BallEdge
+{
+	None,
+	Left, // past paddle one, so player two scores
+	Right // past paddle two, so player one scores
+};
+
+// What the ball ran into over one step
+struct BallMove
+{
+	int paddle = 0; // 1 or 2 for the last paddle the ball bounced off, 0 if none
+	int bounces = 0;
+	BallEdge goal = BallEdge::None; // edge the ball reached, where it is left for the caller to restart
+	float remaining = 0.0f; // milliseconds of the step left over after a goal, for information only
+};
+
+// Move the ball (top left corner position, velocity in pixels per millisecond) for dt milliseconds, bouncing off
+// the top and bottom walls and the paddles (top left corners) by the rules of the game. A paddle bounces the ball
+// back with a vertical speed that depends on which third of the paddle it hits, and off its top or bottom vertically
+template <typename T>
+BallMove MoveBall(Vector2<T>& position, Vector2<T>& velocity, T dt, const Vector2<T>& paddleOne, const Vector2<T>& paddleTwo);
\ No newline at end of file
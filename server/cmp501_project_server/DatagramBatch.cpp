@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <string.h>
+#include "DatagramBatch.h"
+#ifdef __linux__
+#include <arpa/inet.h>
+#endif
+
+DatagramBatch::DatagramBatch(ReactorUdpSocket& socket)
+	: socket(socket),
+	receiveBuffers(DATAGRAM_BATCH_SIZE * MAX_DATAGRAM_SIZE),
+	receiveSizes(DATAGRAM_BATCH_SIZE),
+	receiveAddresses(DATAGRAM_BATCH_SIZE),
+	receivePorts(DATAGRAM_BATCH_SIZE),
+	sendBuffers(DATAGRAM_BATCH_SIZE * MAX_DATAGRAM_SIZE),
+	sendSizes(DATAGRAM_BATCH_SIZE),
+	sendAddresses(DATAGRAM_BATCH_SIZE),
+	sendPorts(DATAGRAM_BATCH_SIZE)
+{
+#ifdef __linux__
+	receiveHeaders.resize(DATAGRAM_BATCH_SIZE);
+	receiveVectors.resize(DATAGRAM_BATCH_SIZE);
+	receiveNames.resize(DATAGRAM_BATCH_SIZE);
+	sendHeaders.resize(DATAGRAM_BATCH_SIZE);
+	sendVectors.resize(DATAGRAM_BATCH_SIZE);
+	sendNames.resize(DATAGRAM_BATCH_SIZE);
+
+	// Receive buffers never move, so their headers only need to be set up once
+	for (int i = 0; i < DATAGRAM_BATCH_SIZE; i++)
+	{
+		receiveVectors[i].iov_base = &receiveBuffers[i * MAX_DATAGRAM_SIZE];
+		receiveVectors[i].iov_len = MAX_DATAGRAM_SIZE;
+		sendVectors[i].iov_base = &sendBuffers[i * MAX_DATAGRAM_SIZE];
+	}
+#endif
+}
+
+// Receive up to a batch of pending datagrams without blocking, returning how many were received
+// Call until IsDrained() (or a return of 0) to empty the socket
+int DatagramBatch::Receive()
+{
+	int count = 0;
+
+#ifdef __linux__
+	for (int i = 0; i < DATAGRAM_BATCH_SIZE; i++)
+	{
+		memset(&receiveHeaders[i], 0, sizeof(mmsghdr));
+		receiveHeaders[i].msg_hdr.msg_iov = &receiveVectors[i];
+		receiveHeaders[i].msg_hdr.msg_iovlen = 1;
+		receiveHeaders[i].msg_hdr.msg_name = &receiveNames[i];
+		receiveHeaders[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+	}
+
+	count = recvmmsg(socket.getHandle(), receiveHeaders.data(), DATAGRAM_BATCH_SIZE, MSG_DONTWAIT, NULL);
+	stats.receiveCalls++;
+	if (count < 0)
+	{
+		// Nothing pending (or an error that a later call will report again)
+		drained = true;
+		return 0;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		receiveSizes[i] = receiveHeaders[i].msg_len;
+		receiveAddresses[i] = sf::IpAddress(ntohl(receiveNames[i].sin_addr.s_addr));
+		receivePorts[i] = ntohs(receiveNames[i].sin_port);
+	}
+#else
+	while (count < DATAGRAM_BATCH_SIZE)
+	{
+		stats.receiveCalls++;
+		if (socket.receive(&receiveBuffers[count * MAX_DATAGRAM_SIZE], MAX_DATAGRAM_SIZE, receiveSizes[count],
+			receiveAddresses[count], receivePorts[count]) != sf::Socket::Done)
+		{
+			break;
+		}
+
+		count++;
+	}
+#endif
+
+	// A short batch means the socket had nothing more to give
+	drained = count < DATAGRAM_BATCH_SIZE;
+	stats.datagramsReceived += count;
+	stats.largestReceiveBatch = std::max(stats.largestReceiveBatch, count);
+
+	return count;
+}
+
+// Copy a packet into the outgoing batch, sending the batch first if it is full
+void DatagramBatch::Queue(const sf::Packet& packet, const sf::IpAddress& address, unsigned short port)
+{
+	if (packet.getDataSize() > MAX_DATAGRAM_SIZE)
+	{
+		stats.sendErrors++;
+		return;
+	}
+
+	if (queued == DATAGRAM_BATCH_SIZE)
+	{
+		Flush();
+	}
+
+	memcpy(&sendBuffers[queued * MAX_DATAGRAM_SIZE], packet.getData(), packet.getDataSize());
+	sendSizes[queued] = packet.getDataSize();
+	sendAddresses[queued] = address;
+	sendPorts[queued] = port;
+	queued++;
+}
+
+// Send every queued datagram
+void DatagramBatch::Flush()
+{
+	if (queued == 0)
+	{
+		return;
+	}
+
+	stats.largestSendBatch = std::max(stats.largestSendBatch, queued);
+
+#ifdef __linux__
+	for (int i = 0; i < queued; i++)
+	{
+		memset(&sendNames[i], 0, sizeof(sockaddr_in));
+		sendNames[i].sin_family = AF_INET;
+		sendNames[i].sin_addr.s_addr = htonl(sendAddresses[i].toInteger());
+		sendNames[i].sin_port = htons(sendPorts[i]);
+
+		sendVectors[i].iov_len = sendSizes[i];
+
+		memset(&sendHeaders[i], 0, sizeof(mmsghdr));
+		sendHeaders[i].msg_hdr.msg_iov = &sendVectors[i];
+		sendHeaders[i].msg_hdr.msg_iovlen = 1;
+		sendHeaders[i].msg_hdr.msg_name = &sendNames[i];
+		sendHeaders[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+	}
+
+	// sendmmsg stops at the first datagram that fails, so skip past it and carry on with the rest
+	int sent = 0;
+	while (sent < queued)
+	{
+		int count = sendmmsg(socket.getHandle(), &sendHeaders[sent], queued - sent, MSG_DONTWAIT);
+		stats.sendCalls++;
+		if (count <= 0)
+		{
+			stats.sendErrors++;
+			sent++;
+			continue;
+		}
+
+		stats.datagramsSent += count;
+		sent += count;
+	}
+#else
+	for (int i = 0; i < queued; i++)
+	{
+		stats.sendCalls++;
+		if (socket.send(&sendBuffers[i * MAX_DATAGRAM_SIZE], sendSizes[i], sendAddresses[i], sendPorts[i]) != sf::Socket::Done)
+		{
+			stats.sendErrors++;
+			continue;
+		}
+
+		stats.datagramsSent++;
+	}
+#endif
+
+	queued = 0;
+}
\ No newline at end of file
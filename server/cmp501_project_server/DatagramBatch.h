@@ -0,0 +1,71 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include <vector>
+#include "Reactor.h"
+#ifdef __linux__
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+const int DATAGRAM_BATCH_SIZE = 64; // datagrams moved per system call
+const int MAX_DATAGRAM_SIZE = 1472; // largest payload that fits an ethernet frame unfragmented
+
+// Batched datagram layer over the server udp socket
+// On Linux every pending datagram is received with recvmmsg and every queued datagram is sent
+// with sendmmsg, DATAGRAM_BATCH_SIZE at a time, instead of one system call per datagram
+// Other platforms fall back to a receive/send call per datagram behind the same interface
+class DatagramBatch
+{
+public:
+	struct Stats
+	{
+		uint64_t receiveCalls = 0;
+		uint64_t datagramsReceived = 0;
+		uint64_t sendCalls = 0;
+		uint64_t datagramsSent = 0;
+		uint64_t sendErrors = 0;
+		int largestReceiveBatch = 0;
+		int largestSendBatch = 0;
+	};
+
+	DatagramBatch(ReactorUdpSocket& socket);
+
+	int Receive();
+	const char* Data(int i) const { return &receiveBuffers[i * MAX_DATAGRAM_SIZE]; }
+	std::size_t Size(int i) const { return receiveSizes[i]; }
+	sf::IpAddress Address(int i) const { return receiveAddresses[i]; }
+	unsigned short Port(int i) const { return receivePorts[i]; }
+
+	void Queue(const sf::Packet& packet, const sf::IpAddress& address, unsigned short port);
+	void Flush();
+
+	bool IsDrained() const { return drained; }
+	const Stats& GetStats() const { return stats; }
+
+private:
+	ReactorUdpSocket& socket;
+	Stats stats;
+	bool drained = false; // last receive returned fewer datagrams than a full batch
+
+	std::vector<char> receiveBuffers;
+	std::vector<std::size_t> receiveSizes;
+	std::vector<sf::IpAddress> receiveAddresses;
+	std::vector<unsigned short> receivePorts;
+
+	std::vector<char> sendBuffers;
+	std::vector<std::size_t> sendSizes;
+	std::vector<sf::IpAddress> sendAddresses;
+	std::vector<unsigned short> sendPorts;
+	int queued = 0;
+
+#ifdef __linux__
+	std::vector<mmsghdr> receiveHeaders;
+	std::vector<iovec> receiveVectors;
+	std::vector<sockaddr_in> receiveNames;
+
+	std::vector<mmsghdr> sendHeaders;
+	std::vector<iovec> sendVectors;
+	std::vector<sockaddr_in> sendNames;
+#endif
+};
\ No newline at end of file
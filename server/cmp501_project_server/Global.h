@@ -5,6 +5,12 @@ const int WINDOW_HEIGHT = 720;
 const float PADDLE_SPEED = 0.75f;
 const float BALL_SPEED = 0.5f;
 
+const int PADDLE_WIDTH = 15;
+const int PADDLE_HEIGHT = 90;
+
+const int BALL_WIDTH = 15;
+const int BALL_HEIGHT = 15;
+
 struct Message
 {
 	double timestamp = 0;
@@ -0,0 +1,57 @@
+#include <algorithm>
+#include "Heartbeat.h"
+#include "Protocol.h"
+
+void Heartbeat::Reset(double now)
+{
+	nextSend = now;
+	lastHeard = now;
+	roundTrip = RoundTripEstimator();
+	unanswered.clear();
+	losses = 0;
+}
+
+void Heartbeat::Write(sf::Packet& packet, double now)
+{
+	uint32_t time = static_cast<uint32_t>(static_cast<uint64_t>(now));
+	WriteHeartbeat(packet, time);
+	unanswered.push_back(time);
+	nextSend = now + HEARTBEAT_INTERVAL;
+}
+
+// The echoed time is the server's own, so the round trip is the time since then. The difference is taken on 32 bits
+// so it is right across the wrap of the server time. Duplicates and echoes of heartbeats already taken as lost give no sample
+void Heartbeat::ReceiveEcho(uint32_t sentTime, double now)
+{
+	std::deque<uint32_t>::iterator it = std::find(unanswered.begin(), unanswered.end(), sentTime);
+	if (it == unanswered.end())
+	{
+		return;
+	}
+
+	unanswered.erase(it);
+
+	uint32_t roundTripMilliseconds = static_cast<uint32_t>(static_cast<uint64_t>(now)) - sentTime;
+	if (roundTripMilliseconds > MAX_HEARTBEAT_ROUND_TRIP)
+	{
+		return;
+	}
+
+	roundTrip.AddSample(static_cast<double>(roundTripMilliseconds));
+}
+
+int Heartbeat::TakeLosses(double now)
+{
+	double timeout = roundTrip.Measured() ? roundTrip.Timeout(MIN_HEARTBEAT_LOSS_TIMEOUT, MAX_HEARTBEAT_LOSS_TIMEOUT) : MAX_HEARTBEAT_LOSS_TIMEOUT;
+	uint32_t time = static_cast<uint32_t>(static_cast<uint64_t>(now));
+
+	int lost = 0;
+	while (!unanswered.empty() && static_cast<double>(static_cast<uint32_t>(time - unanswered.front())) >= timeout)
+	{
+		unanswered.pop_front();
+		lost++;
+	}
+
+	losses += lost;
+	return lost;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include <deque>
+#include "RoundTrip.h"
+
+const double DEFAULT_LIVENESS_MILLISECONDS = 2000.0; // a client heard nothing from for this long is taken as gone
+const double MAX_HEARTBEAT_ROUND_TRIP = 10000.0; // echoes taking longer are stale or corrupt, and ignored
+const double MIN_HEARTBEAT_LOSS_TIMEOUT = 250.0; // milliseconds an echo is waited for before the heartbeat is taken as lost
+const double MAX_HEARTBEAT_LOSS_TIMEOUT = 1000.0; // and the wait before a round trip has been measured
+
+// The liveness and round trip of one client. Heartbeats are sent to the client every HEARTBEAT_INTERVAL and echoed
+// straight back, each echo giving a round trip sample. Any datagram from the client counts as hearing from it, so a
+// client sending inputs stays alive even if every echo is lost. A heartbeat whose echo has not come back within a
+// timeout worked out from the round trip counts as lost, which is a sign of congestion. Times are milliseconds of server time
+class Heartbeat
+{
+public:
+	// Start over, as if the client had just been heard from, so it gets a full liveness timeout
+	void Reset(double now);
+
+	bool ShouldSend(double now) const { return now >= nextSend; }
+	void Write(sf::Packet& packet, double now);
+
+	void Heard(double now) { lastHeard = now; }
+	void ReceiveEcho(uint32_t sentTime, double now);
+
+	// Heartbeats taken as lost since the last call
+	int TakeLosses(double now);
+
+	bool IsAlive(double now, double timeout) const { return now - lastHeard < timeout; }
+	double LastHeard() const { return lastHeard; }
+	const RoundTripEstimator& RoundTrip() const { return roundTrip; }
+	uint64_t Losses() const { return losses; }
+
+private:
+	double nextSend = 0.0;
+	double lastHeard = 0.0;
+	RoundTripEstimator roundTrip;
+	std::deque<uint32_t> unanswered; // times of the heartbeats sent and not yet echoed, oldest first
+	uint64_t losses = 0;
+};
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "Lockstep.h"
+
+// Where Match puts the paddles
+static constexpr Fixed PADDLE_ONE_X(50);
+static constexpr Fixed PADDLE_TWO_X(WINDOW_WIDTH - 50);
+
+static Fixed MovePaddle(Fixed y, PaddleInput input)
+{
+	const Fixed step = Fixed(PADDLE_SPEED) * LOCKSTEP_DT;
+
+	if (input == PaddleInput::Up)
+	{
+		y -= step;
+	}
+	else if (input == PaddleInput::Down)
+	{
+		y += step;
+	}
+
+	if (y < Fixed(0))
+	{
+		y = Fixed(0);
+	}
+	else if (y > Fixed(WINDOW_HEIGHT - PADDLE_HEIGHT))
+	{
+		y = Fixed(WINDOW_HEIGHT - PADDLE_HEIGHT);
+	}
+
+	return y;
+}
+
+LockstepState StartLockstep()
+{
+	LockstepState state;
+	state.tick = 1;
+	state.ballPosition = FixedVec2(Fixed::FromRatio(WINDOW_WIDTH - BALL_WIDTH, 2), Fixed::FromRatio(WINDOW_HEIGHT - BALL_WIDTH, 2));
+	state.ballVelocity = FixedVec2(Fixed(BALL_SPEED), Fixed(0));
+	state.paddleOneY = Fixed::FromRatio(WINDOW_HEIGHT - PADDLE_HEIGHT, 2);
+	state.paddleTwoY = state.paddleOneY;
+
+	return state;
+}
+
+BallMove StepLockstep(LockstepState& state, PaddleInput paddleOne, PaddleInput paddleTwo)
+{
+	state.paddleOneY = MovePaddle(state.paddleOneY, paddleOne);
+	state.paddleTwoY = MovePaddle(state.paddleTwoY, paddleTwo);
+
+	BallMove move = MoveBall(state.ballPosition, state.ballVelocity, LOCKSTEP_DT,
+		FixedVec2(PADDLE_ONE_X, state.paddleOneY), FixedVec2(PADDLE_TWO_X, state.paddleTwoY));
+
+	// Serve from the middle towards the player who scored, as Ball::Serve does
+	if (move.goal != BallEdge::None)
+	{
+		state.ballPosition = FixedVec2(Fixed(WINDOW_WIDTH / 2), Fixed(WINDOW_HEIGHT / 2));
+		state.ballVelocity = FixedVec2(move.goal == BallEdge::Left ? Fixed(BALL_SPEED) : -Fixed(BALL_SPEED), Fixed(0.75f * BALL_SPEED));
+
+		if (move.goal == BallEdge::Left)
+		{
+			state.playerTwoScore++;
+		}
+		else
+		{
+			state.playerOneScore++;
+		}
+	}
+
+	state.tick++;
+	return move;
+}
+
+// FNV-1a over the 32-bit values of the state
+uint16_t LockstepChecksum(const LockstepState& state)
+{
+	const uint32_t values[] = {
+		state.tick & 0xFFFF,
+		static_cast<uint32_t>(state.ballPosition.x.Raw()),
+		static_cast<uint32_t>(state.ballPosition.y.Raw()),
+		static_cast<uint32_t>(state.ballVelocity.x.Raw()),
+		static_cast<uint32_t>(state.ballVelocity.y.Raw()),
+		static_cast<uint32_t>(state.paddleOneY.Raw()),
+		static_cast<uint32_t>(state.paddleTwoY.Raw()),
+		static_cast<uint32_t>(state.playerOneScore) | (static_cast<uint32_t>(state.playerTwoScore) << 8)
+	};
+
+	uint32_t hash = 2166136261u;
+	for (uint32_t value : values)
+	{
+		for (int byte = 0; byte < 4; byte++)
+		{
+			hash ^= (value >> (byte * 8)) & 0xFF;
+			hash *= 16777619u;
+		}
+	}
+
+	return static_cast<uint16_t>(hash ^ (hash >> 16));
+}
+
+WorldSnapshot LockstepSnapshot(const LockstepState& state)
+{
+	WorldSnapshot snapshot;
+	snapshot.tick = state.tick;
+	snapshot.ballX = static_cast<float>(state.ballPosition.x);
+	snapshot.ballY = static_cast<float>(state.ballPosition.y);
+	snapshot.ballVelocityX = static_cast<float>(state.ballVelocity.x);
+	snapshot.ballVelocityY = static_cast<float>(state.ballVelocity.y);
+	snapshot.paddleOneY = static_cast<float>(state.paddleOneY);
+	snapshot.paddleTwoY = static_cast<float>(state.paddleTwoY);
+	snapshot.playerOneScore = state.playerOneScore;
+	snapshot.playerTwoScore = state.playerTwoScore;
+
+	return snapshot;
+}
\ No newline at end of file
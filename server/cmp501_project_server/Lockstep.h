@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include "Global.h"
+#include "Fixed.h"
+#include "Collision.h"
+#include "Protocol.h"
+
+/* Deterministic simulation of a match, for lockstep play
+*
+*	Shared by the server and the client (keep the copies in both projects identical). The match is played
+*	by the rules of the snapshot game, paddles first and then the ball swept by MoveBall, but on Fixed
+*	numbers, so the same inputs give the same state bit for bit on every host. The server then only has
+*	to send each client the inputs of both paddles every tick, and the client plays the match out itself
+*	instead of correcting towards snapshots. Every tick is one input command long, INPUT_DT milliseconds
+*/
+
+constexpr Fixed LOCKSTEP_DT = Fixed::FromRatio(1000, INPUT_RATE); // milliseconds simulated per tick
+const int LOCKSTEP_KEYFRAME_INTERVAL = 2 * INPUT_RATE; // ticks between full states sent, so a client that went wrong recovers
+
+// The state a match starts in, at tick 1: paddles in the middle and the ball served towards paddle two
+LockstepState StartLockstep();
+
+// Simulate one tick of a match with the input of each paddle, serving the ball from the middle after a goal
+BallMove StepLockstep(LockstepState& state, PaddleInput paddleOne, PaddleInput paddleTwo);
+
+// Hash of a state, for clients to check they are still in step with the server. Covers the low 16 bits of the tick
+uint16_t LockstepChecksum(const LockstepState& state);
+
+// The state as a snapshot, with the time and input acknowledgement left for the caller to fill in
+WorldSnapshot LockstepSnapshot(const LockstepState& state);
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+enum class LogLevel : uint8_t
+{
+	Debug,
+	Info,
+	Warning,
+	Error,
+	Off
+};
+
+enum class LogCategory : uint8_t
+{
+	General,
+	Network,
+	Match,
+	Input,
+	Snapshot,
+	Prediction,
+	Count
+};
+
+const int LOG_RING_SIZE = 1024; // lines buffered between the game loop and the flush thread, must be a power of two
+const int LOG_MESSAGE_SIZE = 232; // longer lines are truncated
+const int DEFAULT_LOG_RATE_LIMIT = 100; // debug and info lines per second per category
+const int LOG_FLUSH_INTERVAL_MILLISECONDS = 5; // how long the flush thread sleeps when there is nothing to write
+
+// Asynchronous logger shared by the whole program
+// Lines are formatted by the calling thread into a fixed-size slot of a lock-free ring buffer and written
+// to stdout by a background thread, so logging never waits on the terminal. When the ring is full the line
+// is dropped and counted rather than waiting for space, and debug and info lines beyond the rate limit of
+// their category are dropped before they are formatted. Warnings and errors are never rate limited
+class Logger
+{
+public:
+	struct Stats
+	{
+		uint64_t written = 0;
+		uint64_t dropped = 0; // ring buffer was full
+		uint64_t rateLimited = 0;
+	};
+
+	static Logger& Instance();
+
+	void Start();
+	void Stop();
+
+	void SetLevel(LogLevel level) { minLevel.store(level, std::memory_order_relaxed); }
+	LogLevel GetLevel() const { return minLevel.load(std::memory_order_relaxed); }
+	void SetRateLimit(int linesPerSecond) { rateLimit.store(linesPerSecond, std::memory_order_relaxed); }
+
+	bool ShouldLog(LogLevel level, LogCategory category);
+	void Write(LogLevel level, LogCategory category, uint64_t time, const char* text, std::size_t length);
+	uint64_t Now() const;
+	Stats GetStats() const;
+
+	static bool ParseLevel(const std::string& name, LogLevel& level);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Entry
+	{
+		std::atomic<uint64_t> sequence; // equals the write position when free, and the position + 1 once written
+		uint64_t time = 0; // nanoseconds since the logger was created
+		LogLevel level = LogLevel::Info;
+		LogCategory category = LogCategory::General;
+		uint16_t length = 0;
+		char text[LOG_MESSAGE_SIZE];
+	};
+
+	// Lines let through for a category in the current one second window
+	struct CategoryLimit
+	{
+		std::atomic<uint32_t> window{ 0 };
+		std::atomic<uint32_t> count{ 0 };
+	};
+
+	Logger();
+	~Logger();
+	Logger(const Logger&) = delete;
+	Logger& operator=(const Logger&) = delete;
+
+	void Run();
+	int Drain(std::string& output);
+	void ReportDrops(std::string& output);
+
+	Clock::time_point startTime;
+	std::unique_ptr<Entry[]> entries;
+	std::atomic<uint64_t> head{ 0 }; // next position to write, shared by the logging threads
+	uint64_t tail = 0; // next position to read, only used by the flush thread
+	std::atomic<LogLevel> minLevel{ LogLevel::Info };
+	std::atomic<int> rateLimit{ DEFAULT_LOG_RATE_LIMIT };
+	CategoryLimit limits[static_cast<int>(LogCategory::Count)];
+
+	std::atomic<uint64_t> written{ 0 };
+	std::atomic<uint64_t> dropped{ 0 };
+	std::atomic<uint64_t> rateLimited{ 0 };
+	uint64_t reportedDropped = 0;
+	uint64_t reportedRateLimited = 0;
+	uint64_t lastReportTime = 0;
+
+	std::atomic<bool> running{ false };
+	std::thread thread;
+};
+
+// A single log line, formatted on the stack and handed to the logger when it goes out of scope
+// Use through the LOG_* macros so nothing is formatted when the line would not be logged
+class LogLine
+{
+public:
+	LogLine(LogLevel level, LogCategory category);
+	~LogLine();
+
+	LogLine& operator<<(const char* text);
+	LogLine& operator<<(const std::string& text);
+	LogLine& operator<<(char c);
+	LogLine& operator<<(bool value);
+	LogLine& operator<<(int value);
+	LogLine& operator<<(unsigned int value);
+	LogLine& operator<<(long value);
+	LogLine& operator<<(unsigned long value);
+	LogLine& operator<<(long long value);
+	LogLine& operator<<(unsigned long long value);
+	LogLine& operator<<(double value);
+
+private:
+	void Append(const char* text, std::size_t count);
+
+	LogLevel level;
+	LogCategory category;
+	uint64_t time;
+	std::size_t length = 0;
+	char text[LOG_MESSAGE_SIZE];
+};
+
+// Gives the conditional in LOG a void result on both sides
+struct LogVoidify
+{
+	void operator&(const LogLine&) {}
+};
+
+#define LOG(level, category) !Logger::Instance().ShouldLog(level, category) ? (void)0 : LogVoidify() & LogLine(level, category)
+#define LOG_DEBUG(category) LOG(LogLevel::Debug, category)
+#define LOG_INFO(category) LOG(LogLevel::Info, category)
+#define LOG_WARNING(category) LOG(LogLevel::Warning, category)
+#define LOG_ERROR(category) LOG(LogLevel::Error, category)
\ No newline at end of file
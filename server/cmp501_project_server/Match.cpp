@@ -0,0 +1,966 @@
+#include <algorithm>
+#include <stdlib.h>
+#include <string>
+#include "Match.h"
+#include "Logger.h"
+
+struct Ball::Contact CheckPaddleCollision(Ball const& ball, Paddle const& paddle)
+{
+	float ballLeft = ball.position.x;
+	float ballRight = ball.position.x + BALL_WIDTH;
+	float ballTop = ball.position.y;
+	float ballBottom = ball.position.y + BALL_HEIGHT;
+
+	float paddleLeft = paddle.position.x;
+	float paddleRight = paddle.position.x + PADDLE_WIDTH;
+	float paddleTop = paddle.position.y;
+	float paddleBottom = paddle.position.y + PADDLE_HEIGHT;
+
+	Ball::Contact contact{};
+
+	if (ballLeft >= paddleRight)
+	{
+		return contact;
+	}
+
+	if (ballRight <= paddleLeft)
+	{
+		return contact;
+	}
+
+	if (ballTop >= paddleBottom)
+	{
+		return contact;
+	}
+
+	if (ballBottom <= paddleTop)
+	{
+		return contact;
+	}
+
+	float paddleRangeUpper = paddleBottom - (2.0f * PADDLE_HEIGHT / 3.0f);
+	float paddleRangeMiddle = paddleBottom - (PADDLE_HEIGHT / 3.0f);
+
+	if (ball.velocity.x < 0)
+	{
+		// Left paddle
+		contact.penetration = paddleRight - ballLeft;
+	}
+	else if (ball.velocity.x > 0)
+	{
+		// Right paddle
+		contact.penetration = paddleLeft - ballRight;
+	}
+
+	if ((ballBottom > paddleTop)
+		&& (ballBottom < paddleRangeUpper))
+	{
+		contact.type = Ball::CollisionType::Top;
+	}
+	else if ((ballBottom > paddleRangeUpper)
+		&& (ballBottom < paddleRangeMiddle))
+	{
+		contact.type = Ball::CollisionType::Middle;
+	}
+	else
+	{
+		contact.type = Ball::CollisionType::Bottom;
+	}
+
+	return contact;
+}
+
+Match::Match(int id, uint64_t globalTime)
+	: id(id),
+	ball(
+		Vec2((WINDOW_WIDTH / 2.0f) - (BALL_WIDTH / 2.0f), (WINDOW_HEIGHT / 2.0f) - (BALL_WIDTH / 2.0f)),
+		Vec2(BALL_SPEED, 0.0f)
+	),
+	paddleOne(
+		Vec2(50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f)),
+		Vec2(0.0f, 0.0f)
+	),
+	paddleTwo(
+		Vec2(WINDOW_WIDTH - 50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f)),
+		Vec2(0.0f, 0.0f)
+	),
+	globalTime(globalTime)
+{
+}
+
+bool Match::IsWaitingForPlayers() const
+{
+	return state == State::Lobby && clients.size() < 2;
+}
+
+bool Match::IsReadyToStart() const
+{
+	return state == State::Lobby && playersReady == 2;
+}
+
+// Add a newly accepted client to the match and assign it the free paddle. The paddle is sent to it by SendAssignment
+// once the client has a session ID
+Client& Match::AddClient(std::unique_ptr<ReactorTcpSocket> tcpSocket)
+{
+	int assignedPaddle = 1;
+	for (const Client& c : clients)
+	{
+		if (c.paddle == 1)
+		{
+			assignedPaddle = 2;
+		}
+	}
+
+	Client newClient;
+	newClient.match = this;
+	newClient.port = (*tcpSocket).getRemotePort();
+	newClient.paddle = assignedPaddle;
+	newClient.tcpSocket = std::move(tcpSocket);
+	clients.push_back(std::move(newClient));
+
+	return clients.back();
+}
+
+// Send a client its paddle number and the session ID it is to put in its datagrams
+void Match::SendAssignment(const Client& client)
+{
+	LOG_INFO(LogCategory::Match) << "Match " << id << ": sending paddle assignment " << client.paddle
+		<< " and session ID " << client.sessionId << " to " << (*client.tcpSocket).getRemoteAddress().toString() << " at " << "port " << client.port;
+
+	sf::Packet packet;
+	packet << client.paddle << static_cast<sf::Uint64>(client.sessionId);
+	if ((*client.tcpSocket).send(packet) != sf::Socket::Done)
+	{
+		LOG_ERROR(LogCategory::Network) << "tcp socket send error";
+	}
+}
+
+// Receive everything pending on a client's tcp socket, which after the paddle assignment only ever means its
+// disconnection. The socket is edge-triggered so it is read until it would block.
+// If the client is removed from the match its session ID is added to departedSessions
+void Match::ReceiveTcp(Client& client, Reactor& reactor, std::vector<uint64_t>& departedSessions)
+{
+	sf::Packet packet;
+	sf::Socket::Status status;
+
+	while ((status = (*client.tcpSocket).receive(packet)) == sf::Socket::Done)
+	{
+		packet.clear();
+	}
+
+	if (status != sf::Socket::Disconnected)
+	{
+		return;
+	}
+
+	LOG_INFO(LogCategory::Match) << "Match " << id << ": client disconnected: " << (*client.tcpSocket).getRemoteAddress().toString() << " at " << "port " << client.port;
+
+	reactor.Remove(*client.tcpSocket);
+
+	// A finished match is only waiting for its last control messages to be acknowledged, which this client never will
+	if (state == State::Finished)
+	{
+		client.ready = false;
+		return;
+	}
+
+	if (state == State::Lobby)
+	{
+		// If client previously confirmed ready, then decrease count of ready players
+		if (client.ready)
+		{
+			playersReady--;
+		}
+
+		// Erase client from the match so that its paddle can be assigned to a new client. Erasing it closes its socket
+		departedSessions.push_back(client.sessionId);
+
+		std::list<Client>::iterator it;
+		for (it = clients.begin(); it != clients.end(); ++it)
+		{
+			if (&(*it) == &client)
+			{
+				clients.erase(it);
+				break;
+			}
+		}
+
+		return;
+	}
+
+	// Set client to non-ready so its opponent is notified, and end the match
+	client.ready = false;
+	clientDisconnected = true;
+	SendOpponentDisconnected();
+}
+
+// Take the first hello of a client in the lobby as its readiness to play. Its udp socket is where the hello came from,
+// which the server's ClientTable has already bound to its session
+void Match::ReceiveHello(Client& client)
+{
+	if (state != State::Lobby || client.ready)
+	{
+		return;
+	}
+
+	LOG_INFO(LogCategory::Match) << "Match " << id << ": client " << (*client.tcpSocket).getRemoteAddress().toString() << " at " << "port " << client.port
+		<< " said hello from " << client.udpAddress.toString() << " at " << "port " << client.udpPort;
+
+	client.heartbeat.Heard(static_cast<double>(MonotonicMilliseconds() - globalTime));
+	client.ready = true;
+	playersReady++;
+}
+
+// Send game started message to both clients
+void Match::Start()
+{
+	sf::Packet packet;
+
+	for (Client& c : clients)
+	{
+		LOG_INFO(LogCategory::Match) << "Match " << id << ": sending game started message to: "
+			<< (*c.tcpSocket).getRemoteAddress().toString() << " at " << "port " << c.port;
+
+		packet.clear();
+		packet << "game started";
+		if ((*c.tcpSocket).send(packet) != sf::Socket::Done)
+		{
+			LOG_ERROR(LogCategory::Network) << "tcp socket send error";
+		}
+	}
+
+	// Liveness is counted from the start, and round trips and send rates are measured afresh for the match
+	double now = static_cast<double>(MonotonicMilliseconds() - globalTime);
+	for (Client& c : clients)
+	{
+		c.heartbeat.Reset(now);
+		c.sendRate.Reset(tickRate, clientBudget, now);
+	}
+
+	ServeExtraBalls();
+
+	// The lockstep simulation starts from the same state as the ball and paddles
+	lockstepState = StartLockstep();
+
+	// The snapshot of tick 1 is the starting state of the match
+	tick = 1;
+	lastSnapshotTick = 0;
+	snapshots.Store(TakeSnapshot());
+
+	state = State::Playing;
+}
+
+// Spread the extra balls of a multi-ball match down the middle of the field, heading both ways at a few angles
+void Match::ServeExtraBalls()
+{
+	extraBalls.Clear();
+
+	int count = std::min(std::max(extraBallCount, 0), MAX_BALLS - 1);
+	for (int i = 0; i < count; i++)
+	{
+		float y = (i + 0.5f) * (WINDOW_HEIGHT - BALL_HEIGHT) / count;
+		float velocityY = 0.75f * BALL_SPEED * ((i % 5) - 2) / 2.0f;
+		extraBalls.Add(Vec2(WINDOW_WIDTH / 2.0f, y), Vec2((i % 2 == 0) ? BALL_SPEED : -BALL_SPEED, velocityY));
+	}
+}
+
+// Queue the input commands of a client's input message to be applied to its paddle, and take the message's
+// tick as the client's acknowledgement of that snapshot. Commands are resent until acknowledged, so any
+// that are not newer than the newest already received are duplicates and are dropped
+void Match::ReceiveInputs(Client& sender, const InputCommand* commands, int count, uint16_t ackTick, bool verbose)
+{
+	sender.heartbeat.Heard(static_cast<double>(MonotonicMilliseconds() - globalTime));
+
+	// Tick 0 means no snapshot has been applied yet. Otherwise expand the 16-bit tick to the most recent
+	// tick of this match that ends in those bits. A tick older than the snapshot history, from before the match
+	// started or not yet sent cannot have been seen, so the message is taken as acknowledging nothing rather than
+	// letting a corrupt or forged tick into the deltas, the lockstep updates and the rewound collision checks
+	uint32_t seenTick = 0;
+	if (ackTick != 0)
+	{
+		uint16_t age = static_cast<uint16_t>(static_cast<uint16_t>(tick) - ackTick);
+		if (age < SNAPSHOT_HISTORY_SIZE && age < tick && tick - age <= lastSnapshotTick)
+		{
+			seenTick = tick - age;
+		}
+		else
+		{
+			invalidAcks++;
+		}
+
+		if (seenTick != 0 && (!sender.snapshotAcked || seenTick > sender.ackedTick))
+		{
+			sender.snapshotAcked = true;
+			sender.ackedTick = seenTick;
+		}
+	}
+
+	int queued = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (!SequenceGreaterThan(commands[i].sequence, sender.newestInput))
+		{
+			staleInputs++;
+			continue;
+		}
+
+		QueuedInput input;
+		input.command = commands[i];
+		input.seenTick = seenTick;
+		sender.inputs.push_back(input);
+		sender.newestInput = commands[i].sequence;
+		queued++;
+	}
+
+	while (sender.inputs.size() > MAX_QUEUED_INPUTS)
+	{
+		sender.inputs.pop_front();
+	}
+
+	if (verbose)
+	{
+		LOG_DEBUG(LogCategory::Input) << "Match " << id << ": received " << count << " input commands from paddle " << sender.paddle
+			<< ": Newest=" << sender.newestInput << "; Queued=" << queued << "; Backlog=" << sender.inputs.size()
+			<< "; Duplicates so far=" << staleInputs << "; Invalid acknowledgements so far=" << invalidAcks;
+	}
+}
+
+// Move a client's paddle by its next queued input command. If commands have built up beyond
+// MAX_INPUT_BACKLOG the extra ones are applied too, so the server does not fall behind the client
+// Each position is recorded at the tick its client had seen, for lag compensated collisions
+void Match::ApplyInputs(Client& client, bool verbose)
+{
+	Paddle& paddle = (client.paddle == 1) ? paddleOne : paddleTwo;
+
+	int count = client.inputs.empty() ? 0 : 1;
+	if (static_cast<int>(client.inputs.size()) > MAX_INPUT_BACKLOG)
+	{
+		count = client.inputs.size() - MAX_INPUT_BACKLOG;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		QueuedInput& input = client.inputs.front();
+
+		paddle.Move(input.command.input, INPUT_DT);
+		client.appliedInput = input.command.sequence;
+
+		if (input.seenTick != 0)
+		{
+			RecordPaddlePosition(client.paddle, input.seenTick, paddle.position.y);
+			client.rewindPending = true;
+			client.rewindTick = input.seenTick;
+		}
+
+		client.inputs.pop_front();
+	}
+
+	if (verbose && count > 0)
+	{
+		LOG_DEBUG(LogCategory::Input) << "Match " << id << ": applied " << count << " input commands to paddle " << client.paddle
+			<< ": Applied=" << client.appliedInput << "; y=" << paddle.position.y;
+	}
+}
+
+// The next queued input command of a client, for one lockstep tick. Every tick of the lockstep simulation takes
+// exactly one input from each paddle, so rather than catching up as ApplyInputs does, commands built up beyond
+// MAX_INPUT_BACKLOG are dropped, and the client's reconciliation puts its paddle back where the server has it
+PaddleInput Match::TakeLockstepInput(Client& client, bool verbose)
+{
+	if (client.inputs.empty())
+	{
+		return PaddleInput::None;
+	}
+
+	int dropped = 0;
+	while (static_cast<int>(client.inputs.size()) > MAX_INPUT_BACKLOG)
+	{
+		client.inputs.pop_front();
+		dropped++;
+	}
+
+	PaddleInput input = client.inputs.front().command.input;
+	client.appliedInput = client.inputs.front().command.sequence;
+	client.inputs.pop_front();
+
+	if (verbose)
+	{
+		LOG_DEBUG(LogCategory::Input) << "Match " << id << ": took input command " << client.appliedInput << " for paddle " << client.paddle
+			<< " at lockstep tick " << tick + 1 << ": Dropped=" << dropped;
+	}
+
+	return input;
+}
+
+// Advance a lockstep match by one tick of its simulation, remember the inputs it took to send them to the clients,
+// and mirror the result into the ball and paddles. Collisions need no rewinding, as every client sees the same match
+void Match::TickLockstep(float dt, bool verbose)
+{
+	PaddleInput inputs[2] = { PaddleInput::None, PaddleInput::None };
+	for (Client& c : clients)
+	{
+		inputs[c.paddle - 1] = TakeLockstepInput(c, verbose);
+	}
+
+	BallMove move = StepLockstep(lockstepState, inputs[0], inputs[1]);
+	lockstepInputs[lockstepState.tick % LOCKSTEP_HISTORY_SIZE][0] = inputs[0];
+	lockstepInputs[lockstepState.tick % LOCKSTEP_HISTORY_SIZE][1] = inputs[1];
+
+	ball.position = ToVec2(lockstepState.ballPosition);
+	ball.velocity = ToVec2(lockstepState.ballVelocity);
+	paddleOne.position.y = static_cast<float>(lockstepState.paddleOneY);
+	paddleTwo.position.y = static_cast<float>(lockstepState.paddleTwoY);
+
+	if (move.paddle != 0)
+	{
+		if (logEvents)
+		{
+			LOG_INFO(LogCategory::Match) << "Match " << id << ": paddle " << (move.paddle == 1 ? "one" : "two") << " collision detected";
+		}
+
+		lastPaddleHitTick = tick + 1;
+	}
+
+	if (move.goal != BallEdge::None)
+	{
+		lastScoreTick = tick + 1;
+		playerOneScore = lockstepState.playerOneScore;
+		playerTwoScore = lockstepState.playerTwoScore;
+		scoresChanged = true;
+
+		if (logEvents)
+		{
+			LOG_INFO(LogCategory::Match) << "Match " << id << ": " << (move.goal == BallEdge::Left ? "left" : "right") << " wall collision detected";
+		}
+	}
+
+	if (extraBalls.Size() > 0)
+	{
+		extraBalls.Step(dt, paddleOne.position, paddleTwo.position);
+	}
+
+	++tick;
+	snapshots.Store(TakeSnapshot());
+}
+
+// Advance the match by one simulation tick of dt milliseconds and record the resulting snapshot
+// A lockstep match always simulates LOCKSTEP_DT milliseconds a tick, and is ticked at INPUT_RATE
+void Match::Tick(float dt, bool verbose)
+{
+	if (lockstep)
+	{
+		TickLockstep(dt, verbose);
+		return;
+	}
+
+	Ball::Contact contact{};
+	int rewoundPaddle = 0;
+
+	// Move each paddle as its client's input commands say
+	for (Client& c : clients)
+	{
+		ApplyInputs(c, verbose);
+	}
+
+	// Sweep the ball along its path for the whole tick, so it bounces off a paddle however far it moves in a tick
+	BallMove move = ball.Move(dt, paddleOne.position, paddleTwo.position);
+
+	if (move.paddle != 0)
+	{
+		if (logEvents)
+		{
+			LOG_INFO(LogCategory::Match) << "Match " << id << ": paddle " << (move.paddle == 1 ? "one" : "two") << " collision detected";
+		}
+
+		lastPaddleHitTick = tick + 1;
+	}
+	else if (contact = CheckRewoundPaddleCollisions(rewoundPaddle); contact.type != Ball::CollisionType::None)
+	{
+		rewoundHits++;
+
+		if (logEvents)
+		{
+			LOG_INFO(LogCategory::Match) << "Match " << id << ": paddle " << (rewoundPaddle == 1 ? "one" : "two") << " collision detected at rewound tick";
+		}
+
+		lastPaddleHitTick = tick + 1;
+		ball.CollideWithPaddle(contact);
+		move.goal = BallEdge::None;
+	}
+
+	if (move.goal != BallEdge::None)
+	{
+		ball.Serve(move.goal);
+		lastScoreTick = tick + 1;
+
+		if (move.goal == BallEdge::Left)
+		{
+			++playerTwoScore;
+			scoresChanged = true;
+
+			if (logEvents)
+			{
+				LOG_INFO(LogCategory::Match) << "Match " << id << ": left wall collision detected";
+			}
+		}
+		else
+		{
+			++playerOneScore;
+			scoresChanged = true;
+
+			if (logEvents)
+			{
+				LOG_INFO(LogCategory::Match) << "Match " << id << ": right wall collision detected";
+			}
+		}
+	}
+
+	if (extraBalls.Size() > 0)
+	{
+		extraBalls.Step(dt, paddleOne.position, paddleTwo.position);
+	}
+
+	// Keep the state at the end of the tick as a snapshot to send and to use as a delta baseline
+	++tick;
+	snapshots.Store(TakeSnapshot());
+}
+
+// Record where a client put its paddle while seeing the snapshot of seenTick
+void Match::RecordPaddlePosition(int paddle, uint32_t seenTick, float y)
+{
+	PaddleHistory& history = (paddle == 1) ? paddleOneHistory : paddleTwoHistory;
+	history.Record(seenTick, y);
+}
+
+// Check a paddle against the ball as its client saw them at seenTick: the paddle where the client
+// put it in view of that tick's snapshot, and the ball from that snapshot. The ball must still be heading
+// for the paddle without having been returned or scored since, and seenTick must be within rewindTicks.
+// On a hit the penetration is measured against the ball now, so that it is pushed back out of the paddle
+Ball::Contact Match::CheckRewoundPaddleCollision(int paddle, uint32_t seenTick) const
+{
+	Ball::Contact contact{};
+	const Paddle& currentPaddle = (paddle == 1) ? paddleOne : paddleTwo;
+	const PaddleHistory& history = (paddle == 1) ? paddleOneHistory : paddleTwoHistory;
+
+	if (tick + 1 - seenTick > static_cast<uint32_t>(rewindTicks)
+		|| seenTick <= lastPaddleHitTick
+		|| seenTick <= lastScoreTick
+		|| (paddle == 1 && ball.velocity.x >= 0)
+		|| (paddle == 2 && ball.velocity.x <= 0))
+	{
+		return contact;
+	}
+
+	const WorldSnapshot* seen = snapshots.Find(static_cast<uint16_t>(seenTick));
+	float paddleY = 0.0f;
+	if (seen == NULL || !history.Find(seenTick, paddleY))
+	{
+		return contact;
+	}
+
+	Ball seenBall(Vec2((*seen).ballX, (*seen).ballY), ball.velocity);
+	Paddle seenPaddle(Vec2(currentPaddle.position.x, paddleY), Vec2(0.0f, 0.0f));
+
+	contact = CheckPaddleCollision(seenBall, seenPaddle);
+	if (contact.type != Ball::CollisionType::None)
+	{
+		if (paddle == 1)
+		{
+			contact.penetration = (currentPaddle.position.x + PADDLE_WIDTH) - ball.position.x;
+		}
+		else
+		{
+			contact.penetration = currentPaddle.position.x - (ball.position.x + BALL_WIDTH);
+		}
+	}
+
+	return contact;
+}
+
+// Check each paddle position that arrived since the last tick against the ball its client saw
+// Returns the first hit found, setting paddle to the number of the paddle that was hit
+Ball::Contact Match::CheckRewoundPaddleCollisions(int& paddle)
+{
+	Ball::Contact contact{};
+
+	for (Client& c : clients)
+	{
+		if (!c.rewindPending)
+		{
+			continue;
+		}
+
+		c.rewindPending = false;
+
+		if (contact.type == Ball::CollisionType::None)
+		{
+			contact = CheckRewoundPaddleCollision(c.paddle, c.rewindTick);
+			paddle = c.paddle;
+		}
+	}
+
+	return contact;
+}
+
+// Capture the state of the match as it is now
+WorldSnapshot Match::TakeSnapshot() const
+{
+	WorldSnapshot snapshot;
+	snapshot.tick = tick;
+	snapshot.time = static_cast<uint32_t>(MonotonicMilliseconds() - globalTime);
+	snapshot.ballX = ball.position.x;
+	snapshot.ballY = ball.position.y;
+	snapshot.ballVelocityX = ball.velocity.x;
+	snapshot.ballVelocityY = ball.velocity.y;
+	snapshot.paddleOneY = paddleOne.position.y;
+	snapshot.paddleTwoY = paddleTwo.position.y;
+	snapshot.playerOneScore = static_cast<uint8_t>(playerOneScore);
+	snapshot.playerTwoScore = static_cast<uint8_t>(playerTwoScore);
+
+	return snapshot;
+}
+
+// Queue the snapshot of the latest tick to be sent to both clients, each as a delta against
+// the newest snapshot that client has acknowledged. A client with no acknowledged snapshot still
+// in history gets a full snapshot. Each client is only sent as many snapshots as its send rate allows
+void Match::SendSnapshot(DatagramBatch& batch, bool verbose)
+{
+	const WorldSnapshot* current = snapshots.Find(static_cast<uint16_t>(tick));
+	if (current == NULL)
+	{
+		return;
+	}
+
+	int ticks = static_cast<int>(tick - lastSnapshotTick);
+	lastSnapshotTick = tick;
+
+	sf::Packet packet;
+	WorldSnapshot snapshot = *current;
+
+	for (Client& c : clients)
+	{
+		if (!c.sendRate.ShouldSend(ticks, tickRate))
+		{
+			continue;
+		}
+
+		packet.clear();
+		if (lockstep)
+		{
+			WriteLockstepUpdate(packet, c, verbose);
+		}
+		else
+		{
+			// Tell each client which of its input commands the paddle positions include, so it can replay the rest
+			snapshot.inputAck = c.appliedInput;
+
+			const WorldSnapshot* baseline = NULL;
+			if (c.snapshotAcked && tick - c.ackedTick < SNAPSHOT_HISTORY_SIZE)
+			{
+				baseline = snapshots.Find(static_cast<uint16_t>(c.ackedTick));
+			}
+
+			WriteSnapshot(packet, snapshot, baseline);
+
+			if (verbose)
+			{
+				LOG_DEBUG(LogCategory::Snapshot) << "Match " << id << ": sending snapshot to port " << c.udpPort << ": Tick=" << tick
+					<< "; Baseline=" << ((baseline != NULL) ? std::to_string((*baseline).tick) : std::string("none"))
+					<< "; Bytes=" << packet.getDataSize()
+					<< "; Ball=(" << (*current).ballX << "," << (*current).ballY << ")";
+			}
+		}
+
+		batch.Queue(packet, c.udpAddress, c.udpPort);
+		int bytes = static_cast<int>(packet.getDataSize());
+		int datagrams = 1;
+
+		// The extra balls of a multi-ball match follow, as many datagrams as they need
+		for (int first = 0; first < extraBalls.Size(); first += BALLS_PER_MESSAGE)
+		{
+			packet.clear();
+			WriteBalls(packet, tick, first, std::min(BALLS_PER_MESSAGE, extraBalls.Size() - first), extraBalls.Size(),
+				extraBalls.x.data(), extraBalls.y.data(), extraBalls.velocityX.data(), extraBalls.velocityY.data());
+			batch.Queue(packet, c.udpAddress, c.udpPort);
+			bytes += static_cast<int>(packet.getDataSize());
+			datagrams++;
+		}
+
+		c.sendRate.Sent(bytes, datagrams);
+	}
+}
+
+// Write what a client of a lockstep match needs to reach the latest tick: the inputs of both paddles for every
+// tick since the newest it has acknowledged, or the whole state if it has not acknowledged one, has fallen
+// further behind than the inputs kept, or a keyframe is due so that a client that went out of step recovers.
+// Keyframes are due by the client's last one rather than by the tick, as its send rate may skip any given tick
+void Match::WriteLockstepUpdate(sf::Packet& packet, Client& client, bool verbose) const
+{
+	uint32_t time = static_cast<uint32_t>(MonotonicMilliseconds() - globalTime);
+	uint32_t behind = tick - client.ackedTick;
+
+	if (!client.snapshotAcked || behind >= LOCKSTEP_HISTORY_SIZE || tick - client.keyframeTick >= LOCKSTEP_KEYFRAME_INTERVAL)
+	{
+		WriteLockstepState(packet, lockstepState, time, client.appliedInput);
+		client.keyframeTick = tick;
+
+		if (verbose)
+		{
+			LOG_DEBUG(LogCategory::Snapshot) << "Match " << id << ": sending lockstep state to port " << client.udpPort << ": Tick=" << tick
+				<< "; Acknowledged=" << (client.snapshotAcked ? std::to_string(client.ackedTick) : std::string("none"))
+				<< "; Bytes=" << packet.getDataSize();
+		}
+
+		return;
+	}
+
+	// A client that is up to date is sent the newest tick again, so it still hears of the acknowledged input
+	int count = std::max(static_cast<int>(behind), 1);
+	PaddleInput paddleOneInputs[LOCKSTEP_HISTORY_SIZE];
+	PaddleInput paddleTwoInputs[LOCKSTEP_HISTORY_SIZE];
+	for (int i = 0; i < count; i++)
+	{
+		int slot = (tick - count + 1 + i) % LOCKSTEP_HISTORY_SIZE;
+		paddleOneInputs[i] = lockstepInputs[slot][0];
+		paddleTwoInputs[i] = lockstepInputs[slot][1];
+	}
+
+	WriteLockstepInputs(packet, tick, time, client.appliedInput, LockstepChecksum(lockstepState), paddleOneInputs, paddleTwoInputs, count);
+
+	if (verbose)
+	{
+		LOG_DEBUG(LogCategory::Snapshot) << "Match " << id << ": sending lockstep inputs to port " << client.udpPort << ": Tick=" << tick
+			<< "; Ticks=" << count << "; Bytes=" << packet.getDataSize();
+	}
+}
+
+// If scores have changed since the last check, see whether either player has won. Clients are sent the scores in
+// every snapshot, so only the winner goes through the reliable channel
+void Match::CheckWinner()
+{
+	if (!scoresChanged)
+	{
+		return;
+	}
+
+	if (logEvents)
+	{
+		LOG_INFO(LogCategory::Match) << "Match " << id << ": scores now PlayerOne=" << playerOneScore << "; PlayerTwo=" << playerTwoScore;
+	}
+
+	scoresChanged = false;
+
+	if (playerOneScore >= winningScore || playerTwoScore >= winningScore) // If either player has reached the winning score, determine winner
+	{
+		if (std::abs(playerOneScore - playerTwoScore) >= 2) // Player needs to win by at least two points
+		{
+			if (playerOneScore > playerTwoScore)
+			{
+				winner = 1;
+			}
+			else
+			{
+				winner = 2;
+			}
+
+			SendWinner();
+		}
+	}
+}
+
+// End the match if a client has not been heard from, by any message or heartbeat echo, for livenessTimeout
+// milliseconds, set with --liveness-ms and 2 seconds by default
+void Match::CheckTimeouts()
+{
+	if (state != State::Playing)
+	{
+		return;
+	}
+
+	double now = static_cast<double>(MonotonicMilliseconds() - globalTime);
+	for (Client& c : clients)
+	{
+		if (c.ready && !c.heartbeat.IsAlive(now, livenessTimeout))
+		{
+			LOG_WARNING(LogCategory::Network) << "Match " << id << ": client not heard from for " << now - c.heartbeat.LastHeard() << " ms: "
+				<< (*c.tcpSocket).getRemoteAddress().toString() << " at " << "port " << c.port;
+
+			c.ready = false;
+			clientDisconnected = true;
+		}
+	}
+
+	if (clientDisconnected)
+	{
+		SendOpponentDisconnected();
+	}
+}
+
+// Queue a heartbeat for every client of a match being played that is due one
+void Match::SendHeartbeats(DatagramBatch& batch)
+{
+	double now = static_cast<double>(MonotonicMilliseconds() - globalTime);
+	sf::Packet packet;
+
+	for (Client& c : clients)
+	{
+		if (!c.ready || !c.heartbeat.ShouldSend(now))
+		{
+			continue;
+		}
+
+		packet.clear();
+		c.heartbeat.Write(packet, now);
+		batch.Queue(packet, c.udpAddress, c.udpPort);
+	}
+}
+
+// Let each client's send rate follow the losses and round trips of its heartbeats. In verbose mode the round trip
+// and send rate of each client are logged
+void Match::UpdateSendRates(bool verbose)
+{
+	double now = static_cast<double>(MonotonicMilliseconds() - globalTime);
+
+	for (Client& c : clients)
+	{
+		if (!c.ready)
+		{
+			continue;
+		}
+
+		c.sendRate.Update(c.heartbeat, now);
+
+		if (verbose)
+		{
+			const RoundTripEstimator& roundTrip = c.heartbeat.RoundTrip();
+			LOG_DEBUG(LogCategory::Network) << "Match " << id << ": paddle " << c.paddle << " round trip: Smoothed=" << roundTrip.Smoothed()
+				<< "; Variance=" << roundTrip.Variance() << "; Latest=" << roundTrip.Latest() << "; Lost=" << c.heartbeat.Losses()
+				<< "; SendRate=" << c.sendRate.Rate() << "/s; BudgetRate=" << c.sendRate.BudgetRate() << "/s; Backoffs=" << c.sendRate.Backoffs();
+		}
+	}
+}
+
+// Take the echo of a heartbeat as a round trip sample
+void Match::ReceiveHeartbeatEcho(Client& client, uint32_t sentTime)
+{
+	double now = static_cast<double>(MonotonicMilliseconds() - globalTime);
+	client.heartbeat.Heard(now);
+	client.heartbeat.ReceiveEcho(sentTime, now);
+}
+
+// Take an acknowledgement of control messages from a client
+void Match::ReceiveControlAck(Client& client, uint16_t sequence)
+{
+	double now = static_cast<double>(MonotonicMilliseconds() - globalTime);
+	client.heartbeat.Heard(now);
+	client.control.Acknowledge(sequence, now);
+}
+
+// Queue a control datagram for every connected client with control messages that are new or due to be resent.
+// They go to the client's udp socket with its snapshots
+void Match::SendControl(DatagramBatch& batch)
+{
+	double now = static_cast<double>(MonotonicMilliseconds() - globalTime);
+	sf::Packet packet;
+
+	for (Client& c : clients)
+	{
+		if (!c.ready || !c.control.ShouldSend(now))
+		{
+			continue;
+		}
+
+		packet.clear();
+		c.control.Write(packet, now);
+		batch.Queue(packet, c.udpAddress, c.udpPort);
+	}
+}
+
+// True if the match has finished, and its connected clients have acknowledged every control message or have had
+// CONTROL_LINGER_MILLISECONDS to
+bool Match::IsClosable() const
+{
+	if (state != State::Finished)
+	{
+		return false;
+	}
+
+	if (MonotonicMilliseconds() - finishTime >= CONTROL_LINGER_MILLISECONDS)
+	{
+		return true;
+	}
+
+	for (const Client& c : clients)
+	{
+		if (c.ready && !c.control.Idle())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Disconnect all clients of the match and free their sockets
+void Match::Close(Reactor& reactor)
+{
+	for (Client& c : clients)
+	{
+		reactor.Remove(*c.tcpSocket);
+		(*c.tcpSocket).disconnect();
+	}
+
+	clients.clear();
+}
+
+// Notify clients that are still connected that their opponent has gone, and end the match
+void Match::SendOpponentDisconnected()
+{
+	ControlMessage message;
+	message.opcode = ControlOpcode::OpponentDisconnected;
+
+	for (Client& c : clients)
+	{
+		// If current client is still connected, its opponent is the one that disconnected
+		if (c.ready)
+		{
+			LOG_INFO(LogCategory::Match) << "Match " << id << ": sending opponent disconnected message to: "
+				<< (*c.tcpSocket).getRemoteAddress().toString() << " at " << "port " << c.port;
+
+			c.control.Queue(message);
+		}
+	}
+
+	LOG_INFO(LogCategory::Match) << "Match " << id << ": ending the match due to client disconnection";
+
+	clientDisconnected = false;
+	Finish();
+}
+
+// Send number of winning paddle to clients, and end the match
+void Match::SendWinner()
+{
+	ControlMessage message;
+	message.opcode = ControlOpcode::Winner;
+	message.values[0] = static_cast<uint8_t>(winner);
+
+	for (Client& c : clients)
+	{
+		LOG_INFO(LogCategory::Match) << "Match " << id << ": sending winner to: "
+			<< (*c.tcpSocket).getRemoteAddress().toString() << " at " << "port " << c.port
+			<< "; Winner is player " << winner;
+
+		c.control.Queue(message);
+	}
+
+	LOG_INFO(LogCategory::Match) << "Match " << id << ": we have a winner. Ending the match";
+
+	Finish();
+}
+
+// Stop playing. The match is kept until its clients have acknowledged the control messages that ended it
+void Match::Finish()
+{
+	state = State::Finished;
+	finishTime = MonotonicMilliseconds();
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <deque>
+#include <list>
+#include <memory>
+#include <vector>
+#include "Global.h"
+#include "Vec2.h"
+#include "Ball.h"
+#include "BallSwarm.h"
+#include "Paddle.h"
+#include "Reactor.h"
+#include "DatagramBatch.h"
+#include "TickScheduler.h"
+#include "Protocol.h"
+#include "Lockstep.h"
+#include "ReliableChannel.h"
+#include "PaddleHistory.h"
+#include "Heartbeat.h"
+#include "SendRate.h"
+#include "MonotonicClock.h"
+
+class Match;
+
+const int MAX_INPUT_BACKLOG = 3; // queued input commands beyond this are applied in the same tick to catch up
+const int MAX_QUEUED_INPUTS = 2 * INPUT_RATE; // older commands are dropped beyond this
+const double CONTROL_LINGER_MILLISECONDS = 3000.0; // longest a finished match waits for its last control messages to be acknowledged
+
+// An input command waiting to be applied, with the tick of the snapshot its client had applied when sending it
+struct QueuedInput
+{
+	InputCommand command;
+	uint32_t seenTick = 0;
+};
+
+struct Client
+{
+	std::unique_ptr<ReactorTcpSocket> tcpSocket;
+	Match* match = NULL;
+	unsigned short port = 0; // remote port of tcp socket, kept because it reads 0 once disconnected
+	uint64_t sessionId = 0; // the client's entry in the server's ClientTable, sent back in every datagram it sends
+	int paddle = 0;
+	bool ready = false; // a hello has arrived, so the client's udp socket is known
+	sf::IpAddress udpAddress; // where the client's one udp socket is: where its latest hello came from (ClientTable::Bind)
+	unsigned short udpPort = 0;
+	bool snapshotAcked = false;
+	uint32_t ackedTick = 0; // newest snapshot the client has applied, used as the baseline of its deltas
+	uint32_t keyframeTick = 0; // tick of the last whole lockstep state sent to the client
+	bool rewindPending = false; // a paddle position arrived that has not been checked against the ball it was sent in view of
+	uint32_t rewindTick = 0; // tick of the snapshot the client saw when it sent that position
+	std::deque<QueuedInput> inputs; // received input commands not yet applied, oldest first
+	uint16_t newestInput = 0; // sequence number of the newest input command received
+	uint16_t appliedInput = 0; // sequence number of the newest input command applied to the paddle
+	ReliableSender control; // winner and opponent disconnected messages, resent over udp until acknowledged
+	Heartbeat heartbeat; // when the client was last heard from, and its round trip time
+	SendRateController sendRate; // how many snapshots a second the client's link can take
+};
+
+struct Ball::Contact CheckPaddleCollision(Ball const& ball, Paddle const& paddle);
+
+// A single game between two clients. Owns the ball, paddles, scores and clients of the game
+// so that any number of matches can be hosted side by side by the same server
+class Match
+{
+public:
+	enum class State
+	{
+		Lobby,
+		Playing,
+		Finished
+	};
+
+	Match(int id, uint64_t globalTime);
+
+	bool IsWaitingForPlayers() const;
+	bool IsReadyToStart() const;
+
+	Client& AddClient(std::unique_ptr<ReactorTcpSocket> tcpSocket);
+	void SendAssignment(const Client& client);
+	void ReceiveTcp(Client& client, Reactor& reactor, std::vector<uint64_t>& departedSessions);
+	void ReceiveHello(Client& client);
+	void ReceiveHeartbeatEcho(Client& client, uint32_t sentTime);
+	void Start();
+	void ReceiveInputs(Client& sender, const InputCommand* commands, int count, uint16_t ackTick, bool verbose);
+	void Tick(float dt, bool verbose);
+	void RecordPaddlePosition(int paddle, uint32_t seenTick, float y);
+	Ball::Contact CheckRewoundPaddleCollision(int paddle, uint32_t seenTick) const;
+	WorldSnapshot TakeSnapshot() const;
+	void SendSnapshot(DatagramBatch& batch, bool verbose);
+	void CheckWinner();
+	void SendHeartbeats(DatagramBatch& batch);
+	void UpdateSendRates(bool verbose);
+	void CheckTimeouts();
+	void ReceiveControlAck(Client& client, uint16_t sequence);
+	void SendControl(DatagramBatch& batch);
+	bool IsClosable() const;
+	void Close(Reactor& reactor);
+
+	int id;
+	State state = State::Lobby;
+	uint32_t tick = 0; // ticks simulated since the match started, starting from 1
+	int rewindTicks = DEFAULT_REWIND_MILLISECONDS * DEFAULT_TICK_RATE / 1000; // how far back a paddle collision can be decided, at most MAX_REWIND_TICKS
+	bool logEvents = true; // log collisions and scores as they happen
+	int extraBallCount = 0; // balls besides the one that scores, served when the match starts, at most MAX_BALLS - 1
+	bool lockstep = false; // clients are sent the inputs of both paddles and play the match out themselves (Lockstep.h)
+	double livenessTimeout = DEFAULT_LIVENESS_MILLISECONDS; // a playing client not heard from for this long has left the match
+	int tickRate = DEFAULT_TICK_RATE; // most snapshots a client is sent per second
+	double clientBudget = DEFAULT_CLIENT_BUDGET_KBPS * 1000.0 / 8.0; // bytes per second of snapshots each client may be sent
+
+	Ball ball;
+	BallSwarm extraBalls; // bounce around the field like the ball but never score
+	Paddle paddleOne;
+	Paddle paddleTwo;
+	std::list<Client> clients;
+
+	int playerOneScore = 0;
+	int playerTwoScore = 0;
+	int winner = 0;
+	int winningScore = 7;
+
+private:
+	void SendOpponentDisconnected();
+	void SendWinner();
+	void Finish();
+	void ServeExtraBalls();
+	Ball::Contact CheckRewoundPaddleCollisions(int& paddle);
+	void ApplyInputs(Client& client, bool verbose);
+	PaddleInput TakeLockstepInput(Client& client, bool verbose);
+	void TickLockstep(float dt, bool verbose);
+	void WriteLockstepUpdate(sf::Packet& packet, Client& client, bool verbose) const;
+
+	uint64_t globalTime;
+	int playersReady = 0;
+	bool scoresChanged = false;
+	bool clientDisconnected = false;
+	uint64_t finishTime = 0; // when the match finished, in milliseconds of MonotonicMilliseconds
+	uint32_t lastSnapshotTick = 0; // tick of the last call to SendSnapshot
+	SnapshotHistory snapshots;
+	PaddleHistory paddleOneHistory;
+	PaddleHistory paddleTwoHistory;
+	uint32_t lastPaddleHitTick = 0;
+	uint32_t lastScoreTick = 0;
+	uint64_t rewoundHits = 0; // paddle collisions only found by rewinding
+	uint64_t staleInputs = 0; // input commands dropped as duplicates or out of order
+	uint64_t invalidAcks = 0; // snapshot acknowledgements of ticks that cannot have been seen, ignored
+	LockstepState lockstepState; // the match as the lockstep simulation has it, mirrored into the ball and paddles
+	PaddleInput lockstepInputs[LOCKSTEP_HISTORY_SIZE][2] = {}; // inputs of both paddles by tick, resent until acknowledged
+};
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+// Milliseconds since an arbitrary starting point, from a clock that is never adjusted (CLOCK_MONOTONIC on Linux)
+// Used for the timestamps and timeouts of the server, which has no SDL to ask
+inline uint64_t MonotonicMilliseconds()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
\ No newline at end of file
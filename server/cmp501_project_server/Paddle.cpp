@@ -1,6 +1,6 @@
-#include <algorithm>
 #include "Paddle.h"
 #include "Global.h"
+#include "Protocol.h"
 
 Paddle::Paddle(Vec2 position, Vec2 velocity)
 	: position(position), velocity(velocity)
@@ -23,89 +23,21 @@ void Paddle::Update(float dt)
 	}
 }
 
-void Paddle::AddMessage(const Message& msg)
+// Set velocity from an input command and move for dt milliseconds
+void Paddle::Move(PaddleInput input, float dt)
 {
-	int numMessages = paddleMessages.size();
-	if (numMessages == maxMessages)
+	if (input == PaddleInput::Up)
 	{
-		std::move(paddleMessages.begin() + 1, paddleMessages.end(), paddleMessages.begin());
-		paddleMessages[numMessages - 1] = msg;
+		velocity.y = -PADDLE_SPEED;
 	}
-	else
-	{
-		paddleMessages.push_back(msg);
-	}
-
-	// sort messages in increasing order of timestamp
-	std::sort(paddleMessages.begin(), paddleMessages.end(), compareByTimestamp);
-}
-
-void Paddle::AddPrediction(const Message& prediction)
-{
-	int numPredictions = paddlePredictions.size();
-	if (numPredictions == maxMessages)
+	else if (input == PaddleInput::Down)
 	{
-		std::move(paddlePredictions.begin() + 1, paddlePredictions.end(), paddlePredictions.begin());
-		paddlePredictions[numPredictions - 1] = prediction;
+		velocity.y = PADDLE_SPEED;
 	}
 	else
 	{
-		paddlePredictions.push_back(prediction);
-	}
-
-	// sort messages in increasing order of timestamp
-	std::sort(paddlePredictions.begin(), paddlePredictions.end(), compareByTimestamp);
-}
-
-Message Paddle::RunPrediction(double gameTime, bool fromPredictions) {
-
-	float predictedY = (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f);
-	float speedY, displacementY;
-	Message prediction;
-	prediction.timestamp = gameTime;
-	prediction.y = predictedY;
-	prediction.x = 0;
-	prediction.ball = false;
-	prediction.port = 0;
-
-	int size = paddleMessages.size();
-	if (size < 2)
-	{
-		return prediction;
-	}
-
-	const Message& msg0 = paddleMessages[size - 1];
-	const Message& msg1 = paddleMessages[size - 2];
-
-	if (fromPredictions)
-	{
-		size = paddlePredictions.size();
-		if (size < 2)
-		{
-			return prediction;
-		}
-		
-		const Message& msg0 = paddlePredictions[size - 1];
-		const Message& msg1 = paddlePredictions[size - 2];
-	}
-
-	/* Linear model */
-	speedY = (msg0.y - msg1.y) / (msg0.timestamp - msg1.timestamp);
-	displacementY = speedY * (gameTime - msg0.timestamp);
-	predictedY = msg0.y + displacementY;
-
-	if (predictedY < 0)
-	{
-		// Restrict to top of the screen
-		predictedY = 0;
-	}
-	else if (predictedY > (WINDOW_HEIGHT - PADDLE_HEIGHT))
-	{
-		// Restrict to bottom of the screen
-		predictedY = WINDOW_HEIGHT - PADDLE_HEIGHT;
+		velocity.y = 0.0f;
 	}
 
-	prediction.y = predictedY;
-	
-	return prediction;
+	Update(dt);
 }
\ No newline at end of file
@@ -1,10 +1,9 @@
 #pragma once
-#include <vector>
+#include <cstdint>
 #include "Global.h"
 #include "Vec2.h"
 
-const int PADDLE_WIDTH = 15;
-const int PADDLE_HEIGHT = 90;
+enum class PaddleInput : uint8_t;
 
 class Paddle
 {
@@ -12,13 +11,8 @@ public:
 	Paddle(Vec2 position, Vec2 velocity);
 
 	void Update(float dt);
-	void AddMessage(const Message& msg);
-	void AddPrediction(const Message& prediction);
-	Message RunPrediction(double gameTime, bool fromPredictions);
+	void Move(PaddleInput input, float dt);
 
 	Vec2 position;
 	Vec2 velocity;
-	std::vector<Message> paddleMessages;
-	std::vector<Message> paddlePredictions;
-	int maxMessages = 2;
 };
\ No newline at end of file
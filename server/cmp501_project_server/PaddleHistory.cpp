@@ -0,0 +1,30 @@
+#include "PaddleHistory.h"
+
+void PaddleHistory::Record(uint32_t tick, float y)
+{
+	int slot = tick % MAX_REWIND_TICKS;
+	ticks[slot] = tick;
+	positions[slot] = y;
+	valid[slot] = true;
+}
+
+// Get the position recorded at a tick, if it has not been overwritten since
+bool PaddleHistory::Find(uint32_t tick, float& y) const
+{
+	int slot = tick % MAX_REWIND_TICKS;
+	if (!valid[slot] || ticks[slot] != tick)
+	{
+		return false;
+	}
+
+	y = positions[slot];
+	return true;
+}
+
+void PaddleHistory::Clear()
+{
+	for (int i = 0; i < MAX_REWIND_TICKS; i++)
+	{
+		valid[i] = false;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+const int MAX_REWIND_TICKS = 64; // largest rewind window, limited by the snapshot history the ball is rewound from
+const int DEFAULT_REWIND_MILLISECONDS = 200;
+
+// Authoritative positions of a paddle indexed by tick, so collisions can be checked as a client saw them
+// A position is recorded at the tick of the newest snapshot its client had applied when it sent it
+// Slots are indexed by tick, so a position is overwritten MAX_REWIND_TICKS ticks later
+class PaddleHistory
+{
+public:
+	void Record(uint32_t tick, float y);
+	bool Find(uint32_t tick, float& y) const;
+	void Clear();
+
+private:
+	uint32_t ticks[MAX_REWIND_TICKS] = {};
+	float positions[MAX_REWIND_TICKS] = {};
+	bool valid[MAX_REWIND_TICKS] = {};
+};
\ No newline at end of file
@@ -0,0 +1,939 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <cmath>
+#include <cstdint>
+#include "Fixed.h"
+
+/* Binary wire protocol for udp messages
+*
+*	Every datagram starts with a one byte header holding the protocol version in the high
+*	four bits and the message type in the low four bits. Ticks are sent as their low 16 bits.
+*	Positions are sent as signed 16-bit fixed-point values with POSITION_SCALE steps per pixel,
+*	which covers -2048 to 2047 pixels, more than enough for the 1280x720 field. Velocities are
+*	sent the same way with VELOCITY_SCALE steps per pixel per millisecond. All fields are
+*	big-endian (sf::Packet network order)
+*
+*	Each side sends and receives every message on one udp socket. Messages a client sends for its match follow
+*	the header with the 64-bit session ID the server gave it over tcp when it joined, which is how the server tells
+*	which client they are from. Its high 32 bits are random, so it cannot be guessed, and the server only takes
+*	datagrams carrying it from the address and port its client's hello came from. Clients treat the session ID as opaque
+*
+*	Hello: header, session ID, sent by a client that has joined until a welcome arrives. Tells the server where the
+*	client's udp socket is and that it is ready to play. Welcome: header, session ID, the server's reply to each hello
+*	Input commands: header, session ID, acknowledged snapshot tick, sequence number of the newest command,
+*	command count, then the commands newest first, packed four to a byte
+*	World snapshot: header, tick, server time, baseline tick, sequence number of the recipient's
+*	newest applied input command, field mask, then only the fields set in the mask
+*	Paddle position: header, 16-bit sequence number, tick, x, y
+*	Clock request: header, session ID, client time. Clock response: header, the client time of the request,
+*	server time the request was received, server time the response was sent
+*	Balls: header, tick, index of the first ball in the message, extra balls in the match, ball count,
+*	then the x, y and velocity of each ball. A match with more than fit in one datagram sends several
+*	Lockstep state: header, tick, server time, sequence number of the recipient's newest applied input
+*	command, then the ball position and velocity and the paddles as raw 32-bit fixed-point values, and the scores
+*	Lockstep inputs: header, newest tick, server time, sequence number of the recipient's newest applied input
+*	command, checksum of the state after the newest tick, tick count, then the inputs of both paddles for
+*	each tick, newest first, packed two ticks to a byte
+*	Control: header, sequence number of the first message, message count, then the opcode of each message
+*	followed by its values, one byte each. Control ack: header, session ID, sequence number of the newest
+*	control message received in order
+*	Heartbeat: header, server time it was sent. Heartbeat echo: header, session ID, the server time of the heartbeat
+*
+*	Server times are milliseconds since the server started. Snapshots only carry the low 16 bits
+*	of theirs, which a client with a synchronized clock can unwrap (see ClockSync.h in the client)
+*
+*	Sequence numbers and ticks wrap around, so they must only be compared with
+*	SequenceGreaterThan, never with < or >
+*/
+
+const uint8_t PROTOCOL_VERSION = 14;
+const float POSITION_SCALE = 16.0f; // fixed-point steps per pixel (1/16 pixel precision)
+const float VELOCITY_SCALE = 4096.0f; // fixed-point steps per pixel per millisecond, up to 8 pixels per millisecond
+
+enum class MessageType : uint8_t
+{
+	Invalid = 0,
+	PaddlePosition = 1, // a single position update. No longer sent, kept as the size baseline of --bench-protocol
+	Snapshot = 2, // server -> client, once per tick
+	InputCommands = 3, // client -> server, once per input tick
+	ClockRequest = 4, // client -> server once welcomed, a few times a second while synchronizing and every few seconds after
+	ClockResponse = 5, // server -> client, straight away to each request from the endpoint of a live session
+	Balls = 6, // server -> client, once per tick alongside the snapshot in a multi-ball match
+	LockstepState = 7, // server -> client, in place of lockstep inputs when the client needs to catch up, and every few seconds
+	LockstepInputs = 8, // server -> client, once per tick in a lockstep match instead of the snapshot
+	Control = 9, // server -> client, every control message not yet acknowledged, when one is queued or due to be resent
+	ControlAck = 10, // client -> server, whenever control messages arrive
+	Hello = 11, // client -> server, every HELLO_INTERVAL once joined, until a welcome arrives
+	Welcome = 12, // server -> client, straight away to each hello from a client of a live session
+	Heartbeat = 13, // server -> client, every HEARTBEAT_INTERVAL while the client's match is being played
+	HeartbeatEcho = 14 // client -> server, straight away to each heartbeat
+};
+
+struct PositionMessage
+{
+	uint8_t version = PROTOCOL_VERSION;
+	MessageType type = MessageType::Invalid;
+	uint16_t sequence = 0;
+	uint16_t tick = 0;
+	float x = 0.0f;
+	float y = 0.0f;
+};
+
+const std::size_t POSITION_MESSAGE_SIZE = 9; // bytes on the wire
+
+// True if sequence number a is newer than b, allowing for wrap around
+inline bool SequenceGreaterThan(uint16_t a, uint16_t b)
+{
+	return ((a > b) && (a - b <= 32768)) || ((a < b) && (b - a > 32768));
+}
+
+inline int16_t QuantizePosition(float position)
+{
+	float scaled = std::round(position * POSITION_SCALE);
+	if (scaled > INT16_MAX)
+	{
+		return INT16_MAX;
+	}
+	else if (scaled < INT16_MIN)
+	{
+		return INT16_MIN;
+	}
+
+	return static_cast<int16_t>(scaled);
+}
+
+inline float DequantizePosition(int16_t quantized)
+{
+	return quantized / POSITION_SCALE;
+}
+
+inline int16_t QuantizeVelocity(float velocity)
+{
+	float scaled = std::round(velocity * VELOCITY_SCALE);
+	if (scaled > INT16_MAX)
+	{
+		return INT16_MAX;
+	}
+	else if (scaled < INT16_MIN)
+	{
+		return INT16_MIN;
+	}
+
+	return static_cast<int16_t>(scaled);
+}
+
+inline float DequantizeVelocity(int16_t quantized)
+{
+	return quantized / VELOCITY_SCALE;
+}
+
+inline sf::Packet& operator <<(sf::Packet& packet, const PositionMessage& message)
+{
+	sf::Uint8 header = static_cast<sf::Uint8>((message.version << 4) | (static_cast<uint8_t>(message.type) & 0x0F));
+
+	return packet << header
+		<< static_cast<sf::Uint16>(message.sequence)
+		<< static_cast<sf::Uint16>(message.tick)
+		<< static_cast<sf::Int16>(QuantizePosition(message.x))
+		<< static_cast<sf::Int16>(QuantizePosition(message.y));
+}
+
+// A message from a different protocol version, or one too short to read, comes back with type Invalid
+inline sf::Packet& operator >>(sf::Packet& packet, PositionMessage& message)
+{
+	sf::Uint8 header = 0;
+	sf::Uint16 sequence = 0;
+	sf::Uint16 tick = 0;
+	sf::Int16 x = 0;
+	sf::Int16 y = 0;
+
+	if (!(packet >> header >> sequence >> tick >> x >> y))
+	{
+		message.type = MessageType::Invalid;
+		return packet;
+	}
+
+	message.version = header >> 4;
+	message.type = (message.version == PROTOCOL_VERSION) ? static_cast<MessageType>(header & 0x0F) : MessageType::Invalid;
+	message.sequence = sequence;
+	message.tick = tick;
+	message.x = DequantizePosition(x);
+	message.y = DequantizePosition(y);
+
+	return packet;
+}
+
+// State of a match at the end of a tick. Paddles only move vertically so only their y is kept
+struct WorldSnapshot
+{
+	uint32_t tick = 0;
+	uint32_t time = 0; // server time the snapshot was taken, in milliseconds since the server started
+	uint16_t inputAck = 0; // newest input command of the recipient applied to its paddle, set per recipient
+	float ballX = 0.0f;
+	float ballY = 0.0f;
+	float ballVelocityX = 0.0f; // pixels per millisecond, so clients can follow the ball between snapshots
+	float ballVelocityY = 0.0f;
+	float paddleOneY = 0.0f;
+	float paddleTwoY = 0.0f;
+	uint8_t playerOneScore = 0;
+	uint8_t playerTwoScore = 0;
+};
+
+// Field mask bits of a snapshot message. A full snapshot has every field and no baseline
+const uint8_t SNAPSHOT_BALL_X = 1 << 0;
+const uint8_t SNAPSHOT_BALL_Y = 1 << 1;
+const uint8_t SNAPSHOT_PADDLE_ONE = 1 << 2;
+const uint8_t SNAPSHOT_PADDLE_TWO = 1 << 3;
+const uint8_t SNAPSHOT_SCORES = 1 << 4;
+const uint8_t SNAPSHOT_BALL_VELOCITY = 1 << 5;
+const uint8_t SNAPSHOT_FULL = 1 << 7;
+
+const int SNAPSHOT_HISTORY_SIZE = 64; // must divide 65536 so slots stay consistent when wire ticks wrap
+
+// The most recent snapshots, kept as baselines for delta compression
+// Slots are indexed by tick, so a snapshot is overwritten SNAPSHOT_HISTORY_SIZE ticks later
+class SnapshotHistory
+{
+public:
+	void Store(const WorldSnapshot& snapshot)
+	{
+		int slot = snapshot.tick % SNAPSHOT_HISTORY_SIZE;
+		snapshots[slot] = snapshot;
+		valid[slot] = true;
+	}
+
+	// Find the snapshot taken at a tick, matching on the 16 bits that are sent on the wire
+	const WorldSnapshot* Find(uint16_t tick) const
+	{
+		int slot = tick % SNAPSHOT_HISTORY_SIZE;
+		if (!valid[slot] || static_cast<uint16_t>(snapshots[slot].tick) != tick)
+		{
+			return NULL;
+		}
+
+		return &snapshots[slot];
+	}
+
+	void Clear()
+	{
+		for (int i = 0; i < SNAPSHOT_HISTORY_SIZE; i++)
+		{
+			valid[i] = false;
+		}
+	}
+
+private:
+	WorldSnapshot snapshots[SNAPSHOT_HISTORY_SIZE];
+	bool valid[SNAPSHOT_HISTORY_SIZE] = {};
+};
+
+// Write a snapshot containing only the fields that differ from baseline, or every field if baseline is NULL
+// Positions are compared once quantized, so a field is only sent if the client would see a different value
+inline void WriteSnapshot(sf::Packet& packet, const WorldSnapshot& snapshot, const WorldSnapshot* baseline)
+{
+	uint8_t mask = SNAPSHOT_FULL | SNAPSHOT_BALL_X | SNAPSHOT_BALL_Y | SNAPSHOT_PADDLE_ONE | SNAPSHOT_PADDLE_TWO | SNAPSHOT_SCORES
+		| SNAPSHOT_BALL_VELOCITY;
+	if (baseline != NULL)
+	{
+		mask = 0;
+		if (QuantizePosition(snapshot.ballX) != QuantizePosition((*baseline).ballX))
+		{
+			mask |= SNAPSHOT_BALL_X;
+		}
+		if (QuantizePosition(snapshot.ballY) != QuantizePosition((*baseline).ballY))
+		{
+			mask |= SNAPSHOT_BALL_Y;
+		}
+		if (QuantizePosition(snapshot.paddleOneY) != QuantizePosition((*baseline).paddleOneY))
+		{
+			mask |= SNAPSHOT_PADDLE_ONE;
+		}
+		if (QuantizePosition(snapshot.paddleTwoY) != QuantizePosition((*baseline).paddleTwoY))
+		{
+			mask |= SNAPSHOT_PADDLE_TWO;
+		}
+		if (snapshot.playerOneScore != (*baseline).playerOneScore || snapshot.playerTwoScore != (*baseline).playerTwoScore)
+		{
+			mask |= SNAPSHOT_SCORES;
+		}
+		if (QuantizeVelocity(snapshot.ballVelocityX) != QuantizeVelocity((*baseline).ballVelocityX)
+			|| QuantizeVelocity(snapshot.ballVelocityY) != QuantizeVelocity((*baseline).ballVelocityY))
+		{
+			mask |= SNAPSHOT_BALL_VELOCITY;
+		}
+	}
+
+	sf::Uint8 header = static_cast<sf::Uint8>((PROTOCOL_VERSION << 4) | static_cast<uint8_t>(MessageType::Snapshot));
+	sf::Uint16 baselineTick = (baseline != NULL) ? static_cast<sf::Uint16>((*baseline).tick) : 0;
+	packet << header << static_cast<sf::Uint16>(snapshot.tick) << static_cast<sf::Uint16>(snapshot.time) << baselineTick
+		<< static_cast<sf::Uint16>(snapshot.inputAck) << static_cast<sf::Uint8>(mask);
+
+	if (mask & SNAPSHOT_BALL_X)
+	{
+		packet << static_cast<sf::Int16>(QuantizePosition(snapshot.ballX));
+	}
+	if (mask & SNAPSHOT_BALL_Y)
+	{
+		packet << static_cast<sf::Int16>(QuantizePosition(snapshot.ballY));
+	}
+	if (mask & SNAPSHOT_PADDLE_ONE)
+	{
+		packet << static_cast<sf::Int16>(QuantizePosition(snapshot.paddleOneY));
+	}
+	if (mask & SNAPSHOT_PADDLE_TWO)
+	{
+		packet << static_cast<sf::Int16>(QuantizePosition(snapshot.paddleTwoY));
+	}
+	if (mask & SNAPSHOT_SCORES)
+	{
+		packet << static_cast<sf::Uint8>(snapshot.playerOneScore) << static_cast<sf::Uint8>(snapshot.playerTwoScore);
+	}
+	if (mask & SNAPSHOT_BALL_VELOCITY)
+	{
+		packet << static_cast<sf::Int16>(QuantizeVelocity(snapshot.ballVelocityX)) << static_cast<sf::Int16>(QuantizeVelocity(snapshot.ballVelocityY));
+	}
+}
+
+// Read a snapshot, filling the fields that were not sent from its baseline in history
+// Returns false, leaving snapshot untouched, if the message is not a snapshot of this protocol version,
+// is truncated, or its baseline is no longer in history. The result is complete, so it can be applied in one go
+inline bool ReadSnapshot(sf::Packet& packet, const SnapshotHistory& history, WorldSnapshot& snapshot)
+{
+	sf::Uint8 header = 0;
+	sf::Uint16 tick = 0;
+	sf::Uint16 time = 0;
+	sf::Uint16 baselineTick = 0;
+	sf::Uint16 inputAck = 0;
+	sf::Uint8 mask = 0;
+
+	if (!(packet >> header >> tick >> time >> baselineTick >> inputAck >> mask)
+		|| (header >> 4) != PROTOCOL_VERSION
+		|| (header & 0x0F) != static_cast<uint8_t>(MessageType::Snapshot))
+	{
+		return false;
+	}
+
+	WorldSnapshot result;
+	if (!(mask & SNAPSHOT_FULL))
+	{
+		const WorldSnapshot* baseline = history.Find(baselineTick);
+		if (baseline == NULL)
+		{
+			return false;
+		}
+
+		result = *baseline;
+	}
+
+	result.tick = tick;
+	result.time = time;
+	result.inputAck = inputAck;
+
+	sf::Int16 position = 0;
+	if ((mask & SNAPSHOT_BALL_X) && (packet >> position))
+	{
+		result.ballX = DequantizePosition(position);
+	}
+	if ((mask & SNAPSHOT_BALL_Y) && (packet >> position))
+	{
+		result.ballY = DequantizePosition(position);
+	}
+	if ((mask & SNAPSHOT_PADDLE_ONE) && (packet >> position))
+	{
+		result.paddleOneY = DequantizePosition(position);
+	}
+	if ((mask & SNAPSHOT_PADDLE_TWO) && (packet >> position))
+	{
+		result.paddleTwoY = DequantizePosition(position);
+	}
+
+	sf::Uint8 playerOneScore = 0;
+	sf::Uint8 playerTwoScore = 0;
+	if ((mask & SNAPSHOT_SCORES) && (packet >> playerOneScore >> playerTwoScore))
+	{
+		result.playerOneScore = playerOneScore;
+		result.playerTwoScore = playerTwoScore;
+	}
+
+	sf::Int16 velocityX = 0;
+	sf::Int16 velocityY = 0;
+	if ((mask & SNAPSHOT_BALL_VELOCITY) && (packet >> velocityX >> velocityY))
+	{
+		result.ballVelocityX = DequantizeVelocity(velocityX);
+		result.ballVelocityY = DequantizeVelocity(velocityY);
+	}
+
+	if (!packet)
+	{
+		return false;
+	}
+
+	snapshot = result;
+	return true;
+}
+
+// Paddle movement for one input tick. Each command moves the paddle for INPUT_DT milliseconds,
+// on the client when it is predicted and on the server when it is applied, so both end up in the same place
+enum class PaddleInput : uint8_t
+{
+	None = 0,
+	Up = 1,
+	Down = 2
+};
+
+const int INPUT_RATE = 60; // input commands per second
+const float INPUT_DT = 1000.0f / INPUT_RATE; // milliseconds of movement per command
+const int MAX_INPUTS_PER_MESSAGE = 32; // unacknowledged commands are resent, so one lost datagram loses nothing
+
+struct InputCommand
+{
+	uint16_t sequence = 0;
+	PaddleInput input = PaddleInput::None;
+};
+
+// Write up to MAX_INPUTS_PER_MESSAGE commands with consecutive sequence numbers, oldest first in commands
+inline void WriteInputs(sf::Packet& packet, uint64_t sessionId, uint16_t ackTick, const InputCommand* commands, int count)
+{
+	if (count > MAX_INPUTS_PER_MESSAGE)
+	{
+		commands += count - MAX_INPUTS_PER_MESSAGE;
+		count = MAX_INPUTS_PER_MESSAGE;
+	}
+
+	sf::Uint8 header = static_cast<sf::Uint8>((PROTOCOL_VERSION << 4) | static_cast<uint8_t>(MessageType::InputCommands));
+	sf::Uint16 newestSequence = (count > 0) ? commands[count - 1].sequence : 0;
+	packet << header << static_cast<sf::Uint64>(sessionId) << static_cast<sf::Uint16>(ackTick) << newestSequence << static_cast<sf::Uint8>(count);
+
+	sf::Uint8 packed = 0;
+	for (int i = 0; i < count; i++)
+	{
+		packed |= static_cast<uint8_t>(commands[count - 1 - i].input) << ((i % 4) * 2);
+		if (i % 4 == 3 || i == count - 1)
+		{
+			packet << packed;
+			packed = 0;
+		}
+	}
+}
+
+// Read the commands of an input message into commands, oldest first, returning false if the message
+// is not input commands of this protocol version or is truncated. commands must hold MAX_INPUTS_PER_MESSAGE
+inline bool ReadInputs(sf::Packet& packet, uint64_t& sessionId, uint16_t& ackTick, InputCommand* commands, int& count)
+{
+	sf::Uint8 header = 0;
+	sf::Uint64 session = 0;
+	sf::Uint16 tick = 0;
+	sf::Uint16 newestSequence = 0;
+	sf::Uint8 commandCount = 0;
+
+	if (!(packet >> header >> session >> tick >> newestSequence >> commandCount)
+		|| (header >> 4) != PROTOCOL_VERSION
+		|| (header & 0x0F) != static_cast<uint8_t>(MessageType::InputCommands)
+		|| commandCount > MAX_INPUTS_PER_MESSAGE)
+	{
+		return false;
+	}
+
+	sf::Uint8 packed = 0;
+	for (int i = 0; i < commandCount; i++)
+	{
+		if (i % 4 == 0 && !(packet >> packed))
+		{
+			return false;
+		}
+
+		InputCommand& command = commands[commandCount - 1 - i];
+		command.sequence = static_cast<uint16_t>(newestSequence - i);
+		command.input = static_cast<PaddleInput>((packed >> ((i % 4) * 2)) & 0x03);
+	}
+
+	sessionId = session;
+	ackTick = tick;
+	count = commandCount;
+	return true;
+}
+
+// Clock synchronization, NTP style: the client stamps a request with its own time, and the server
+// stamps the response with when it received the request and when it sent the response. From the
+// four times the client knows the round trip and how far its clock is from the server's
+struct ClockExchange
+{
+	uint32_t clientSendTime = 0;
+	uint32_t serverReceiveTime = 0;
+	uint32_t serverSendTime = 0;
+};
+
+inline void WriteClockRequest(sf::Packet& packet, uint64_t sessionId, uint32_t clientTime)
+{
+	sf::Uint8 header = static_cast<sf::Uint8>((PROTOCOL_VERSION << 4) | static_cast<uint8_t>(MessageType::ClockRequest));
+	packet << header << static_cast<sf::Uint64>(sessionId) << static_cast<sf::Uint32>(clientTime);
+}
+
+// Returns false if the message is not a clock request of this protocol version
+inline bool ReadClockRequest(sf::Packet& packet, uint64_t& sessionId, uint32_t& clientTime)
+{
+	sf::Uint8 header = 0;
+	sf::Uint64 session = 0;
+	sf::Uint32 time = 0;
+
+	if (!(packet >> header >> session >> time)
+		|| (header >> 4) != PROTOCOL_VERSION
+		|| (header & 0x0F) != static_cast<uint8_t>(MessageType::ClockRequest))
+	{
+		return false;
+	}
+
+	sessionId = session;
+	clientTime = time;
+	return true;
+}
+
+inline void WriteClockResponse(sf::Packet& packet, const ClockExchange& exchange)
+{
+	sf::Uint8 header = static_cast<sf::Uint8>((PROTOCOL_VERSION << 4) | static_cast<uint8_t>(MessageType::ClockResponse));
+	packet << header << static_cast<sf::Uint32>(exchange.clientSendTime) << static_cast<sf::Uint32>(exchange.serverReceiveTime)
+		<< static_cast<sf::Uint32>(exchange.serverSendTime);
+}
+
+// Returns false if the message is not a clock response of this protocol version or is truncated
+inline bool ReadClockResponse(sf::Packet& packet, ClockExchange& exchange)
+{
+	sf::Uint8 header = 0;
+	sf::Uint32 clientSendTime = 0;
+	sf::Uint32 serverReceiveTime = 0;
+	sf::Uint32 serverSendTime = 0;
+
+	if (!(packet >> header >> clientSendTime >> serverReceiveTime >> serverSendTime)
+		|| (header >> 4) != PROTOCOL_VERSION
+		|| (header & 0x0F) != static_cast<uint8_t>(MessageType::ClockResponse))
+	{
+		return false;
+	}
+
+	exchange.clientSendTime = clientSendTime;
+	exchange.serverReceiveTime = serverReceiveTime;
+	exchange.serverSendTime = serverSendTime;
+	return true;
+}
+
+// Extra balls of a multi-ball match, beyond the one in the snapshot. Kept as arrays like the server's BallSwarm
+const int BALLS_PER_MESSAGE = 180; // 8 bytes each, so a message fits in an unfragmented datagram
+
+struct BallsMessage
+{
+	uint16_t tick = 0;
+	uint16_t first = 0; // index among the extra balls of the first ball in the message
+	uint16_t total = 0; // extra balls in the match
+	int count = 0; // balls in the message, at most BALLS_PER_MESSAGE
+	float x[BALLS_PER_MESSAGE];
+	float y[BALLS_PER_MESSAGE];
+	float velocityX[BALLS_PER_MESSAGE];
+	float velocityY[BALLS_PER_MESSAGE];
+};
+
+// Write count balls starting at index first out of total, from arrays holding every extra ball
+inline void WriteBalls(sf::Packet& packet, uint32_t tick, int first, int count, int total,
+	const float* x, const float* y, const float* velocityX, const float* velocityY)
+{
+	sf::Uint8 header = static_cast<sf::Uint8>((PROTOCOL_VERSION << 4) | static_cast<uint8_t>(MessageType::Balls));
+	packet << header << static_cast<sf::Uint16>(tick) << static_cast<sf::Uint16>(first) << static_cast<sf::Uint16>(total)
+		<< static_cast<sf::Uint8>(count);
+
+	for (int i = first; i < first + count; i++)
+	{
+		packet << static_cast<sf::Int16>(QuantizePosition(x[i])) << static_cast<sf::Int16>(QuantizePosition(y[i]))
+			<< static_cast<sf::Int16>(QuantizeVelocity(velocityX[i])) << static_cast<sf::Int16>(QuantizeVelocity(velocityY[i]));
+	}
+}
+
+// Returns false if the message is not a balls message of this protocol version or is truncated
+inline bool ReadBalls(sf::Packet& packet, BallsMessage& message)
+{
+	sf::Uint8 header = 0;
+	sf::Uint16 tick = 0;
+	sf::Uint16 first = 0;
+	sf::Uint16 total = 0;
+	sf::Uint8 count = 0;
+
+	if (!(packet >> header >> tick >> first >> total >> count)
+		|| (header >> 4) != PROTOCOL_VERSION
+		|| (header & 0x0F) != static_cast<uint8_t>(MessageType::Balls)
+		|| count > BALLS_PER_MESSAGE
+		|| first + count > total)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		sf::Int16 x = 0;
+		sf::Int16 y = 0;
+		sf::Int16 velocityX = 0;
+		sf::Int16 velocityY = 0;
+		if (!(packet >> x >> y >> velocityX >> velocityY))
+		{
+			return false;
+		}
+
+		message.x[i] = DequantizePosition(x);
+		message.y[i] = DequantizePosition(y);
+		message.velocityX[i] = DequantizeVelocity(velocityX);
+		message.velocityY[i] = DequantizeVelocity(velocityY);
+	}
+
+	message.tick = tick;
+	message.first = first;
+	message.total = total;
+	message.count = count;
+	return true;
+}
+
+// State of a lockstep match at the end of a tick, in the fixed-point numbers it is simulated with (see Lockstep.h)
+struct LockstepState
+{
+	uint32_t tick = 0;
+	FixedVec2 ballPosition;
+	FixedVec2 ballVelocity; // pixels per millisecond
+	Fixed paddleOneY;
+	Fixed paddleTwoY;
+	uint8_t playerOneScore = 0;
+	uint8_t playerTwoScore = 0;
+};
+
+const int LOCKSTEP_HISTORY_SIZE = 64; // ticks of inputs the server can resend, must divide 65536 like SNAPSHOT_HISTORY_SIZE
+
+// The inputs of both paddles for count ticks up to tick, oldest first, as sent to one client
+struct LockstepInputsMessage
+{
+	uint16_t tick = 0; // newest tick in the message
+	uint16_t time = 0; // low 16 bits of the server time of the newest tick
+	uint16_t inputAck = 0; // newest input command of the recipient applied by the newest tick
+	uint16_t checksum = 0; // LockstepChecksum of the state after the newest tick
+	int count = 0; // at most LOCKSTEP_HISTORY_SIZE
+	PaddleInput paddleOne[LOCKSTEP_HISTORY_SIZE];
+	PaddleInput paddleTwo[LOCKSTEP_HISTORY_SIZE];
+};
+
+inline void WriteLockstepState(sf::Packet& packet, const LockstepState& state, uint32_t time, uint16_t inputAck)
+{
+	sf::Uint8 header = static_cast<sf::Uint8>((PROTOCOL_VERSION << 4) | static_cast<uint8_t>(MessageType::LockstepState));
+	packet << header << static_cast<sf::Uint16>(state.tick) << static_cast<sf::Uint16>(time) << static_cast<sf::Uint16>(inputAck)
+		<< static_cast<sf::Int32>(state.ballPosition.x.Raw()) << static_cast<sf::Int32>(state.ballPosition.y.Raw())
+		<< static_cast<sf::Int32>(state.ballVelocity.x.Raw()) << static_cast<sf::Int32>(state.ballVelocity.y.Raw())
+		<< static_cast<sf::Int32>(state.paddleOneY.Raw()) << static_cast<sf::Int32>(state.paddleTwoY.Raw())
+		<< static_cast<sf::Uint8>(state.playerOneScore) << static_cast<sf::Uint8>(state.playerTwoScore);
+}
+
+// Returns false if the message is not a lockstep state of this protocol version or is truncated. The tick of the
+// state read is the 16 bits sent on the wire
+inline bool ReadLockstepState(sf::Packet& packet, LockstepState& state, uint16_t& time, uint16_t& inputAck)
+{
+	sf::Uint8 header = 0;
+	sf::Uint16 tick = 0;
+	sf::Uint16 serverTime = 0;
+	sf::Uint16 ack = 0;
+	sf::Int32 values[6] = {};
+	sf::Uint8 playerOneScore = 0;
+	sf::Uint8 playerTwoScore = 0;
+
+	if (!(packet >> header >> tick >> serverTime >> ack)
+		|| (header >> 4) != PROTOCOL_VERSION
+		|| (header & 0x0F) != static_cast<uint8_t>(MessageType::LockstepState))
+	{
+		return false;
+	}
+
+	for (sf::Int32& value : values)
+	{
+		packet >> value;
+	}
+
+	if (!(packet >> playerOneScore >> playerTwoScore))
+	{
+		return false;
+	}
+
+	state.tick = tick;
+	state.ballPosition = FixedVec2(Fixed::FromRaw(values[0]), Fixed::FromRaw(values[1]));
+	state.ballVelocity = FixedVec2(Fixed::FromRaw(values[2]), Fixed::FromRaw(values[3]));
+	state.paddleOneY = Fixed::FromRaw(values[4]);
+	state.paddleTwoY = Fixed::FromRaw(values[5]);
+	state.playerOneScore = playerOneScore;
+	state.playerTwoScore = playerTwoScore;
+	time = serverTime;
+	inputAck = ack;
+	return true;
+}
+
+// Write the inputs of both paddles for count ticks up to tick, from arrays holding them oldest first
+inline void WriteLockstepInputs(sf::Packet& packet, uint32_t tick, uint32_t time, uint16_t inputAck, uint16_t checksum,
+	const PaddleInput* paddleOne, const PaddleInput* paddleTwo, int count)
+{
+	if (count > LOCKSTEP_HISTORY_SIZE)
+	{
+		paddleOne += count - LOCKSTEP_HISTORY_SIZE;
+		paddleTwo += count - LOCKSTEP_HISTORY_SIZE;
+		count = LOCKSTEP_HISTORY_SIZE;
+	}
+
+	sf::Uint8 header = static_cast<sf::Uint8>((PROTOCOL_VERSION << 4) | static_cast<uint8_t>(MessageType::LockstepInputs));
+	packet << header << static_cast<sf::Uint16>(tick) << static_cast<sf::Uint16>(time) << static_cast<sf::Uint16>(inputAck)
+		<< static_cast<sf::Uint16>(checksum) << static_cast<sf::Uint8>(count);
+
+	sf::Uint8 packed = 0;
+	for (int i = 0; i < count; i++)
+	{
+		uint8_t inputs = static_cast<uint8_t>(paddleOne[count - 1 - i]) | (static_cast<uint8_t>(paddleTwo[count - 1 - i]) << 2);
+		packed |= inputs << ((i % 2) * 4);
+		if (i % 2 == 1 || i == count - 1)
+		{
+			packet << packed;
+			packed = 0;
+		}
+	}
+}
+
+// Returns false if the message is not lockstep inputs of this protocol version or is truncated
+inline bool ReadLockstepInputs(sf::Packet& packet, LockstepInputsMessage& message)
+{
+	sf::Uint8 header = 0;
+	sf::Uint16 tick = 0;
+	sf::Uint16 time = 0;
+	sf::Uint16 inputAck = 0;
+	sf::Uint16 checksum = 0;
+	sf::Uint8 count = 0;
+
+	if (!(packet >> header >> tick >> time >> inputAck >> checksum >> count)
+		|| (header >> 4) != PROTOCOL_VERSION
+		|| (header & 0x0F) != static_cast<uint8_t>(MessageType::LockstepInputs)
+		|| count > LOCKSTEP_HISTORY_SIZE)
+	{
+		return false;
+	}
+
+	sf::Uint8 packed = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (i % 2 == 0 && !(packet >> packed))
+		{
+			return false;
+		}
+
+		uint8_t inputs = (packed >> ((i % 2) * 4)) & 0x0F;
+		message.paddleOne[count - 1 - i] = static_cast<PaddleInput>(inputs & 0x03);
+		message.paddleTwo[count - 1 - i] = static_cast<PaddleInput>(inputs >> 2);
+	}
+
+	message.tick = tick;
+	message.time = time;
+	message.inputAck = inputAck;
+	message.checksum = checksum;
+	message.count = count;
+	return true;
+}
+
+// Messages that must arrive, in order, sent over udp with ReliableSender and ReliableReceiver (see ReliableChannel.h)
+// Scores are not among them: every snapshot carries them, so the next snapshot makes up for any that is lost
+enum class ControlOpcode : uint8_t
+{
+	OpponentDisconnected = 0, // no values; the match has ended
+	Winner = 1 // number of the winning paddle; the match has ended
+};
+
+const int MAX_CONTROL_VALUES = 1;
+const int CONTROL_WINDOW = 32; // most unacknowledged control messages sent in one datagram
+
+struct ControlMessage
+{
+	ControlOpcode opcode = ControlOpcode::OpponentDisconnected;
+	uint8_t values[MAX_CONTROL_VALUES] = {};
+};
+
+// Number of values sent with a control message, or -1 for an opcode this protocol version does not have
+inline int ControlValueCount(ControlOpcode opcode)
+{
+	switch (opcode)
+	{
+	case ControlOpcode::OpponentDisconnected:
+		return 0;
+	case ControlOpcode::Winner:
+		return 1;
+	}
+
+	return -1;
+}
+
+// Write up to CONTROL_WINDOW messages with consecutive sequence numbers starting at firstSequence, oldest first
+inline void WriteControl(sf::Packet& packet, uint16_t firstSequence, const ControlMessage* messages, int count)
+{
+	// The oldest are sent, as the receiver takes them in order
+	if (count > CONTROL_WINDOW)
+	{
+		count = CONTROL_WINDOW;
+	}
+
+	sf::Uint8 header = static_cast<sf::Uint8>((PROTOCOL_VERSION << 4) | static_cast<uint8_t>(MessageType::Control));
+	packet << header << static_cast<sf::Uint16>(firstSequence) << static_cast<sf::Uint8>(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		packet << static_cast<sf::Uint8>(messages[i].opcode);
+		for (int v = 0; v < ControlValueCount(messages[i].opcode); v++)
+		{
+			packet << static_cast<sf::Uint8>(messages[i].values[v]);
+		}
+	}
+}
+
+// Read the messages of a control datagram into messages, oldest first, returning false if it is not control messages
+// of this protocol version, is truncated or has an unknown opcode. messages must hold CONTROL_WINDOW
+inline bool ReadControl(sf::Packet& packet, uint16_t& firstSequence, ControlMessage* messages, int& count)
+{
+	sf::Uint8 header = 0;
+	sf::Uint16 first = 0;
+	sf::Uint8 messageCount = 0;
+
+	if (!(packet >> header >> first >> messageCount)
+		|| (header >> 4) != PROTOCOL_VERSION
+		|| (header & 0x0F) != static_cast<uint8_t>(MessageType::Control)
+		|| messageCount > CONTROL_WINDOW)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < messageCount; i++)
+	{
+		sf::Uint8 opcode = 0;
+		if (!(packet >> opcode))
+		{
+			return false;
+		}
+
+		messages[i].opcode = static_cast<ControlOpcode>(opcode);
+		int valueCount = ControlValueCount(messages[i].opcode);
+		if (valueCount < 0)
+		{
+			return false;
+		}
+
+		for (int v = 0; v < valueCount; v++)
+		{
+			sf::Uint8 value = 0;
+			if (!(packet >> value))
+			{
+				return false;
+			}
+
+			messages[i].values[v] = value;
+		}
+	}
+
+	firstSequence = first;
+	count = messageCount;
+	return true;
+}
+
+inline void WriteControlAck(sf::Packet& packet, uint64_t sessionId, uint16_t sequence)
+{
+	sf::Uint8 header = static_cast<sf::Uint8>((PROTOCOL_VERSION << 4) | static_cast<uint8_t>(MessageType::ControlAck));
+	packet << header << static_cast<sf::Uint64>(sessionId) << static_cast<sf::Uint16>(sequence);
+}
+
+// Returns false if the message is not a control ack of this protocol version or is truncated
+inline bool ReadControlAck(sf::Packet& packet, uint64_t& sessionId, uint16_t& sequence)
+{
+	sf::Uint8 header = 0;
+	sf::Uint64 session = 0;
+	sf::Uint16 acked = 0;
+
+	if (!(packet >> header >> session >> acked)
+		|| (header >> 4) != PROTOCOL_VERSION
+		|| (header & 0x0F) != static_cast<uint8_t>(MessageType::ControlAck))
+	{
+		return false;
+	}
+
+	sessionId = session;
+	sequence = acked;
+	return true;
+}
+
+// Handshake that ties a client's udp socket to the session it joined over tcp
+const double HELLO_INTERVAL = 250.0; // milliseconds between hellos while no welcome has arrived
+const int HELLO_ATTEMPTS = 20; // hellos sent before the client gives up on the server
+
+// Hello and welcome share a layout and differ only in type
+inline void WriteSessionMessage(sf::Packet& packet, MessageType type, uint64_t sessionId)
+{
+	sf::Uint8 header = static_cast<sf::Uint8>((PROTOCOL_VERSION << 4) | static_cast<uint8_t>(type));
+	packet << header << static_cast<sf::Uint64>(sessionId);
+}
+
+// Returns false if the message is not a session message of the given type and this protocol version, or is truncated
+inline bool ReadSessionMessage(sf::Packet& packet, MessageType type, uint64_t& sessionId)
+{
+	sf::Uint8 header = 0;
+	sf::Uint64 session = 0;
+
+	if (!(packet >> header >> session)
+		|| (header >> 4) != PROTOCOL_VERSION
+		|| (header & 0x0F) != static_cast<uint8_t>(type))
+	{
+		return false;
+	}
+
+	sessionId = session;
+	return true;
+}
+
+// Heartbeats measure each client's round trip, as the server sees it, from the time a heartbeat was sent to when its
+// echo came back. The client echoes the time without reading it, so the clocks need not agree
+const double HEARTBEAT_INTERVAL = 250.0; // milliseconds between heartbeats to each client
+
+inline void WriteHeartbeat(sf::Packet& packet, uint32_t serverTime)
+{
+	sf::Uint8 header = static_cast<sf::Uint8>((PROTOCOL_VERSION << 4) | static_cast<uint8_t>(MessageType::Heartbeat));
+	packet << header << static_cast<sf::Uint32>(serverTime);
+}
+
+// Returns false if the message is not a heartbeat of this protocol version or is truncated
+inline bool ReadHeartbeat(sf::Packet& packet, uint32_t& serverTime)
+{
+	sf::Uint8 header = 0;
+	sf::Uint32 time = 0;
+
+	if (!(packet >> header >> time)
+		|| (header >> 4) != PROTOCOL_VERSION
+		|| (header & 0x0F) != static_cast<uint8_t>(MessageType::Heartbeat))
+	{
+		return false;
+	}
+
+	serverTime = time;
+	return true;
+}
+
+inline void WriteHeartbeatEcho(sf::Packet& packet, uint64_t sessionId, uint32_t serverTime)
+{
+	sf::Uint8 header = static_cast<sf::Uint8>((PROTOCOL_VERSION << 4) | static_cast<uint8_t>(MessageType::HeartbeatEcho));
+	packet << header << static_cast<sf::Uint64>(sessionId) << static_cast<sf::Uint32>(serverTime);
+}
+
+// Returns false if the message is not a heartbeat echo of this protocol version or is truncated
+inline bool ReadHeartbeatEcho(sf::Packet& packet, uint64_t& sessionId, uint32_t& serverTime)
+{
+	sf::Uint8 header = 0;
+	sf::Uint64 session = 0;
+	sf::Uint32 time = 0;
+
+	if (!(packet >> header >> session >> time)
+		|| (header >> 4) != PROTOCOL_VERSION
+		|| (header & 0x0F) != static_cast<uint8_t>(MessageType::HeartbeatEcho))
+	{
+		return false;
+	}
+
+	sessionId = session;
+	serverTime = time;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include <math.h>
+#include "Reactor.h"
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+
+Reactor::Reactor()
+{
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+}
+
+Reactor::~Reactor()
+{
+	if (epollFd >= 0)
+	{
+		close(epollFd);
+	}
+}
+
+bool Reactor::Add(sf::Socket&, sf::SocketHandle handle, void* context)
+{
+	epoll_event event{};
+	event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+	event.data.ptr = context;
+
+	return epoll_ctl(epollFd, EPOLL_CTL_ADD, handle, &event) == 0;
+}
+
+void Reactor::Remove(sf::Socket&, sf::SocketHandle handle)
+{
+	epoll_ctl(epollFd, EPOLL_CTL_DEL, handle, NULL);
+}
+
+// Wait up to timeoutMs (forever if negative) for registered sockets to become readable
+// and add their contexts to ready. Returns the number of ready sockets
+int Reactor::Wait(double timeoutMs, std::vector<void*>& ready)
+{
+	epoll_event events[MAX_EVENTS];
+
+	ready.clear();
+
+	// Round up so a wait for part of a millisecond does not turn into a busy loop
+	int timeout = timeoutMs < 0.0 ? -1 : static_cast<int>(ceil(timeoutMs));
+	int count = epoll_wait(epollFd, events, MAX_EVENTS, timeout);
+	if (count < 0)
+	{
+		// Interrupted by a signal, report no ready sockets
+		return 0;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		ready.push_back(events[i].data.ptr);
+	}
+
+	return count;
+}
+
+#else
+
+Reactor::Reactor()
+{
+}
+
+Reactor::~Reactor()
+{
+}
+
+bool Reactor::Add(sf::Socket& socket, sf::SocketHandle handle, void* context)
+{
+	selector.add(socket);
+	registrations[handle] = Registration{ &socket, context };
+
+	return true;
+}
+
+void Reactor::Remove(sf::Socket& socket, sf::SocketHandle handle)
+{
+	selector.remove(socket);
+	registrations.erase(handle);
+}
+
+int Reactor::Wait(double timeoutMs, std::vector<void*>& ready)
+{
+	ready.clear();
+
+	// A zero sf::Time means wait forever, so the shortest finite wait is one microsecond
+	sf::Time timeout = timeoutMs < 0.0 ? sf::Time::Zero : sf::microseconds(static_cast<sf::Int64>(timeoutMs * 1000.0) + 1);
+	if (!selector.wait(timeout))
+	{
+		return 0;
+	}
+
+	for (const std::pair<const sf::SocketHandle, Registration>& r : registrations)
+	{
+		if (selector.isReady(*r.second.socket))
+		{
+			ready.push_back(r.second.context);
+		}
+	}
+
+	return static_cast<int>(ready.size());
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <vector>
+#ifndef __linux__
+#include <map>
+#endif
+
+// SFML keeps the native handle of a socket protected, these expose it so the reactor can register it
+class ReactorTcpListener : public sf::TcpListener
+{
+public:
+	using sf::TcpListener::getHandle;
+};
+
+class ReactorTcpSocket : public sf::TcpSocket
+{
+public:
+	using sf::TcpSocket::getHandle;
+};
+
+class ReactorUdpSocket : public sf::UdpSocket
+{
+public:
+	using sf::UdpSocket::getHandle;
+};
+
+// Network event loop for the server. Sockets are registered with a context pointer, and Wait
+// returns the contexts of the sockets that became readable
+//
+// On Linux this is an edge-triggered epoll set, so the cost of a wait is proportional to the
+// number of ready sockets rather than the number registered. Because readiness is only reported
+// on a change of state, the owner of a socket must read from it until it would block
+// Other platforms fall back to sf::SocketSelector, which has to test every registered socket
+class Reactor
+{
+public:
+	Reactor();
+	~Reactor();
+
+	template <typename T>
+	bool Add(T& socket, void* context) { return Add(socket, socket.getHandle(), context); }
+
+	template <typename T>
+	void Remove(T& socket) { Remove(socket, socket.getHandle()); }
+
+	int Wait(double timeoutMs, std::vector<void*>& ready);
+
+private:
+	bool Add(sf::Socket& socket, sf::SocketHandle handle, void* context);
+	void Remove(sf::Socket& socket, sf::SocketHandle handle);
+
+#ifdef __linux__
+	static const int MAX_EVENTS = 1024; // events collected per wait, any more are returned by the next wait
+
+	int epollFd = -1;
+#else
+	struct Registration
+	{
+		sf::Socket* socket;
+		void* context;
+	};
+
+	sf::SocketSelector selector;
+	std::map<sf::SocketHandle, Registration> registrations;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include "ReliableChannel.h"
+
+void ReliableSender::Queue(const ControlMessage& message)
+{
+	Pending entry;
+	entry.message = message;
+	entry.sequence = nextSequence++;
+	pending.push_back(entry);
+	unsent++;
+}
+
+bool ReliableSender::ShouldSend(double now) const
+{
+	// New messages wait while the window is full of older ones
+	int sent = static_cast<int>(pending.size()) - unsent;
+	return !pending.empty() && ((unsent > 0 && sent < CONTROL_WINDOW) || now >= resendTime);
+}
+
+void ReliableSender::Write(sf::Packet& packet, double now)
+{
+	ControlMessage messages[CONTROL_WINDOW];
+	int sent = static_cast<int>(pending.size()) - unsent;
+	int count = std::min(static_cast<int>(pending.size()), CONTROL_WINDOW);
+	for (int i = 0; i < count; i++)
+	{
+		Pending& entry = pending[i];
+		messages[i] = entry.message;
+
+		if (i < sent)
+		{
+			entry.resent = true;
+		}
+		else
+		{
+			entry.sentTime = now;
+		}
+	}
+
+	// Back off while resends go unanswered, so a peer that has gone is not flooded
+	if (count <= sent)
+	{
+		timeout = std::min(timeout * 2.0, CONTROL_MAX_TIMEOUT);
+		resends++;
+	}
+
+	unsent -= std::max(count - sent, 0);
+	resendTime = now + timeout;
+
+	WriteControl(packet, pending.front().sequence, messages, count);
+}
+
+void ReliableSender::Acknowledge(uint16_t sequence, double now)
+{
+	// Messages not sent yet cannot have been received, whatever the acknowledgement says
+	while (static_cast<int>(pending.size()) > unsent && !SequenceGreaterThan(pending.front().sequence, sequence))
+	{
+		// Only a message sent once gives a round trip, as an acknowledgement of a resent one could be for either send
+		const Pending& entry = pending.front();
+		if (!entry.resent)
+		{
+			roundTrip.AddSample(now - entry.sentTime);
+		}
+
+		pending.pop_front();
+	}
+
+	if (roundTrip.Measured())
+	{
+		timeout = roundTrip.Timeout(CONTROL_MIN_TIMEOUT, CONTROL_MAX_TIMEOUT);
+	}
+
+	// What is still waiting is resent a full timeout after this answer
+	resendTime = now + timeout;
+}
+
+bool ReliableReceiver::Read(sf::Packet& packet, std::vector<ControlMessage>& delivered)
+{
+	ControlMessage messages[CONTROL_WINDOW];
+	uint16_t firstSequence = 0;
+	int count = 0;
+	if (!ReadControl(packet, firstSequence, messages, count))
+	{
+		return false;
+	}
+
+	// Take the messages that follow on from the newest taken. If one before them was missed, wait for it to be resent
+	for (int i = 0; i < count; i++)
+	{
+		uint16_t sequence = static_cast<uint16_t>(firstSequence + i);
+		if (sequence == static_cast<uint16_t>(received + 1))
+		{
+			delivered.push_back(messages[i]);
+			received = sequence;
+		}
+	}
+
+	return true;
+}
+
+void ReliableReceiver::Clear()
+{
+	received = 0;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include <algorithm>
+#include "SendRate.h"
+
+void SendRateController::Reset(double newMaxRate, double budgetBytesPerSecond, double now)
+{
+	maxRate = newMaxRate;
+	budget = budgetBytesPerSecond;
+	rate = std::max(maxRate / 2.0, std::min(MIN_SNAPSHOT_RATE, maxRate));
+	snapshotBytes = 0.0;
+	credit = 1.0;
+	nextUpdate = now + SEND_RATE_UPDATE_INTERVAL;
+	holdUntil = now;
+	minRoundTrips.clear();
+	losses = 0;
+	backoffs = 0;
+}
+
+void SendRateController::Update(Heartbeat& heartbeat, double now)
+{
+	losses += heartbeat.TakeLosses(now);
+	if (now < nextUpdate)
+	{
+		return;
+	}
+
+	nextUpdate = now + SEND_RATE_UPDATE_INTERVAL;
+
+	// The lowest round trip of the window is the path with empty queues. It is taken over a window rather than ever,
+	// so that after a route change, or one lucky early sample, it rises to what the path is now. Queueing delay is
+	// measured on the latest sample rather than the smoothed round trip, which would still be high long after the rate was cut
+	const RoundTripEstimator& roundTrip = heartbeat.RoundTrip();
+	bool queueing = false;
+	if (roundTrip.Measured())
+	{
+		double latest = roundTrip.Latest();
+		while (!minRoundTrips.empty() && minRoundTrips.back().roundTrip >= latest)
+		{
+			minRoundTrips.pop_back();
+		}
+		minRoundTrips.push_back({ now, latest });
+		while (minRoundTrips.front().time < now - MIN_ROUND_TRIP_WINDOW)
+		{
+			minRoundTrips.pop_front();
+		}
+
+		queueing = latest - minRoundTrips.front().roundTrip > QUEUEING_DELAY_THRESHOLD;
+	}
+
+	if (losses > 0 || queueing)
+	{
+		// Once cut, wait for the round trip after the cut to show whether it was enough
+		if (now >= holdUntil)
+		{
+			rate = std::max(rate * SEND_RATE_BACKOFF, std::min(MIN_SNAPSHOT_RATE, maxRate));
+			holdUntil = now + std::max(2.0 * SEND_RATE_UPDATE_INTERVAL, roundTrip.Smoothed());
+			backoffs++;
+		}
+	}
+	else
+	{
+		rate = std::min(rate + SNAPSHOT_RATE_STEP, maxRate);
+	}
+
+	rate = std::min(rate, std::max(BudgetRate(), std::min(MIN_SNAPSHOT_RATE, maxRate)));
+	losses = 0;
+}
+
+// Snapshots are sent on ticks, so the rate is turned into credit for every tick simulated. At the tick rate every tick
+// earns a whole snapshot. Credit is capped at one, as one snapshot supersedes any others due with it
+bool SendRateController::ShouldSend(int ticks, int tickRate)
+{
+	credit = std::min(credit + ticks * rate / tickRate, 1.0);
+	if (credit < 1.0)
+	{
+		return false;
+	}
+
+	credit -= 1.0;
+	return true;
+}
+
+void SendRateController::Sent(int bytes, int datagrams)
+{
+	double size = bytes + datagrams * DATAGRAM_OVERHEAD_BYTES;
+	snapshotBytes = (snapshotBytes == 0.0) ? size : 0.875 * snapshotBytes + 0.125 * size;
+}
+
+// Snapshots per second that fit in the budget at their current size
+double SendRateController::BudgetRate() const
+{
+	return (snapshotBytes > 0.0) ? budget / snapshotBytes : maxRate;
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <deque>
+#include "Heartbeat.h"
+
+const double MIN_SNAPSHOT_RATE = 10.0; // snapshots per second a client is sent however congested its link
+const double SNAPSHOT_RATE_STEP = 5.0; // snapshots per second added every SEND_RATE_UPDATE_INTERVAL the link is clear
+const double SEND_RATE_BACKOFF = 0.5; // fraction of the rate kept when the link is congested
+const double SEND_RATE_UPDATE_INTERVAL = 250.0; // milliseconds between decisions, one heartbeat
+const double QUEUEING_DELAY_THRESHOLD = 40.0; // milliseconds of round trip over the lowest seen taken as queues building up
+const double MIN_ROUND_TRIP_WINDOW = 10000.0; // milliseconds the lowest round trip is taken over, so it follows a new route
+const double DATAGRAM_OVERHEAD_BYTES = 28.0; // ip and udp headers, counted against the bandwidth budget
+const int DEFAULT_CLIENT_BUDGET_KBPS = 256; // bandwidth each client may be sent, in kilobits per second
+
+// Congestion control of the snapshots sent to one client, additive increase and multiplicative decrease as tcp does.
+// The rate goes up a step at a time while the link is clear, up to one snapshot per tick, and is cut when it shows
+// congestion: a heartbeat lost, or the round trip rising well above the lowest of the last MIN_ROUND_TRIP_WINDOW as
+// queues fill along the path.
+// It is capped so the snapshots fit in the client's bandwidth budget, whatever their size, down to MIN_SNAPSHOT_RATE
+class SendRateController
+{
+public:
+	// Start at half the tick rate, so a client on a bad link is not flooded before its link is measured
+	void Reset(double maxRate, double budgetBytesPerSecond, double now);
+
+	// Decide the rate from the client's heartbeats, every SEND_RATE_UPDATE_INTERVAL
+	void Update(Heartbeat& heartbeat, double now);
+
+	// Whether a snapshot is due, given the ticks simulated since the last call at tickRate ticks per second
+	bool ShouldSend(int ticks, int tickRate);
+
+	// Count a snapshot sent, in bytes over datagrams datagrams
+	void Sent(int bytes, int datagrams);
+
+	double Rate() const { return rate; }
+	double BudgetRate() const;
+	uint64_t Backoffs() const { return backoffs; }
+
+private:
+	double rate = 0.0; // snapshots per second
+	double maxRate = 0.0;
+	double budget = 0.0; // bytes per second
+	double snapshotBytes = 0.0; // smoothed size of a snapshot with its datagram headers, 0 until one is sent
+	double credit = 0.0; // snapshots due, sent when it reaches 1
+	double nextUpdate = 0.0;
+	double holdUntil = 0.0; // the rate is not cut again before this, so one burst of congestion cuts it once
+	struct RoundTripSample
+	{
+		double time;
+		double roundTrip;
+	};
+
+	// Round trips of the window that may yet be its lowest, oldest and lowest first: each is lower than any before it
+	std::deque<RoundTripSample> minRoundTrips;
+	int losses = 0; // heartbeats lost since the last decision
+	uint64_t backoffs = 0;
+};
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include <algorithm>
+#include "TickScheduler.h"
+
+TickScheduler::TickScheduler(int tickRate)
+	: tickRate(tickRate > 0 ? tickRate : DEFAULT_TICK_RATE)
+{
+	tickDt = 1000.0 / this->tickRate;
+	Reset();
+}
+
+void TickScheduler::Reset()
+{
+	accumulator = 0.0;
+	tick = 0;
+	lastTime = Clock::now();
+}
+
+// Add the real time elapsed since the last call to the accumulator
+void TickScheduler::Advance()
+{
+	Clock::time_point now = Clock::now();
+	accumulator += std::chrono::duration<double, std::milli>(now - lastTime).count();
+	lastTime = now;
+
+	// If the loop stalled (e.g. blocked on a send), drop the backlog rather than
+	// running a burst of ticks that would stall the next iteration as well
+	accumulator = std::min(accumulator, tickDt * maxCatchUpTicks);
+}
+
+// Returns true and consumes one tick from the accumulator if a whole tick is due
+bool TickScheduler::ShouldTick()
+{
+	if (accumulator < tickDt)
+	{
+		return false;
+	}
+
+	accumulator -= tickDt;
+	++tick;
+
+	return true;
+}
+
+// Time left before the next tick is due, used to bound how long the loop may sleep
+double TickScheduler::MillisecondsUntilNextTick() const
+{
+	double elapsed = std::chrono::duration<double, std::milli>(Clock::now() - lastTime).count();
+	double remaining = tickDt - (accumulator + elapsed);
+
+	return std::max(remaining, 0.0);
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+const int DEFAULT_TICK_RATE = 60; // simulation ticks per second
+
+// Fixed timestep scheduler for the server simulation
+// Elapsed real time is added to an accumulator and consumed in whole ticks, so the
+// simulation advances by the same dt every tick no matter how often the loop wakes up
+class TickScheduler
+{
+public:
+	TickScheduler(int tickRate);
+
+	void Reset();
+	void Advance();
+	bool ShouldTick();
+	double MillisecondsUntilNextTick() const;
+
+	float TickDt() const { return static_cast<float>(tickDt); }
+	uint32_t Tick() const { return tick; }
+	int TickRate() const { return tickRate; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	int tickRate;
+	double tickDt; // milliseconds per tick
+	double accumulator = 0.0; // milliseconds of real time not yet simulated
+	uint32_t tick = 0; // number of ticks simulated since the scheduler was reset
+	int maxCatchUpTicks = 5; // limit on ticks run per Advance after a stall
+	Clock::time_point lastTime;
+};
\ No newline at end of file
@@ -1,21 +1,24 @@
 #pragma once
-class Vec2
+// Two dimensional vector of any number type. Vec2 is the float one used everywhere, and FixedVec2 (Fixed.h)
+// the fixed-point one of the lockstep simulation
+template <typename T>
+class Vector2
 {
 public:
-	Vec2()
-		: x(0.0f), y(0.0f)
+	Vector2()
+		: x(T(0)), y(T(0))
 	{}
 
-	Vec2(float x, float y)
+	Vector2(T x, T y)
 		: x(x), y(y)
 	{}
 
-	Vec2 operator+(Vec2 const& rhs)
+	Vector2 operator+(Vector2 const& rhs)
 	{
-		return Vec2(x + rhs.x, y + rhs.y);
+		return Vector2(x + rhs.x, y + rhs.y);
 	}
 
-	Vec2& operator+=(Vec2 const& rhs)
+	Vector2& operator+=(Vector2 const& rhs)
 	{
 		x += rhs.x;
 		y += rhs.y;
@@ -23,10 +26,36 @@ public:
 		return *this;
 	}
 
-	Vec2 operator*(float rhs)
+	Vector2 operator*(T rhs)
 	{
-		return Vec2(x * rhs, y * rhs);
+		return Vector2(x * rhs, y * rhs);
 	}
 
-	float x, y;
+	bool operator==(Vector2 const& rhs)
+	{
+		if (x == rhs.x && y == rhs.y)
+		{
+			return true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	bool operator!=(Vector2 const& rhs)
+	{
+		if (x != rhs.x || y != rhs.y)
+		{
+			return true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	T x, y;
 };
+
+typedef Vector2<float> Vec2;
\ No newline at end of file
@@ -1,937 +1,565 @@
-#include <SDL.h>
 #include <SFML/Network.hpp>
 #include <SFML/System/Time.hpp>
 #include <stdio.h>
-#include <iostream>
+#include <stdlib.h>
+#include <csignal>
+#include <algorithm>
 #include <list>
+#include <memory>
+#include <string>
+#include <vector>
 #include "Global.h"
 #include "Vec2.h"
 #include "Ball.h"
 #include "Paddle.h"
-
-struct ScoreMessage
-{
-	double timestamp = 0;
-	int playerOneScore, playerTwoScore = 0;
-};
-
-struct Client
-{
-	sf::TcpSocket* tcpSocket = NULL;
-	int paddle = 0;
-	Vec2 lastPosition = Vec2(0,0);
-	bool ready = false;
-	unsigned short portBallPos = 0;
-	double lastMsgTimestamp = 0;
-};
-
-sf::Packet& operator <<(sf::Packet& packet, const Message& message)
+#include "Match.h"
+#include "ClientTable.h"
+#include "Protocol.h"
+#include "Benchmark.h"
+#include "Reactor.h"
+#include "DatagramBatch.h"
+#include "TickScheduler.h"
+#include "PaddleHistory.h"
+#include "Logger.h"
+#include "MonotonicClock.h"
+
+const double IDLE_WAIT_MILLISECONDS = 500.0; // longest wait for socket activity while no match is being played
+
+// Set from the signal handler when the server is asked to stop (Ctrl+C, or SIGTERM from a service manager)
+static volatile std::sig_atomic_t shutdownRequested = 0;
+
+static void RequestShutdown(int)
 {
-	return packet << message.timestamp << message.x << message.y << message.ball << message.port;
-}
-
-sf::Packet& operator >>(sf::Packet& packet, Message& message)
-{
-	return packet >> message.timestamp >> message.x >> message.y >> message.ball >> message.port;
-
+	shutdownRequested = 1;
 }
 
-sf::Packet& operator <<(sf::Packet& packet, const ScoreMessage& scoreMessage)
-{
-	return packet << scoreMessage.timestamp << scoreMessage.playerOneScore << scoreMessage.playerTwoScore;
-}
-
-sf::Packet& operator >>(sf::Packet& packet, ScoreMessage& scoreMessage)
-{
-	return packet >> scoreMessage.timestamp >> scoreMessage.playerOneScore >> scoreMessage.playerTwoScore;
-}
-
-struct Ball::Contact CheckPaddleCollision(Ball const& ball, Paddle const& paddle)
+int main(int argc, char* argv[])
 {
-	float ballLeft = ball.position.x;
-	float ballRight = ball.position.x + BALL_WIDTH;
-	float ballTop = ball.position.y;
-	float ballBottom = ball.position.y + BALL_HEIGHT;
-
-	float paddleLeft = paddle.position.x;
-	float paddleRight = paddle.position.x + PADDLE_WIDTH;
-	float paddleTop = paddle.position.y;
-	float paddleBottom = paddle.position.y + PADDLE_HEIGHT;
-
-	Ball::Contact contact{};
-
-	if (ballLeft >= paddleRight)
+	// Start global timer for timestamping messages and logs
+	uint64_t globalTime = MonotonicMilliseconds();
+
+	// Simulation rate can be set with --tick-rate <ticks per second>
+	// Passing --bench-matches <number of matches> runs the match benchmark instead of the server
+	// Passing --bench-protocol <number of messages> runs the wire protocol benchmark instead of the server
+	// Lag compensation can rewind paddle collisions by up to --rewind-ms <milliseconds> (0 turns it off)
+	// Passing --bench-rewind <number of tests> measures the cost of a rewound collision test instead of running the server
+	// Passing --balls <count> plays multi-ball matches, with up to MAX_BALLS balls of which only the first scores
+	// Passing --bench-balls <number of balls> measures how many balls a core can move per microsecond instead of running the server
+	// Clients are kept in sync with --sync <snapshots|lockstep>: snapshots of the match every tick (the default), or only
+	// the inputs of both paddles, from which each client simulates the match itself. Lockstep matches tick at INPUT_RATE
+	// Passing --bench-lockstep <number of ticks> measures the lockstep simulation and its bandwidth instead of running the server
+	// A playing client not heard from for --liveness-ms <milliseconds> has left its match. Heartbeats every HEARTBEAT_INTERVAL
+	// keep it heard from, so the timeout is at least two of them
+	// Each client is sent as many snapshots as its link takes, up to one a tick and within --client-kbps <kilobits per second>
+	// Logging can be limited to --log-level <debug|info|warning|error|off>, and to --log-rate <lines per second> for each category
+	int tickRate = DEFAULT_TICK_RATE;
+	int rewindMilliseconds = DEFAULT_REWIND_MILLISECONDS;
+	int benchMatches = 0;
+	int benchMessages = 0;
+	int benchRewindTests = 0;
+	int ballCount = 1;
+	int benchBalls = 0;
+	bool lockstep = false;
+	int benchLockstepTicks = 0;
+	double livenessTimeout = DEFAULT_LIVENESS_MILLISECONDS;
+	int clientBudgetKbps = DEFAULT_CLIENT_BUDGET_KBPS;
+	LogLevel logLevel = Logger::Instance().GetLevel();
+	int logRateLimit = DEFAULT_LOG_RATE_LIMIT;
+	for (int i = 1; i < argc - 1; i++)
 	{
-		return contact;
+		if (std::string(argv[i]) == "--tick-rate")
+		{
+			tickRate = atoi(argv[i + 1]);
+		}
+		else if (std::string(argv[i]) == "--bench-matches")
+		{
+			benchMatches = atoi(argv[i + 1]);
+		}
+		else if (std::string(argv[i]) == "--bench-protocol")
+		{
+			benchMessages = atoi(argv[i + 1]);
+		}
+		else if (std::string(argv[i]) == "--rewind-ms")
+		{
+			rewindMilliseconds = atoi(argv[i + 1]);
+		}
+		else if (std::string(argv[i]) == "--bench-rewind")
+		{
+			benchRewindTests = atoi(argv[i + 1]);
+		}
+		else if (std::string(argv[i]) == "--balls")
+		{
+			ballCount = std::min(std::max(atoi(argv[i + 1]), 1), MAX_BALLS);
+		}
+		else if (std::string(argv[i]) == "--bench-balls")
+		{
+			benchBalls = atoi(argv[i + 1]);
+		}
+		else if (std::string(argv[i]) == "--sync")
+		{
+			lockstep = std::string(argv[i + 1]) == "lockstep";
+		}
+		else if (std::string(argv[i]) == "--bench-lockstep")
+		{
+			benchLockstepTicks = atoi(argv[i + 1]);
+		}
+		else if (std::string(argv[i]) == "--liveness-ms")
+		{
+			livenessTimeout = std::max(atof(argv[i + 1]), 2.0 * HEARTBEAT_INTERVAL);
+		}
+		else if (std::string(argv[i]) == "--client-kbps")
+		{
+			clientBudgetKbps = std::max(atoi(argv[i + 1]), 1);
+		}
+		else if (std::string(argv[i]) == "--log-level")
+		{
+			Logger::ParseLevel(argv[i + 1], logLevel);
+		}
+		else if (std::string(argv[i]) == "--log-rate")
+		{
+			logRateLimit = atoi(argv[i + 1]);
+		}
 	}
 
-	if (ballRight <= paddleLeft)
+	// Every lockstep tick simulates one input command
+	if (lockstep)
 	{
-		return contact;
+		tickRate = INPUT_RATE;
 	}
 
-	if (ballTop >= paddleBottom)
-	{
-		return contact;
-	}
+	// The rewind window is kept in ticks, capped by how many ticks of history are kept
+	int rewindTicks = std::min(std::max(rewindMilliseconds, 0) * (tickRate > 0 ? tickRate : DEFAULT_TICK_RATE) / 1000, MAX_REWIND_TICKS);
 
-	if (ballBottom <= paddleTop)
+	if (benchMatches > 0)
 	{
-		return contact;
+		RunMatchBenchmark(benchMatches, tickRate > 0 ? tickRate : DEFAULT_TICK_RATE, 10);
+		return 0;
 	}
 
-	float paddleRangeUpper = paddleBottom - (2.0f * PADDLE_HEIGHT / 3.0f);
-	float paddleRangeMiddle = paddleBottom - (PADDLE_HEIGHT / 3.0f);
-
-	if (ball.velocity.x < 0)
+	if (benchMessages > 0)
 	{
-		// Left paddle
-		contact.penetration = paddleRight - ballLeft;
-	}
-	else if (ball.velocity.x > 0)
-	{
-		// Right paddle
-		contact.penetration = paddleLeft - ballRight;
+		RunProtocolBenchmark(benchMessages);
+		return 0;
 	}
 
-	if ((ballBottom > paddleTop)
-		&& (ballBottom < paddleRangeUpper))
-	{
-		contact.type = Ball::CollisionType::Top;
-	}
-	else if ((ballBottom > paddleRangeUpper)
-		&& (ballBottom < paddleRangeMiddle))
-	{
-		contact.type = Ball::CollisionType::Middle;
-	}
-	else
+	if (benchRewindTests > 0)
 	{
-		contact.type = Ball::CollisionType::Bottom;
+		RunRewindBenchmark(benchRewindTests, std::max(rewindTicks, 1));
+		return 0;
 	}
 
-	return contact;
-}
-
-struct Ball::Contact CheckWallCollision(Ball const& ball)
-{
-	float ballLeft = ball.position.x;
-	float ballRight = ball.position.x + BALL_WIDTH;
-	float ballTop = ball.position.y;
-	float ballBottom = ball.position.y + BALL_HEIGHT;
-
-	Ball::Contact contact{};
-
-	if (ballLeft < 0.0f)
-	{
-		contact.type = Ball::CollisionType::Left;
-	}
-	else if (ballRight > WINDOW_WIDTH)
-	{
-		contact.type = Ball::CollisionType::Right;
-	}
-	else if (ballTop < 0.0f)
+	if (benchBalls > 0)
 	{
-		contact.type = Ball::CollisionType::Top;
-		contact.penetration = -ballTop;
+		RunBallBenchmark(benchBalls, tickRate > 0 ? tickRate : DEFAULT_TICK_RATE);
+		return 0;
 	}
-	else if (ballBottom > WINDOW_HEIGHT)
+
+	if (benchLockstepTicks > 0)
 	{
-		contact.type = Ball::CollisionType::Bottom;
-		contact.penetration = WINDOW_HEIGHT - ballBottom;
+		RunLockstepBenchmark(benchLockstepTicks);
+		return 0;
 	}
 
-	return contact;
-}
+	// Log lines are written to the console by a background thread from here on
+	Logger::Instance().SetLevel(logLevel);
+	Logger::Instance().SetRateLimit(logRateLimit);
+	Logger::Instance().Start();
 
-
-int main(int argc, char* argv[])
-{		
-	// Start global timer for timestamping messages and logs
-	Uint64 globalTime = SDL_GetTicks();
-	
-	// Initialize SDL components
-	SDL_Init(SDL_INIT_VIDEO);
+	// Stop cleanly on Ctrl+C or SIGTERM. There is no window, so this is the only way to stop the server
+	std::signal(SIGINT, RequestShutdown);
+	std::signal(SIGTERM, RequestShutdown);
+#ifdef __linux__
+	// A client that disconnects mid-send must not kill the server
+	std::signal(SIGPIPE, SIG_IGN);
+#endif
 
 	// Initialize server tcp socket
-	sf::TcpListener listener;	
+	// Non-blocking so that every pending connection can be accepted when the listener is ready
+	ReactorTcpListener listener;
+	listener.setBlocking(false);
 	if (listener.listen(4445) != sf::Socket::Done) // bind the listener to a port
 	{
-		std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-			<< "\t| tcp socket listen error"
-			<< std::endl;
+		LOG_ERROR(LogCategory::Network) << "tcp socket listen error";
 	}
-	
-	// Create a selector
-	sf::SocketSelector selector;
 
-	// Add the listener to the selector
-	selector.add(listener);
+	// Create the network event loop and add the listener to it
+	Reactor reactor;
+	std::vector<void*> readyContexts;
+	reactor.Add(listener, &listener);
 
 	// Initialize server udp socket
 	unsigned short listenPort = 4444;
-	sf::UdpSocket socket;
+	ReactorUdpSocket socket;
 	socket.setBlocking(false);
 	if (socket.bind(listenPort) != sf::Socket::Done)
 	{
-		std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-			<< "\t| udp socket bind error on port " << listenPort
-			<< std::endl;
+		LOG_ERROR(LogCategory::Network) << "udp socket bind error on port " << listenPort;
 	}
 
-	// Properties of received message
-	sf::IpAddress clientIp;
-	unsigned short clientPort;
+	// Wake up as soon as input commands arrive so they are queued before the next tick
+	reactor.Add(socket, &socket);
+
+	// Datagrams are received and sent in batches to cut the number of system calls per tick
+	DatagramBatch batch(socket);
+	int batchCount = 0;
+	uint32_t batchTime = 0; // server time the current batch was received
+	ClockExchange clockExchange;
+	bool clockResponsesQueued = false;
 
 	// Variables to send/receive packet data to
 	sf::Packet packet;
-	sf::Packet ballPacket;
-	Message msg;
-	Message ballMsg;
-	ScoreMessage scores;
-	sf::Uint8 header;
-	
-	// List of clients
-	std::list<Client> clients;
-	
-	// Create the ball
-	Ball ball(
-		Vec2((WINDOW_WIDTH / 2.0f) - (BALL_WIDTH / 2.0f), (WINDOW_HEIGHT / 2.0f) - (BALL_WIDTH / 2.0f)),
-		Vec2(BALL_SPEED, 0.0f)
-	);
-
-	// Create the paddles
-	Paddle paddleOne(
-		Vec2(50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f)),
-		Vec2(0.0f, 0.0f)
-	);
-
-	Paddle paddleTwo(
-		Vec2(WINDOW_WIDTH - 50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f)),
-		Vec2(0.0f, 0.0f)
-	);	
+	InputCommand inputs[MAX_INPUTS_PER_MESSAGE];
+	int inputCount = 0;
+	uint16_t ackTick = 0;
+	uint16_t controlAck = 0;
+	uint64_t sessionId = 0;
+	uint32_t heartbeatTime = 0;
+
+	// Matches hosted by this server, and every client with the match it belongs to, by session ID
+	std::list<Match> matches;
+	ClientTable clientTable;
+	std::vector<uint64_t> departedSessions;
+	int nextMatchId = 1;
 
 	// Game logic
 	{
-		int playerOneScore = 0;
-		int playerTwoScore = 0;
-		int playerOnePrevScore = 0;
-		int playerTwoPrevScore = 0;
-		int winner = 0;
-		int winningScore = 7;
-
-		int assignedPaddle = 1;
-		int playersReady = 0;
-		unsigned short playerReadyMsg = 0;
-		
-		bool gameStarted = false;
-		bool clientDisconnected = false;
-
-		Ball::Contact contact{};
-
-		double newestPaddleOnePosTimestamp = 0;
-		double newestPaddleTwoPosTimestamp = 0;
-
 		bool running = true;
-		bool buttons[2] = {};
+		bool playing = false;
 
 		// Timing variables
-		float dt = 0.0f;
-		Uint64 startTicks = 0;
-		Uint64 endTicks = 0;
-		float sendDt = 0.0f;
-		float sendRate = 100.0f;
-		Uint64 sendStartTicks = SDL_GetTicks();
-		Uint64 sendEndTicks = 0;
+		TickScheduler scheduler(tickRate);
+		bool ticked = false;
 		float logDt = 0.0f;
 		float logRate = 1500.0f;
-		Uint64 logStartTicks = SDL_GetTicks();
-		Uint64 logEndTicks = 0;
+		uint64_t logStartTicks = MonotonicMilliseconds();
+		uint64_t logEndTicks = 0;
 
-		// Prediction and interpolation variables
-		Message msgBasedPrediction{};
-		int numPredictions = 0;
-		Message predictionBasedPrediction{};
-		float averagePrediction = 0;
-		float interpolatedPosition = 0;
+		LOG_INFO(LogCategory::General) << "Waiting for clients to connect...";
 
-		// Continue looping and processing events until user exits
+		// Continue looping and processing events until asked to stop
 		while (running)
 		{
-			startTicks = SDL_GetTicks();			
-
-			// If both client ball position socket port numbers have been received
-			// Send game started message to client and enter main game loop
-			if (!gameStarted && playersReady == 2)
+			// If any match is being played, wait for socket activity until the next tick is due
+			// Otherwise there is nothing to simulate, so wait until a socket is ready. The idle wait is bounded so that
+			// a shutdown signal handled on another thread is still noticed
+			if (playing)
 			{
-				for (Client& c : clients)
-				{										
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Sending game started message to: "
-						<< (*c.tcpSocket).getRemoteAddress() << " at " << "port " << (*c.tcpSocket).getRemotePort()
-						<< std::endl;
-												
-					packet.clear();
-					packet << "game started";
-					if ((*c.tcpSocket).send(packet) != sf::Socket::Done)
-					{
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| tcp socket send error"
-							<< std::endl;
-					}
-				}
-				gameStarted = true;
+				reactor.Wait(scheduler.MillisecondsUntilNextTick(), readyContexts);
+			}
+			else
+			{
+				reactor.Wait(IDLE_WAIT_MILLISECONDS, readyContexts);
+				scheduler.Reset();
 			}
 
-			// Wait for both clients to connect, assign paddles and send ball position socket port numbers
-			if (!gameStarted)
+			if (shutdownRequested)
 			{
-				std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-					<< "\t| Waiting for clients to connect..."
-					<< std::endl;
+				LOG_INFO(LogCategory::General) << "Shutting down...";
+				running = false;
+			}
 
-				// Make the selector wait for data on any socket
-				if (selector.wait())
-				{
-					// Test the listener
-					if (selector.isReady(listener))
-					{
-						// The listener is ready: there is a pending connection
-						sf::TcpSocket* clientTcpSocket = new sf::TcpSocket;
-						if (listener.accept(*clientTcpSocket) == sf::Socket::Done)
-						{
-							// Add the new client to the clients list, assign a paddle number and send it to the client
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| Accepting new client " << (*clientTcpSocket).getRemoteAddress() << " at " << "port " << (*clientTcpSocket).getRemotePort()
-								<< std::endl;							
-
-							Client newClient;
-							newClient.tcpSocket = clientTcpSocket;
-							newClient.paddle = assignedPaddle;
-							newClient.lastPosition = Vec2(0, 0);
-							newClient.ready = false;
-							newClient.portBallPos = 0;
-							newClient.lastMsgTimestamp = 0;
-							clients.push_back(newClient);
-
-							// Add the new client to the selector so that we will
-							// be notified when it sends something
-							selector.add(*clientTcpSocket);
-
-							// Send paddle number to client							
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| Sending paddle assignment " << assignedPaddle
-								<< " to " << (*clientTcpSocket).getRemoteAddress() << " at " << "port " << (*clientTcpSocket).getRemotePort()
-								<< std::endl;
+			logEndTicks = MonotonicMilliseconds();
+			logDt = (logEndTicks - logStartTicks);
 
-							packet.clear();
-							packet << assignedPaddle;
-							if ((*clientTcpSocket).send(packet) != sf::Socket::Done)
-							{
-								std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-									<< "\t| tcp socket send error"
-									<< std::endl;
-							}
-							
-							// Increase paddle number for next client that connects
-							assignedPaddle++;
-						}
-						else
-						{
-							// Error, we won't get a new connection, delete the socket
-							delete clientTcpSocket;
-						}
-					}
-					// Receive ball position socket port number from client after connection has been accepted,
-					// or handle disconnection if client disconnects before game starts
-					else
-					{
-						std::list<Client>::iterator it;
-						for (it = clients.begin(); it != clients.end();)
-						{
-							if (!(*it).ready) // if client player has not yet entered to confirm ready and to send ball position socket port number
-							{
-								sf::TcpSocket& client = *(*it).tcpSocket;
-								if (selector.isReady(client))
-								{									
-									packet.clear();
-									if (client.receive(packet) == sf::Socket::Disconnected)
-									{										
-										std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-											<< "\t| Client disconnected: " << client.getRemoteAddress() << " at " << "port " << client.getRemotePort()
-											<< std::endl;
-										
-										// Remove tcp socker for disconnected client from selector
-										selector.remove(client);
-
-										// If client previously confirmed ready, then decrease count of ready players
-										if ((*it).ready)
-										{
-											playersReady--;
-										}
-										
-										// Decrement paddle count to correctly assign when a new client connects
-										assignedPaddle--;
-
-										// Erase client from client list
-										it = clients.erase(it);
-									}
-									else 
-									{																														
-										// Get client's ball position socket port number
-										packet >> playerReadyMsg;
-
-										std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-											<< "\t| Client " << client.getRemoteAddress() << " at " << "port " << client.getRemotePort()
-											<< " sent ball position socket port number (" << playerReadyMsg << ")"
-											<< std::endl;
-
-										// Set port number and ready status for client
-										(*it).portBallPos = playerReadyMsg;
-										(*it).ready = true;
-										playersReady++;
-										
-										++it;
-									}
-								}
-								else
-								{
-									++it;
-								}
-							}
-							else
-							{
-								++it;
-							}
-						}
-					}
-				}
-			}
-			else
-			{								
-				// Poll for escape key or SQL_QUIT event
-				SDL_Event event;
-				while (SDL_PollEvent(&event))
+			// Handle the sockets that became ready. The udp socket is drained every iteration below
+			departedSessions.clear();
+			for (void* context : readyContexts)
+			{
+				if (context == &listener)
 				{
-					if (event.type == SDL_QUIT)
-					{
-						running = false;
-					}
-					else if (event.type == SDL_KEYDOWN)
+					// The listener is ready: accept every pending connection
+					std::unique_ptr<ReactorTcpSocket> clientTcpSocket(new ReactorTcpSocket);
+					while (listener.accept(*clientTcpSocket) == sf::Socket::Done)
 					{
-						if (event.key.keysym.sym == SDLK_ESCAPE)
+						LOG_INFO(LogCategory::Network) << "Accepting new client " << (*clientTcpSocket).getRemoteAddress().toString() << " at " << "port " << (*clientTcpSocket).getRemotePort();
+
+						if (clientTable.IsFull())
 						{
-							running = false;
+							LOG_WARNING(LogCategory::Network) << "Turning the client away, " << clientTable.Size() << " clients are connected";
+							(*clientTcpSocket).disconnect();
+							continue;
 						}
-					}
-				}
 
-				// For each paddle, predict its position based on previously received messages
-				// then use interpolation to move to a position between the current and predicted
-				for (Client& c : clients)
-				{
-					if (c.paddle == 1)
-					{
-						// Predict position of paddle one based on previous messages
-						msgBasedPrediction = paddleOne.RunPrediction(static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0), false);
-
-						// If prediction is different to previous, add to history
-						numPredictions = paddleOne.paddlePredictions.size();
-						if (numPredictions > 0)
+						// Place the new client in a match that is waiting for players, or create a new one
+						Match* match = NULL;
+						for (Match& m : matches)
 						{
-							if (msgBasedPrediction.y != paddleOne.paddlePredictions[numPredictions - 1].y)
+							if (m.IsWaitingForPlayers())
 							{
-								paddleOne.AddPrediction(msgBasedPrediction);
+								match = &m;
+								break;
 							}
 						}
-						else
-						{
-							paddleOne.AddPrediction(msgBasedPrediction);
-						}
-
-						// Predict position of paddle one based on previous predictions and add to history
-						predictionBasedPrediction = paddleOne.RunPrediction(static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0), true);
-						paddleOne.AddPrediction(predictionBasedPrediction);
-
-						// Get average of messages-based and predictions-based predicted positions and move a percentage towards it
-						averagePrediction = (msgBasedPrediction.y + predictionBasedPrediction.y) / 2.0;
 
-						if (logDt > logRate)
+						if (match == NULL)
 						{
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| Predicted position of paddle one: "
-								<< "message-based prediction y = " << msgBasedPrediction.y << "; "
-								<< "prediction-based prediction y = " << predictionBasedPrediction.y << "; "
-								<< std::endl;
+							matches.emplace_back(nextMatchId++, globalTime);
+							match = &matches.back();
+							(*match).rewindTicks = rewindTicks;
+							(*match).extraBallCount = ballCount - 1;
+							(*match).lockstep = lockstep;
+							(*match).livenessTimeout = livenessTimeout;
+							(*match).tickRate = scheduler.TickRate();
+							(*match).clientBudget = clientBudgetKbps * 1000.0 / 8.0;
+
+							LOG_INFO(LogCategory::Match) << "Created match " << (*match).id << " (" << matches.size() << " matches)";
 						}
 
-						paddleOne.position.y = averagePrediction;
-					}
-					else
-					{
-						// Predict position of paddle two based on previous messages
-						msgBasedPrediction = paddleTwo.RunPrediction(static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0), false);
+						// Client sockets are non-blocking so they can be read until empty when the reactor reports them.
+						// The client is given a session ID, which it learns with its paddle
+						(*clientTcpSocket).setBlocking(false);
+						Client& client = (*match).AddClient(std::move(clientTcpSocket));
+						client.sessionId = clientTable.Add(match, &client);
+						(*match).SendAssignment(client);
 
-						// If prediction is different to previous, add to history
-						numPredictions = paddleTwo.paddlePredictions.size();
-						if (numPredictions > 0)
-						{
-							if (msgBasedPrediction.y != paddleTwo.paddlePredictions[numPredictions - 1].y)
-							{
-								paddleTwo.AddPrediction(msgBasedPrediction);
-							}
-						}
-						else
-						{
-							paddleTwo.AddPrediction(msgBasedPrediction);
-						}
+						// Add the new client to the reactor so that we will
+						// be notified when it disconnects
+						reactor.Add(*client.tcpSocket, &client);
 
-						// Predict position of paddle two based on previous predictions and add to history
-						predictionBasedPrediction = paddleTwo.RunPrediction(static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0), true);
-						paddleTwo.AddPrediction(predictionBasedPrediction);
-
-						// Get average of messages-based and predictions-based predicted positions and move a percentage towards it
-						averagePrediction = (msgBasedPrediction.y + predictionBasedPrediction.y) / 2.0;
-						
-						if (logDt > logRate)
-						{
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| Predicted position of paddle two: "
-								<< "message-based prediction y = " << msgBasedPrediction.y << "; "
-								<< "prediction-based prediction y = " << predictionBasedPrediction.y << "; "
-								<< std::endl;
-						}
-						
-						paddleTwo.position.y = averagePrediction;
+						clientTcpSocket.reset(new ReactorTcpSocket);
 					}
 				}
-
-				logEndTicks = SDL_GetTicks();
-				logDt = (logEndTicks - logStartTicks);
-				if (logDt > logRate)
+				else if (context != &socket)
 				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Receiving paddle position message..."
-						<< std::endl;
+					// Handle the disconnection of a client
+					Client& client = *static_cast<Client*>(context);
+					(*client.match).ReceiveTcp(client, reactor, departedSessions);
 				}
-				
-				// Receive position of paddles from clients
-				packet.clear();
-				if (socket.receive(packet, clientIp, clientPort) != sf::Socket::Done)
-				{
-					// error...
-					//std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						//<< "\t| udp socket receive error"
-						//<< std::endl;
-				}
-				else
-				{
-					if (packet.getDataSize() > 0)
-					{
-						packet >> msg;
-
-						if (logDt > logRate)
-						{
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| Received message from " << clientIp << " on port " << clientPort
-								<< std::endl;
-
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| Timestamp=" << msg.timestamp
-								<< "; Port=" << msg.port
-								<< "; x=" << msg.x << "; y=" << msg.y
-								<< std::endl;
-						}
+			}
 
-						// Send paddle positions between clients
-						// Update clients' last positions
-						// Update paddle positions with latest received message		
-						for (Client& c : clients)
-						{
-							// Send packet containing position information of one client to the other
-							if (msg.port != (*c.tcpSocket).getRemotePort())
-							{
-								if (logDt > logRate)
-								{
-									std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-										<< "\t| Sending message: Timestamp=" << msg.timestamp
-										<< "; Port=" << msg.port
-										<< "; x=" << msg.x << "; y=" << msg.y
-										<< std::endl;
-								}
-
-								if (socket.send(packet, (*c.tcpSocket).getRemoteAddress(), (*c.tcpSocket).getRemotePort()) != sf::Socket::Done)
-								{
-									std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-										<< "\t| udp socket send error"
-										<< std::endl;
-								}
-							}
-							// Update last position of each paddle
-							else
-							{																
-								c.lastPosition = Vec2(msg.x, msg.y);
-								//c.lastMsgTimestamp = msg.timestamp;
-
-								// Update paddle positions with last known (required for collision detection) and add to message list for use in prediction
-								if (c.paddle == 1)
-								{
-									if (msg.timestamp > newestPaddleOnePosTimestamp)
-									{
-										newestPaddleOnePosTimestamp = msg.timestamp;
-										msg.timestamp = static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0); // change timestamp to this server's time
-										c.lastMsgTimestamp = msg.timestamp;
-
-										paddleOne.AddMessage(msg);
-
-										if (logDt > logRate)
-										{
-											std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-												<< "\t| Updating position of paddle one based on message and interpolation: y=" << interpolatedPosition
-												<< std::endl;
-										}
-
-										paddleOne.position.y = c.lastPosition.y;
-									}
-								}
-								else
-								{
-									if (msg.timestamp > newestPaddleTwoPosTimestamp)
-									{
-										newestPaddleTwoPosTimestamp = msg.timestamp;
-										msg.timestamp = static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0); // change timestamp to this server's time
-										c.lastMsgTimestamp = msg.timestamp;
-
-										paddleTwo.AddMessage(msg);
-
-										if (logDt > logRate)
-										{
-											std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-												<< "\t| Updating position of paddle two based on message and interpolation: y=" << interpolatedPosition
-												<< std::endl;
-										}
-
-										paddleTwo.position.y = c.lastPosition.y;
-									}
-								}
-							}
-						}
-					}
-				}
+			for (uint64_t departed : departedSessions)
+			{
+				clientTable.Remove(departed);
+			}
 
-				if (logDt > logRate)
+			// If both clients have said hello over udp, start the match
+			for (Match& m : matches)
+			{
+				if (m.IsReadyToStart())
 				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Updating the ball position"
-						<< std::endl;
+					m.Start();
 				}
+			}
 
-				ball.Update(dt); // Update the ball position based on frame time and velocity
+			if (logDt > logRate)
+			{
+				LOG_DEBUG(LogCategory::Input) << "Receiving input command messages...";
+			}
 
-				// Send ball position to clients
-				sendEndTicks = SDL_GetTicks();
-				sendDt = (sendEndTicks - sendStartTicks);
-				if (sendDt > sendRate)
+			// Receive all pending input commands from clients, a batch at a time, and pass them to their match
+			do
+			{
+				batchCount = batch.Receive();
+				batchTime = static_cast<uint32_t>(MonotonicMilliseconds() - globalTime);
+				for (int i = 0; i < batchCount; i++)
 				{
-					for (Client& c : clients)
+					if (batch.Size(i) == 0)
 					{
-						ballPacket.clear();
-						ballMsg.timestamp = static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0);
-						ballMsg.port = listenPort;
-						ballMsg.x = ball.position.x;
-						ballMsg.y = ball.position.y;
-						ballMsg.ball = true;
-						ballPacket << ballMsg;
-
-						if (logDt > logRate)
-						{
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| Sending ball position: Timestamp=" << ballMsg.timestamp
-								<< "; Port=" << ballMsg.port
-								<< "; x=" << ballMsg.x << "; y=" << ballMsg.y
-								<< "; ball=" << ballMsg.ball
-								<< std::endl;
-						}
-
-						if (socket.send(ballPacket, (*c.tcpSocket).getRemoteAddress(), c.portBallPos) != sf::Socket::Done)
-						{
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| udp socket send error"
-								<< std::endl;
-						}						
+						continue;
 					}
-					
-					// Reset send rate timer
-					sendStartTicks = SDL_GetTicks();
-				}				
-
-				// Collision checking
-				contact = {};
-
-				playerOnePrevScore = playerOneScore;
-				playerTwoPrevScore = playerTwoScore;
 
-				if (contact = CheckPaddleCollision(ball, paddleOne); contact.type != Ball::CollisionType::None)
-				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Paddle one collision detected"
-						<< std::endl;
-					
-					ball.CollideWithPaddle(contact);
-				}
-				else if (contact = CheckPaddleCollision(ball, paddleTwo); contact.type != Ball::CollisionType::None)
-				{
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| Paddle two collision detected"
-						<< std::endl;
-					
-					ball.CollideWithPaddle(contact);
-				}
-				else if (contact = CheckWallCollision(ball);
-					contact.type != Ball::CollisionType::None)
-				{
-					ball.CollideWithWall(contact);
+					packet.clear();
+					packet.append(batch.Data(i), batch.Size(i));
 
-					if (contact.type == Ball::CollisionType::Left)
+					// Answer clock requests with the server time they arrived and left, but only from a client at the endpoint
+					// it said hello from, so the server cannot be used to send responses to an address a request was forged with
+					if ((static_cast<uint8_t>(batch.Data(i)[0]) & 0x0F) == static_cast<uint8_t>(MessageType::ClockRequest))
 					{
-						++playerTwoScore;
-						
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| Left wall collision detected"
-							<< std::endl;
-					}
-					else if (contact.type == Ball::CollisionType::Right)
-					{
-						++playerOneScore;
+						if (ReadClockRequest(packet, sessionId, clockExchange.clientSendTime)
+							&& clientTable.FindByEndpoint(batch.Address(i), batch.Port(i), sessionId) != NULL)
+						{
+							clockExchange.serverReceiveTime = batchTime;
+							clockExchange.serverSendTime = static_cast<uint32_t>(MonotonicMilliseconds() - globalTime);
+							packet.clear();
+							WriteClockResponse(packet, clockExchange);
+							batch.Queue(packet, batch.Address(i), batch.Port(i));
+							clockResponsesQueued = true;
+						}
 
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| Right wall collision detected"
-							<< std::endl;
+						continue;
 					}
-				}
 
-				// If scores have changed, send to clients
-				scores.timestamp = static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0);
-				scores.playerOneScore = playerOneScore;
-				scores.playerTwoScore = playerTwoScore;
-
-				if (playerOnePrevScore != playerOneScore || playerTwoPrevScore != playerTwoScore)
-				{										
-					for (Client& c : clients)
+					// Everything else carries the session ID of the client it is from. The client table finds the session
+					// and checks the endpoint in constant time, however many clients are connected
+					// A hello ties the client's udp socket to its session and is answered with a welcome. Only a hello
+					// can move a session to another endpoint, and only with the ID its client was sent over tcp
+					if ((static_cast<uint8_t>(batch.Data(i)[0]) & 0x0F) == static_cast<uint8_t>(MessageType::Hello))
 					{
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| Sending scores to: "
-							<< (*c.tcpSocket).getRemoteAddress() << " at " << "port " << (*c.tcpSocket).getRemotePort()
-							<< "; PlayerOne=" << scores.playerOneScore << "; PlayerTwo=" << scores.playerTwoScore
-							<< std::endl;
-
-						packet.clear();
-						header = 1; // header 1 = score update
-						packet << header << scores;
-						if ((*c.tcpSocket).send(packet) != sf::Socket::Done)
+						if (ReadSessionMessage(packet, MessageType::Hello, sessionId))
 						{
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| tcp socket send error"
-								<< std::endl;
+							ClientSession* session = clientTable.Bind(sessionId, batch.Address(i), batch.Port(i));
+							if (session != NULL)
+							{
+								(*(*session).match).ReceiveHello(*(*session).client);
+								packet.clear();
+								WriteSessionMessage(packet, MessageType::Welcome, sessionId);
+								batch.Queue(packet, batch.Address(i), batch.Port(i));
+							}
 						}
+
+						continue;
 					}
 
-					if (playerOneScore >= winningScore || playerTwoScore >= winningScore) // If either player has reached 11 points, determine winner
+					// Heartbeat echoes give the round trip of their client
+					if ((static_cast<uint8_t>(batch.Data(i)[0]) & 0x0F) == static_cast<uint8_t>(MessageType::HeartbeatEcho))
 					{
-						if (std::abs(playerOneScore - playerTwoScore) >= 2) // Player needs to win by at least two points
+						if (ReadHeartbeatEcho(packet, sessionId, heartbeatTime))
 						{
-							if (playerOneScore > playerTwoScore)
+							ClientSession* session = clientTable.FindByEndpoint(batch.Address(i), batch.Port(i), sessionId);
+							if (session != NULL)
 							{
-								winner = 1;
-							}
-							else
-							{
-								winner = 2;
+								(*(*session).match).ReceiveHeartbeatEcho(*(*session).client, heartbeatTime);
 							}
 						}
-					}
-				}
 
-				if (!winner)
-				{
-					// Client disconnection handling
+						continue;
+					}
 
-					for (Client& c : clients)
+					// Acknowledgements of control messages come from the same socket as input commands, and are
+					// taken by finished matches too, as they wait for their last control messages to be acknowledged
+					if ((static_cast<uint8_t>(batch.Data(i)[0]) & 0x0F) == static_cast<uint8_t>(MessageType::ControlAck))
 					{
-						if (selector.wait(sf::microseconds(1)))
+						if (ReadControlAck(packet, sessionId, controlAck))
 						{
-							if (selector.isReady(*c.tcpSocket))
+							ClientSession* session = clientTable.FindByEndpoint(batch.Address(i), batch.Port(i), sessionId);
+							if (session != NULL)
 							{
-								packet.clear();
-								if ((*c.tcpSocket).receive(packet) == sf::Socket::Disconnected) // client has disconnected
-								{
-									std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-										<< "\t| Client disconnected: "
-										<< (*c.tcpSocket).getRemoteAddress() << " at " << "port " << (*c.tcpSocket).getRemotePort()
-										<< std::endl;
-
-									// Set client to non-ready and remove its tcp socket from selector
-									c.ready = false;
-									selector.remove(*c.tcpSocket);
-									clientDisconnected = true;
-								}
+								(*(*session).match).ReceiveControlAck(*(*session).client, controlAck);
 							}
 						}
-						// If client disconnect status has not been received, check if it hasn't sent a message in 5 seconds or more
-						else if (c.lastMsgTimestamp + 5.0 <= static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0))
-						{
-							packet.clear();
-							if (c.lastMsgTimestamp != 0)
-							{
-								std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-									<< "\t| Previously active client has last timestamp that is at least 5 seconds old: "
-									<< (*c.tcpSocket).getRemoteAddress() << " at " << "port " << (*c.tcpSocket).getRemotePort()
-									<< std::endl;
 
-								// Set client to not ready, remove its tcp socket from selector, and disconnect it
-								c.ready = false;
-								selector.remove(*c.tcpSocket);
-								clientDisconnected = true;
-								(*c.tcpSocket).disconnect();
+						continue;
+					}
 
-							}
-						}
+					// Ignore anything that is not input commands in this protocol version
+					if (!ReadInputs(packet, sessionId, ackTick, inputs, inputCount))
+					{
+						continue;
 					}
 
-					// If a client has disconnected, notify other client and reset the game
-					if (clientDisconnected)
+					if (logDt > logRate)
 					{
-						for (Client& c : clients)
-						{
-							// If current client is still connected
-							if (c.ready)
-							{
-								// Search client list for other client
-								for (Client& c1 : clients)
-								{
-									// Other client is one whose port is different
-									if ((*c.tcpSocket).getRemotePort() != (*c1.tcpSocket).getRemotePort())
-									{
-										// If other client is disconnected, send message to connected client
-										if (!c1.ready)
-										{
-											std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-												<< "\t| Sending opponent disconnected message to: "
-												<< (*c.tcpSocket).getRemoteAddress() << " at " << "port " << (*c.tcpSocket).getRemotePort()
-												<< std::endl;
-
-											packet.clear();
-											header = 0;
-											packet << header << "opponent disconnected";
-											if ((*c.tcpSocket).send(packet) != sf::Socket::Done)
-											{
-												std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-													<< "\t| tcp socket send error"
-													<< std::endl;
-											}
-										}
-									}
-								}
-
-								std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-									<< "\t| Disconnecting still connected client: "
-									<< (*c.tcpSocket).getRemoteAddress() << " at " << "port " << (*c.tcpSocket).getRemotePort()
-									<< std::endl;
-
-								// Remove from selector and disconnect socket of still connected client
-								selector.remove(*c.tcpSocket);
-								(*c.tcpSocket).disconnect();
-							}
-						}
+						LOG_DEBUG(LogCategory::Input) << "Received message from " << batch.Address(i).toString() << " on port " << batch.Port(i);
 
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| Resetting the game due to client disconnection"
-							<< std::endl;
-
-						// Reset game	
-						clients.clear();
-						playerOneScore = 0;
-						playerTwoScore = 0;
-						playersReady = 0;
-						assignedPaddle = 1;
-						paddleOne.paddleMessages.clear();
-						paddleTwo.paddlePredictions.clear();
-						paddleOne.paddleMessages.clear();
-						paddleTwo.paddlePredictions.clear();
-						paddleOne.position = Vec2(50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
-						paddleTwo.position = Vec2(WINDOW_WIDTH - 50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
-						ball.position = Vec2((WINDOW_WIDTH / 2.0f) - (BALL_WIDTH / 2.0f), (WINDOW_HEIGHT / 2.0f) - (BALL_WIDTH / 2.0f));
-						ball.velocity = Vec2(BALL_SPEED, 0.0f);
-						clientDisconnected = false;
-						gameStarted = false;
-						sendStartTicks = SDL_GetTicks();
-						logStartTicks = SDL_GetTicks();
+						LOG_DEBUG(LogCategory::Input) << "Session=" << sessionId
+							<< "; Tick=" << ackTick
+							<< "; Commands=" << inputCount
+							<< "; Newest=" << (inputCount > 0 ? inputs[inputCount - 1].sequence : 0);
+					}
+
+					// The session ID in the message identifies the client, which must have said hello from the same endpoint
+					ClientSession* session = clientTable.FindByEndpoint(batch.Address(i), batch.Port(i), sessionId);
+					if (session != NULL && (*(*session).match).state == Match::State::Playing)
+					{
+						(*(*session).match).ReceiveInputs(*(*session).client, inputs, inputCount, ackTick, logDt > logRate);
 					}
 				}
-				else
-				{					
-					// Send number of winning paddle to clients
-					for (Client& c : clients)
+			} while (!batch.IsDrained());
+
+			// Send clock responses now rather than with the snapshots, so the time they leave is the time they carry
+			if (clockResponsesQueued)
+			{
+				batch.Flush();
+				clockResponsesQueued = false;
+			}
+
+			// Run the simulation of every match being played for every tick that is due since the last iteration
+			scheduler.Advance();
+			ticked = false;
+			while (scheduler.ShouldTick())
+			{
+				for (Match& m : matches)
+				{
+					if (m.state == Match::State::Playing)
 					{
-						std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-							<< "\t| Sending winner to: "
-							<< (*c.tcpSocket).getRemoteAddress() << " at " << "port " << (*c.tcpSocket).getRemotePort()
-							<< "; Winner is player " << winner
-							<< std::endl;
-
-						packet.clear();
-						header = 2; // header 2 = winner message
-						packet << header << winner;
-						if ((*c.tcpSocket).send(packet) != sf::Socket::Done)
-						{
-							std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-								<< "\t| tcp socket send error"
-								<< std::endl;
-						}
+						m.Tick(scheduler.TickDt(), logDt > logRate);
 					}
+				}
 
-					std::cout << static_cast<double>((SDL_GetTicks() - globalTime) / 1000.0)
-						<< "\t| We have a winner. Resetting the game"
-						<< std::endl;
+				ticked = true;
+			}
 
-					// Reset game	
-					for (Client& c : clients)
+			// Send the snapshot of the latest tick to clients. If several ticks ran to catch up only the last is sent,
+			// as it supersedes the others
+			if (ticked)
+			{
+				for (Match& m : matches)
+				{
+					if (m.state == Match::State::Playing)
 					{
-						selector.remove(*c.tcpSocket);
-						(*c.tcpSocket).disconnect();
+						m.SendSnapshot(batch, logDt > logRate);
 					}
-					clients.clear();
-					playerOneScore = 0;
-					playerTwoScore = 0;
-					playersReady = 0;
-					assignedPaddle = 1;
-					winner = 0;
-					paddleOne.paddleMessages.clear();
-					paddleTwo.paddlePredictions.clear();
-					paddleOne.paddleMessages.clear();
-					paddleTwo.paddlePredictions.clear();
-					paddleOne.position = Vec2(50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
-					paddleTwo.position = Vec2(WINDOW_WIDTH - 50.0f, (WINDOW_HEIGHT / 2.0f) - (PADDLE_HEIGHT / 2.0f));
-					ball.position = Vec2((WINDOW_WIDTH / 2.0f) - (BALL_WIDTH / 2.0f), (WINDOW_HEIGHT / 2.0f) - (BALL_WIDTH / 2.0f));
-					ball.velocity = Vec2(BALL_SPEED, 0.0f);
-					gameStarted = false;
-					sendStartTicks = SDL_GetTicks();
-					logStartTicks = SDL_GetTicks();
 				}
+			}
 
-				// Reset the log printing timer
-				if (logDt > logRate)
+			// If scores have changed check for a winner, queue the heartbeats that are due, and end matches with a winner
+			// or a client that has not been heard from for the liveness timeout. Then send the control messages that are new or due to be resent
+			for (Match& m : matches)
+			{
+				if (m.state == Match::State::Playing)
 				{
-					logStartTicks = SDL_GetTicks();
+					m.CheckWinner();
+					m.SendHeartbeats(batch);
+					m.UpdateSendRates(logDt > logRate);
+					m.CheckTimeouts();
 				}
 
-				endTicks = SDL_GetTicks();
-				dt = (endTicks - startTicks); //dt as fraction of a second				
+				m.SendControl(batch);
+			}
+
+			// Send the snapshots and control messages queued this iteration
+			batch.Flush();
+
+			// Remove matches that have ended once their last control messages are acknowledged, and lobbies that all
+			// clients have left. Finished matches waiting on acknowledgements keep the loop on the tick rate, so their
+			// control messages are resent on time
+			playing = false;
+			std::list<Match>::iterator it;
+			for (it = matches.begin(); it != matches.end();)
+			{
+				if ((*it).IsClosable()
+					|| ((*it).state == Match::State::Lobby && (*it).clients.empty()))
+				{
+					for (const Client& c : (*it).clients)
+					{
+						clientTable.Remove(c.sessionId);
+					}
+
+					LOG_INFO(LogCategory::Match) << "Removing match " << (*it).id;
+
+					(*it).Close(reactor);
+					it = matches.erase(it);
+				}
+				else
+				{
+					playing = playing || (*it).state != Match::State::Lobby;
+					++it;
+				}
+			}
+
+			if (logDt > logRate)
+			{
+				const DatagramBatch::Stats& stats = batch.GetStats();
+				LOG_DEBUG(LogCategory::Network) << "udp batches: received " << stats.datagramsReceived << " datagrams in " << stats.receiveCalls << " calls"
+					<< " (largest batch " << stats.largestReceiveBatch << "); sent " << stats.datagramsSent << " datagrams in " << stats.sendCalls << " calls"
+					<< " (largest batch " << stats.largestSendBatch << ", " << stats.sendErrors << " errors)";
+			}
+
+			// Reset the log printing timer
+			if (logDt > logRate)
+			{
+				logStartTicks = MonotonicMilliseconds();
 			}
 		}
 	}
 
 	// Cleanup
-	SDL_Quit();
+	for (Match& m : matches)
+	{
+		m.Close(reactor);
+	}
+
+	Logger::Instance().Stop();
 
 	return 0;
 }
\ No newline at end of file